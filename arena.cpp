@@ -0,0 +1,42 @@
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include "arena.h"
+
+
+MonotonicArena::MonotonicArena() : current_block(nullptr), block_free_size(0), memory_size(0) {}
+
+
+void *MonotonicArena::allocate(size_t size, size_t alignment) {
+    // Large requests get their own blocks, so they do not waste rest of current block
+    if (size > BLOCK_SIZE / 4) {
+        blocks.emplace_back(new char[size]);
+        memory_size += size;
+        return blocks.back().get();
+    }
+
+    size_t offset = BLOCK_SIZE - block_free_size;
+    size_t padding = (alignment - offset % alignment) % alignment;
+    if (!current_block || padding + size > block_free_size) {
+        blocks.emplace_back(new char[BLOCK_SIZE]);
+        memory_size += BLOCK_SIZE;
+        current_block = blocks.back().get();
+        block_free_size = BLOCK_SIZE;
+        offset = 0;
+        padding = 0;
+    }
+    block_free_size -= padding + size;
+    return current_block + offset + padding;
+}
+
+
+size_t MonotonicArena::getMemorySize() const {
+    return memory_size;
+}
+
+
+size_t MonotonicArena::getBlockCount() const {
+    return blocks.size();
+}
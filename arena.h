@@ -0,0 +1,50 @@
+#ifndef ARENA_H_INCLUDED
+#define ARENA_H_INCLUDED
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <cstddef>
+
+
+// Memory for objects living as long as arena: requests are cut one after another from large blocks
+// and nothing is freed separately, all blocks are freed at once by destructor.
+// Objects are never destroyed, so only trivially destructible ones may be placed. Not thread-safe
+class MonotonicArena
+{
+    static const size_t BLOCK_SIZE = 1 << 16;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *current_block;
+    size_t block_free_size;
+    size_t memory_size;
+public:
+    MonotonicArena();
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena &operator=(const MonotonicArena&) = delete;
+
+    // Alignment should be a power of two not greater than alignment of std::max_align_t
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Copies of objects of range placed one after another
+    template <typename ValueType>
+    ValueType *copy(const ValueType *begin, const ValueType *end);
+
+    // Size of blocks allocated so far
+    size_t getMemorySize() const;
+    size_t getBlockCount() const;
+};
+
+
+
+template <typename ValueType>
+ValueType *MonotonicArena::copy(const ValueType *begin, const ValueType *end) {
+    static_assert(std::is_trivially_destructible<ValueType>::value, "Objects in arena are never destroyed");
+    auto *copied = static_cast<ValueType*>(allocate(sizeof(ValueType) * static_cast<size_t>(end - begin), alignof(ValueType)));
+    std::uninitialized_copy(begin, end, copied);
+    return copied;
+}
+
+
+#endif // ARENA_H_INCLUDED
@@ -0,0 +1,57 @@
+#include <string>
+#include <sstream>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+
+
+// Column A of numbers, column B of formulas over prefixes of column A of given length:
+// either aggregates or sums of references, e.g. =SUM(A1:A3) or =A1+A2+A3
+std::string makeTotalsSheet(int height, int range_length, bool is_aggregate) {
+    std::mt19937 generator(42);
+    std::ostringstream sheet_stream;
+    sheet_stream << height << '\t' << 2 << '\n';
+    for (int row_index = 0; row_index < height; ++row_index) {
+        sheet_stream << generator() % 1000 << '\t';
+        int last_row = (range_length > 0 ? range_length : row_index + 1);
+        if (is_aggregate) {
+            sheet_stream << "=SUM(A1:A" << last_row << ")";
+        } else {
+            sheet_stream << "=A1";
+            for (int row = 2; row <= last_row; ++row) {
+                sheet_stream << "+A" << row;
+            }
+        }
+        sheet_stream << '\n';
+    }
+    return sheet_stream.str();
+}
+
+
+void benchmarkSheet(Benchmark &benchmark, const std::string &case_name, const std::string &raw_sheet) {
+    std::istringstream in_stream(raw_sheet);
+    InputBuffer input(in_stream);
+    benchmark.run(case_name, 3, [&]() {
+        auto table = readParsedTable(input);
+        calculateParsedTable(table);
+        doNotOptimize(table);
+    });
+}
+
+
+int main()
+{
+    Benchmark benchmark("Aggregates: readParsedTable and calculateParsedTable");
+
+    benchmarkSheet(benchmark, "10000 sums of 1000 references", makeTotalsSheet(10000, 1000, false));
+    benchmarkSheet(benchmark, "10000 SUM of 1000 cells", makeTotalsSheet(10000, 1000, true));
+    benchmarkSheet(benchmark, "100000 SUM of 100000 cells", makeTotalsSheet(100000, 100000, true));
+    benchmarkSheet(benchmark, "100000 running totals by SUM", makeTotalsSheet(100000, 0, true));
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <iostream>
+
+#include "benchmark.h"
+#include "coordinate.h"
+#include "expression.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "thread_pool.h"
+
+
+using LexemVector = std::vector<std::shared_ptr<LexemBase>>;
+
+
+// Every cell of column refers to the next one, the last cell is a number
+ExpressionTable makeChainTable(int length) {
+    ExpressionTable table(length, 1);
+    for (int row_index = 0; row_index + 1 < length; ++row_index) {
+        table(row_index, 0) = Expression(ExpressionType::ARITHMETIC, LexemVector{
+            std::make_shared<LexemCellReference>(Coordinate2D(row_index + 1, 0)),
+            std::make_shared<LexemOperation>(Operation::ADD),
+            std::make_shared<LexemNumber>(1),
+        });
+    }
+    table(length - 1, 0) = parseExpression("1");
+    return table;
+}
+
+
+// The first cell sums all numbers of the second column
+ExpressionTable makeFanInTable(int width) {
+    ExpressionTable table(width, 2);
+    Expression sum(ExpressionType::ARITHMETIC);
+    for (int row_index = 0; row_index < width; ++row_index) {
+        if (row_index > 0) {
+            sum.pushLexem(std::make_shared<LexemOperation>(Operation::ADD));
+        }
+        sum.pushLexem(std::make_shared<LexemCellReference>(Coordinate2D(row_index, 1)));
+        table(row_index, 1) = parseExpression("=1");
+    }
+    table(0, 0) = sum;
+    return table;
+}
+
+
+// Every cell refers to the first cell
+ExpressionTable makeFanOutTable(int width) {
+    ExpressionTable table(width, 1);
+    table(0, 0) = parseExpression("=7");
+    for (int row_index = 1; row_index < width; ++row_index) {
+        table(row_index, 0) = Expression(ExpressionType::ARITHMETIC, LexemVector{
+            std::make_shared<LexemCellReference>(Coordinate2D(0, 0)),
+            std::make_shared<LexemOperation>(Operation::MULTIPLY),
+            std::make_shared<LexemNumber>(2),
+        });
+    }
+    return table;
+}
+
+
+// Every cell refers to three random cells of previous rows
+ExpressionTable makeRandomDagTable(int height, int width) {
+    ExpressionTable table(height, width);
+    std::mt19937 generator(42);
+    for (int row_index = 0; row_index < height; ++row_index) {
+        for (int column_index = 0; column_index < width; ++column_index) {
+            if (row_index == 0) {
+                table(row_index, column_index) = parseExpression("=1");
+                continue;
+            }
+            std::uniform_int_distribution<int> row_distribution(0, row_index - 1);
+            std::uniform_int_distribution<int> column_distribution(0, width - 1);
+            Expression expression(ExpressionType::ARITHMETIC);
+            for (int reference_index = 0; reference_index < 3; ++reference_index) {
+                if (reference_index > 0) {
+                    expression.pushLexem(std::make_shared<LexemOperation>(Operation::ADD));
+                }
+                expression.pushLexem(std::make_shared<LexemCellReference>(
+                    Coordinate2D(row_distribution(generator), column_distribution(generator))
+                ));
+            }
+            table(row_index, column_index) = expression;
+        }
+    }
+    return table;
+}
+
+
+// Numbers in the first column, every other cell adds one to number of its row
+ExpressionTable makeOneColumnReferredTable(int height, int width) {
+    ExpressionTable table(height, width);
+    for (int row_index = 0; row_index < height; ++row_index) {
+        table(row_index, 0) = parseExpression(std::to_string(row_index));
+        for (int column_index = 1; column_index < width; ++column_index) {
+            table(row_index, column_index) = Expression(ExpressionType::ARITHMETIC, LexemVector{
+                std::make_shared<LexemCellReference>(Coordinate2D(row_index, 0)),
+                std::make_shared<LexemOperation>(Operation::ADD),
+                std::make_shared<LexemNumber>(1),
+            });
+        }
+    }
+    return table;
+}
+
+
+// Memory of table and peak memory taken by its calculation beyond it, e.g. by cached values of referred columns
+void measureCalculationMemory(const std::string &case_name, int height, int width) {
+    size_t memory_size_before = getResidentMemorySize();
+    auto table = makeOneColumnReferredTable(height, width);
+    size_t memory_size_after = getResidentMemorySize();
+    std::cout << "Memory of " << case_name << ": ";
+    std::cout << (memory_size_after - memory_size_before) / (1 << 20) << " MiB" << std::endl;
+
+    size_t peak_memory_size_before = std::max(getPeakResidentMemorySize(), memory_size_after);
+    ThreadPool thread_pool(1);
+    calculateParsedTable(table, thread_pool);
+    size_t peak_memory_size_after = getPeakResidentMemorySize();
+    std::cout << "Peak memory of calculation of " << case_name << " beyond table: ";
+    std::cout << (peak_memory_size_after - std::min(peak_memory_size_before, peak_memory_size_after)) / (1 << 20) << " MiB" << std::endl;
+}
+
+
+void benchmarkCalculation(
+    Benchmark &benchmark, const std::string &case_name, const ExpressionTable &table, int thread_count = 1
+) {
+    const int repetitions = 3;
+    std::vector<ExpressionTable> tables(repetitions, table);
+    size_t next_table_index = 0;
+    ThreadPool thread_pool(thread_count);
+    benchmark.run(case_name, repetitions, [&]() {
+        calculateParsedTable(tables[next_table_index++], thread_pool);
+    });
+}
+
+
+int main()
+{
+    // Memory is measured first, while freed memory cannot be reused yet.
+    // Results stay in expressions of table; values are cached only for the referred column
+    measureCalculationMemory("200000x10 table referring to one column", 200000, 10);
+
+    Benchmark benchmark("calculateParsedTable");
+
+    benchmarkCalculation(benchmark, "chain of 1000000 references", makeChainTable(1000000));
+    benchmarkCalculation(benchmark, "one cell referring to 100000 cells", makeFanInTable(100000));
+    benchmarkCalculation(benchmark, "100000 cells referring to one cell", makeFanOutTable(100000));
+    benchmarkCalculation(benchmark, "1000x100 random DAG with 3 references per cell", makeRandomDagTable(1000, 100));
+
+    Benchmark scaling_benchmark("calculateParsedTable scaling");
+    auto large_table = makeRandomDagTable(1000, 500);
+    for (int thread_count : {1, 2, 4, 8}) {
+        std::string case_name = "1000x500 random DAG on " + std::to_string(thread_count) + " threads";
+        benchmarkCalculation(scaling_benchmark, case_name, large_table, thread_count);
+    }
+
+    return 0;
+}
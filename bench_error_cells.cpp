@@ -0,0 +1,78 @@
+#include <string>
+#include <sstream>
+#include <random>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+
+
+// Sheet where half of cells become errors: malformed cells, division by zero and references to errors
+std::string makeErrorSheet(int height, int width) {
+    std::mt19937 generator(42);
+    std::ostringstream sheet_stream;
+    sheet_stream << height << '\t' << width << '\n';
+    for (int row_index = 0; row_index < height; ++row_index) {
+        for (int column_index = 0; column_index < width; ++column_index) {
+            switch (generator() % 8) {
+            case 0:
+                sheet_stream << generator() % 1000 << "x";
+                break;
+            case 1:
+                sheet_stream << "=A0+" << generator() % 1000;
+                break;
+            case 2:
+                sheet_stream << "=" << generator() % 1000 << "/0";
+                break;
+            case 3:
+                // Refers to the previous cell of row, which is error in half of cases
+                sheet_stream << "=" << (column_index > 0 ? static_cast<char>('A' + (column_index - 1) % 26) : 'A') << "1+1";
+                break;
+            default:
+                sheet_stream << "=" << generator() % 1000 << "+" << generator() % 1000;
+                break;
+            }
+            sheet_stream << (column_index + 1 == width ? '\n' : '\t');
+        }
+    }
+    return sheet_stream.str();
+}
+
+
+int main()
+{
+    Benchmark benchmark("Error cells");
+
+    auto raw_sheet = makeErrorSheet(1000, 1000);
+    std::string sheet_name = "1000x1000 sheet with half of cells being errors";
+    std::istringstream in_stream(raw_sheet);
+    InputBuffer input(in_stream);
+
+    benchmark.run("readParsedTable of " + sheet_name, 3, [&]() {
+        doNotOptimize(readParsedTable(input));
+    });
+
+    const int repetitions = 3;
+    std::vector<ExpressionTable> tables(repetitions, readParsedTable(input));
+    size_t next_table_index = 0;
+    benchmark.run("calculateParsedTable of " + sheet_name, repetitions, [&]() {
+        calculateParsedTable(tables[next_table_index++]);
+    });
+
+    benchmark.run("printExpressionTable of " + sheet_name, 3, [&]() {
+        int null_descriptor = open("/dev/null", O_WRONLY);
+        {
+            OutputBuffer output(null_descriptor);
+            printExpressionTable(tables[0], output);
+        }
+        close(null_descriptor);
+    });
+
+    return 0;
+}
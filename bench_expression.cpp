@@ -0,0 +1,162 @@
+#include <vector>
+#include <string>
+#include <random>
+#include <utility>
+
+#include "benchmark.h"
+#include "expression.h"
+
+
+// Formulas of numbers and operations with given number of operands, pairs of operands may be parenthesized
+std::vector<std::string> makeFormulas(int formula_count, int operand_count, bool has_parentheses = false) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> number_distribution(1, 1000);
+    const std::string operations = "+-*/";
+
+    std::vector<std::string> formulas;
+    for (int formula_index = 0; formula_index < formula_count; ++formula_index) {
+        std::string formula = "=";
+        for (int operand_index = 0; operand_index < operand_count; ++operand_index) {
+            if (operand_index > 0) {
+                formula.push_back(operations[generator() % operations.size()]);
+            }
+            bool is_parenthesized = (has_parentheses && operand_index + 1 < operand_count && operand_index % 2 == 0);
+            if (is_parenthesized) {
+                formula.push_back('(');
+            }
+            formula += std::to_string(number_distribution(generator));
+            if (is_parenthesized) {
+                formula.push_back(operations[generator() % operations.size()]);
+                formula += std::to_string(number_distribution(generator)) + ")";
+                ++operand_index;
+            }
+        }
+        formulas.push_back(formula);
+    }
+    return formulas;
+}
+
+
+// Formulas of 5 operands referring to cells of the same row, each copied down a column of given height,
+// so column of formula cells shares one compiled formula
+std::vector<std::pair<std::string, Coordinate2D>> makeCopiedFormulas(int formula_count, int height) {
+    std::mt19937 generator(42);
+    const std::string operations = "+-*";
+    const int operand_count = 5;
+
+    std::vector<std::pair<std::string, Coordinate2D>> formulas;
+    for (int column_index = 0; static_cast<int>(formulas.size()) < formula_count; ++column_index) {
+        std::vector<std::pair<char, char>> shape;
+        for (int operand_index = 0; operand_index < operand_count; ++operand_index) {
+            shape.emplace_back(static_cast<char>('A' + generator() % 26), operations[generator() % operations.size()]);
+        }
+        for (int row_index = 0; row_index < height && static_cast<int>(formulas.size()) < formula_count; ++row_index) {
+            std::string formula = "=";
+            for (size_t operand_index = 0; operand_index < shape.size(); ++operand_index) {
+                if (operand_index > 0) {
+                    formula.push_back(shape[operand_index].second);
+                }
+                formula.push_back(shape[operand_index].first);
+                formula += std::to_string(row_index + 1);
+            }
+            formulas.emplace_back(formula, Coordinate2D{row_index, 26 + column_index});
+        }
+    }
+    return formulas;
+}
+
+
+// A1-style names of random cells of table with given size
+std::vector<std::string> makeReferences(int reference_count, int height, int width) {
+    std::mt19937 generator(42);
+    std::vector<std::string> references;
+    for (int reference_index = 0; reference_index < reference_count; ++reference_index) {
+        int column_number = static_cast<int>(generator() % static_cast<unsigned>(width)) + 1;
+        std::string column_name;
+        for (; column_number > 0; column_number = (column_number - 1) / 26) {
+            column_name.insert(column_name.begin(), static_cast<char>('A' + (column_number - 1) % 26));
+        }
+        references.push_back(column_name + std::to_string(generator() % static_cast<unsigned>(height) + 1));
+    }
+    return references;
+}
+
+
+int main()
+{
+    Benchmark benchmark("parseExpression and tryCalculateArithmeticExpression");
+
+    for (const auto &shape : {std::make_pair(1, false), std::make_pair(5, false), std::make_pair(50, false), std::make_pair(50, true)}) {
+        const int formula_count = 200000;
+        int operand_count = shape.first;
+        auto formulas = makeFormulas(formula_count, operand_count, shape.second);
+        std::vector<Expression> expressions(formulas.size());
+        std::string size_name =
+            std::to_string(formula_count) + " formulas of " + std::to_string(operand_count) + " operands"
+            + (shape.second ? " with parentheses" : "");
+
+        benchmark.run("parse " + size_name, 3, [&]() {
+            for (size_t formula_index = 0; formula_index < formulas.size(); ++formula_index) {
+                expressions[formula_index] = parseExpression(formulas[formula_index]);
+            }
+        });
+
+        benchmark.run("calculate " + size_name, 3, [&]() {
+            long long sum = 0;
+            for (const auto &expression : expressions) {
+                Result<Number> value = tryCalculateArithmeticExpression(expression);
+                // Division by zero is skipped
+                if (value.isOk()) {
+                    sum += value.getValue();
+                }
+            }
+            doNotOptimize(sum);
+        });
+    }
+
+    {
+        const int formula_count = 200000;
+        const int height = 1000;
+        auto formulas = makeCopiedFormulas(formula_count, height);
+        std::vector<Expression> expressions(formulas.size());
+        std::string size_name =
+            std::to_string(formula_count) + " formulas of 5 references copied down columns of " + std::to_string(height);
+
+        benchmark.run("parse " + size_name, 3, [&]() {
+            for (size_t formula_index = 0; formula_index < formulas.size(); ++formula_index) {
+                expressions[formula_index] = parseExpression(formulas[formula_index].first, formulas[formula_index].second);
+            }
+        });
+
+        benchmark.run("calculate " + size_name, 3, [&]() {
+            long long sum = 0;
+            for (const auto &expression : expressions) {
+                sum += tryCalculateArithmeticExpression(expression, [](const Token &token) -> Result<Number> {
+                    return token.coordinate.row + token.coordinate.column;
+                }).getValue();
+            }
+            doNotOptimize(sum);
+        });
+    }
+
+    Benchmark reference_benchmark("tryParseCoordinate");
+
+    for (const auto &size : {std::make_pair(9, 26), std::make_pair(1000000, 16384)}) {
+        const int reference_count = 5000000;
+        auto references = makeReferences(reference_count, size.first, size.second);
+        std::string case_name =
+            std::to_string(reference_count) + " references to "
+            + std::to_string(size.first) + "x" + std::to_string(size.second) + " table";
+
+        reference_benchmark.run(case_name, 3, [&]() {
+            long long sum = 0;
+            for (const auto &reference : references) {
+                Result<Coordinate2D> coordinate = tryParseCoordinate(reference);
+                sum += coordinate.getValue().row + coordinate.getValue().column;
+            }
+            doNotOptimize(sum);
+        });
+    }
+
+    return 0;
+}
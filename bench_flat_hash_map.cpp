@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <random>
+#include <string>
+#include <functional>
+
+#include "benchmark.h"
+#include "coordinate.h"
+#include "flat_hash_map.h"
+#include "flat_hash_map.cpp"
+
+
+// Former Coordinate2DHash, which hashed row twice, so all cells of a row collided
+struct RowOnlyCoordinate2DHash
+{
+    size_t operator()(const Coordinate2D &coordinate) const {
+        return std::hash<int>()(coordinate.row) ^ (std::hash<int>()(coordinate.row) << 16);
+    }
+};
+
+
+// Containers are used as sets of visited cells: insert with check of presence and lookup
+struct SetOfStdSet
+{
+    std::set<Coordinate2D> cells;
+
+    bool insert(const Coordinate2D &coordinate) {
+        return cells.insert(coordinate).second;
+    }
+
+    bool contains(const Coordinate2D &coordinate) const {
+        return cells.count(coordinate) > 0;
+    }
+};
+
+
+template <typename Hash>
+struct SetOfUnorderedMap
+{
+    std::unordered_map<Coordinate2D, bool, Hash> cells;
+
+    bool insert(const Coordinate2D &coordinate) {
+        return cells.emplace(coordinate, true).second;
+    }
+
+    bool contains(const Coordinate2D &coordinate) const {
+        return cells.count(coordinate) > 0;
+    }
+};
+
+
+struct SetOfFlatHashMap
+{
+    FlatHashMap<bool> cells;
+
+    bool insert(const Coordinate2D &coordinate) {
+        return cells.insert(coordinate, true);
+    }
+
+    bool contains(const Coordinate2D &coordinate) const {
+        return cells.contains(coordinate);
+    }
+};
+
+
+std::vector<Coordinate2D> makeShuffledGrid(int height, int width, int row_offset, unsigned seed) {
+    std::vector<Coordinate2D> coordinates;
+    for (int row = 0; row < height; ++row) {
+        for (int column = 0; column < width; ++column) {
+            coordinates.emplace_back(row + row_offset, column);
+        }
+    }
+    std::shuffle(coordinates.begin(), coordinates.end(), std::mt19937(seed));
+    return coordinates;
+}
+
+
+template <typename CellSet>
+void benchmarkCellSet(const std::string &set_name, int height, int width) {
+    Benchmark benchmark(set_name + ", " + std::to_string(height) + "x" + std::to_string(width) + " cells");
+
+    auto coordinates = makeShuffledGrid(height, width, 0, 42);
+    auto lookup_coordinates = makeShuffledGrid(height, width, 0, 7);
+    // Cells of rows below the grid are never inserted
+    auto absent_coordinates = makeShuffledGrid(height, width, height, 9);
+    double cell_count = static_cast<double>(coordinates.size());
+
+    benchmark.run("insert every cell twice", 3, cell_count, [&]() {
+        CellSet cells;
+        int inserted_count = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const auto &coordinate : coordinates) {
+                inserted_count += cells.insert(coordinate);
+            }
+        }
+        doNotOptimize(inserted_count);
+    });
+
+    CellSet cells;
+    for (const auto &coordinate : coordinates) {
+        cells.insert(coordinate);
+    }
+
+    benchmark.run("lookup of present cells", 5, cell_count, [&]() {
+        int found_count = 0;
+        for (const auto &coordinate : lookup_coordinates) {
+            found_count += cells.contains(coordinate);
+        }
+        doNotOptimize(found_count);
+    });
+
+    benchmark.run("lookup of absent cells", 5, cell_count, [&]() {
+        int found_count = 0;
+        for (const auto &coordinate : absent_coordinates) {
+            found_count += cells.contains(coordinate);
+        }
+        doNotOptimize(found_count);
+    });
+}
+
+
+int main()
+{
+    for (int size : {300, 1000}) {
+        benchmarkCellSet<SetOfStdSet>("std::set", size, size);
+        benchmarkCellSet<SetOfUnorderedMap<Coordinate2DHash>>("std::unordered_map", size, size);
+        benchmarkCellSet<SetOfFlatHashMap>("FlatHashMap", size, size);
+    }
+    // Collisions of the former hash make it quadratic, so only the smaller grid is measured
+    benchmarkCellSet<SetOfUnorderedMap<RowOnlyCoordinate2DHash>>("std::unordered_map with former row-only hash", 300, 300);
+
+    return 0;
+}
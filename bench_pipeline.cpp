@@ -0,0 +1,93 @@
+#include <string>
+#include <sstream>
+#include <vector>
+#include <stdexcept>
+
+#include "benchmark.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "sheet_generator.h"
+#include "stats.h"
+#include "logger.h"
+
+
+// Every stage of process_table on generated sheet, throughput is counted in filled cells.
+// Arguments are size of sheet and options of generator, see parseSheetOptions
+int main(int argc, char **argv)
+{
+    SheetOptions options;
+    try {
+        if (argc == 2 || (argc > 1 && std::string(argv[1]).compare(0, 2, "--") == 0)) {
+            throw std::invalid_argument("Usage: bench_pipeline [HEIGHT WIDTH [options of generate_sheet]]");
+        }
+        options = (argc > 2 ? parseSheetOptions(std::stoi(argv[1]), std::stoi(argv[2]), argc - 3, argv + 3) : SheetOptions());
+    } catch (const std::exception &exception) {
+        log_error(exception.what());
+        return EXIT_FAILURE;
+    }
+
+    const int repetitions = 5;
+    auto raw_sheet = generateRawSheet(options);
+    std::istringstream in_stream(raw_sheet);
+    InputBuffer input(in_stream);
+
+    auto text_table = readTextTable(input);
+    double cell_count = text_table.getElementCount();
+    auto parsed_table = parseRawTable(text_table);
+    auto calculated_table = parsed_table;
+    calculateParsedTable(calculated_table);
+    auto printed_table = makePrintedTable(calculated_table);
+
+    Benchmark benchmark(
+        "Pipeline on " + std::to_string(options.height) + "x" + std::to_string(options.width) + " sheet of "
+        + std::to_string(static_cast<long long>(cell_count)) + " cells, " + std::to_string(raw_sheet.size() >> 20) + " MiB"
+    );
+    // Allocations are counted by operator new replaced together with stats
+    if (enableStats()) {
+        benchmark.countAllocations([]() {
+            return getStatsCounter(StatsCounter::ALLOCATIONS);
+        });
+    }
+
+    benchmark.run("readTextTable", repetitions, cell_count, [&]() {
+        doNotOptimize(readTextTable(input));
+    });
+
+    benchmark.run("parseRawTable", repetitions, cell_count, [&]() {
+        doNotOptimize(parseRawTable(text_table));
+    });
+
+    benchmark.run("readParsedTable", repetitions, cell_count, [&]() {
+        doNotOptimize(readParsedTable(input));
+    });
+
+    // Calculation replaces formulas by values, so every run gets its own copy made in advance
+    std::vector<ExpressionTable> tables(repetitions, parsed_table);
+    benchmark.run("calculateParsedTable", repetitions, cell_count, [&]() {
+        calculateParsedTable(tables.back());
+        tables.pop_back();
+    });
+
+    benchmark.run("makePrintedTable", repetitions, cell_count, [&]() {
+        doNotOptimize(makePrintedTable(calculated_table));
+    });
+
+    benchmark.run("printTextTable", repetitions, cell_count, [&]() {
+        std::ostringstream out_stream;
+        printTextTable(printed_table, out_stream);
+        doNotOptimize(out_stream);
+    });
+
+    benchmark.run("printExpressionTable", repetitions, cell_count, [&]() {
+        std::ostringstream out_stream;
+        OutputBuffer output(out_stream);
+        printExpressionTable(calculated_table, output);
+        output.flush();
+        doNotOptimize(out_stream);
+    });
+
+    return 0;
+}
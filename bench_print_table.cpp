@@ -0,0 +1,57 @@
+#include <string>
+#include <fstream>
+#include <random>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+#include "expression.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "output_buffer.h"
+
+
+// Calculated sheet where every tenth cell is filled with number or text
+ExpressionTable makeSparseSheet(int height, int width) {
+    std::mt19937 generator(42);
+    ExpressionTable table(height, width);
+    for (int row_index = 0; row_index < height; ++row_index) {
+        for (int column_index = static_cast<int>(generator() % 10); column_index < width; column_index += 10) {
+            if (generator() % 4 == 0) {
+                table(row_index, column_index) = parseExpression("'Text");
+            } else {
+                Expression number(ExpressionType::ARITHMETIC);
+                number.pushToken(static_cast<int>(generator() % 2000000) - 1000000);
+                table(row_index, column_index) = number;
+            }
+        }
+    }
+    return table;
+}
+
+
+int main()
+{
+    Benchmark benchmark("Printing table");
+
+    auto sheet = makeSparseSheet(10000, 1000);
+    std::string size_name = "10000x1000 sheet of " + std::to_string(sheet.getElementCount()) + " cells";
+
+    benchmark.run("makePrintedTable and printTextTable of " + size_name, 3, [&]() {
+        std::ofstream null_stream("/dev/null");
+        printTextTable(makePrintedTable(sheet), null_stream);
+    });
+
+    benchmark.run("printExpressionTable of " + size_name, 3, [&]() {
+        int null_descriptor = open("/dev/null", O_WRONLY);
+        {
+            OutputBuffer output(null_descriptor);
+            printExpressionTable(sheet, output);
+        }
+        close(null_descriptor);
+    });
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <string>
+#include <sstream>
+
+#include "benchmark.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "thread_pool.h"
+#include "sheet_generator.h"
+
+
+int main()
+{
+    Benchmark benchmark("Reading table");
+
+    auto raw_sheet = generateRawSheet(1000, 1000);
+    std::string size_name = "1000x1000 sheet of " + std::to_string(raw_sheet.size() >> 20) + " MiB";
+
+    benchmark.run("readTextTable of " + size_name, 3, [&]() {
+        std::istringstream in_stream(raw_sheet);
+        doNotOptimize(readTextTable(in_stream));
+    });
+
+    benchmark.run("readTextTable and parseRawTable of " + size_name, 3, [&]() {
+        std::istringstream in_stream(raw_sheet);
+        doNotOptimize(parseRawTable(readTextTable(in_stream)));
+    });
+
+    benchmark.run("readParsedTable of " + size_name, 3, [&]() {
+        std::istringstream in_stream(raw_sheet);
+        InputBuffer input(in_stream);
+        doNotOptimize(readParsedTable(input));
+    });
+
+    Benchmark scaling_benchmark("Reading table scaling");
+    std::istringstream in_stream(raw_sheet);
+    InputBuffer input(in_stream);
+    for (int thread_count : {1, 2, 4, 8}) {
+        ThreadPool thread_pool(thread_count);
+        scaling_benchmark.run("readParsedTable of " + size_name + " on " + std::to_string(thread_count) + " threads", 3, [&]() {
+            doNotOptimize(readParsedTable(input, thread_pool));
+        });
+    }
+
+    return 0;
+}
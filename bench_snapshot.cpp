@@ -0,0 +1,56 @@
+#include <string>
+#include <sstream>
+
+#include "benchmark.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "snapshot.h"
+#include "sheet_generator.h"
+
+
+int main()
+{
+    Benchmark benchmark("Starting from text and from snapshot");
+
+    auto raw_sheet = generateRawSheet(1000, 1000);
+    std::istringstream in_stream(raw_sheet);
+    InputBuffer input(in_stream);
+
+    auto formulas = readParsedTable(input);
+    auto values = formulas;
+    calculateParsedTable(values);
+    std::ostringstream out_stream;
+    {
+        OutputBuffer output(out_stream);
+        saveSnapshot(formulas, values, output);
+    }
+    std::istringstream snapshot_stream(out_stream.str());
+    InputBuffer snapshot_input(snapshot_stream);
+
+    std::string size_name =
+        "1000x1000 sheet of " + std::to_string(raw_sheet.size() >> 20) + " MiB, snapshot of "
+        + std::to_string(out_stream.str().size() >> 20) + " MiB";
+
+    benchmark.run("readParsedTable and calculateParsedTable of " + size_name, 3, [&]() {
+        auto table = readParsedTable(input);
+        calculateParsedTable(table);
+        doNotOptimize(table);
+    });
+
+    benchmark.run("loadSnapshot of " + size_name, 3, [&]() {
+        doNotOptimize(loadSnapshot(snapshot_input));
+    });
+
+    benchmark.run("saveSnapshot of " + size_name, 3, [&]() {
+        std::ostringstream save_stream;
+        OutputBuffer output(save_stream);
+        saveSnapshot(formulas, values, output);
+        output.flush();
+        doNotOptimize(save_stream);
+    });
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <string>
+#include <iostream>
+#include <memory>
+
+#include "benchmark.h"
+#include "coordinate.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+
+
+struct SheetShape
+{
+    std::string name;
+    int height;
+    int width;
+    int element_count;
+};
+
+
+std::vector<Coordinate2D> makeCoordinates(const SheetShape &shape) {
+    std::vector<Coordinate2D> coordinates;
+    if (shape.element_count == shape.height * shape.width) {
+        for (int row = 0; row < shape.height; ++row) {
+            for (int column = 0; column < shape.width; ++column) {
+                coordinates.emplace_back(row, column);
+            }
+        }
+    } else {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> row_distribution(0, shape.height - 1);
+        std::uniform_int_distribution<int> column_distribution(0, shape.width - 1);
+        for (int index = 0; index < shape.element_count; ++index) {
+            coordinates.emplace_back(row_distribution(generator), column_distribution(generator));
+        }
+    }
+    return coordinates;
+}
+
+
+template <typename Table>
+void benchmarkStorage(const std::string &storage_name, const SheetShape &shape) {
+    Benchmark benchmark(storage_name + ", " + shape.name);
+
+    auto coordinates = makeCoordinates(shape);
+    auto lookup_coordinates = coordinates;
+    std::shuffle(lookup_coordinates.begin(), lookup_coordinates.end(), std::mt19937(7));
+
+    Table table(shape.height, shape.width);
+    table.reserve(shape.element_count);
+
+    benchmark.run("fill", 1, [&]() {
+        for (const auto &coordinate : coordinates) {
+            table(coordinate) = coordinate.row + coordinate.column;
+        }
+    });
+
+    benchmark.run("random lookup of filled cells", 5, [&]() {
+        const Table &const_table = table;
+        long long sum = 0;
+        for (const auto &coordinate : lookup_coordinates) {
+            sum += const_table(coordinate);
+        }
+        doNotOptimize(sum);
+    });
+
+    benchmark.run("getElements", 5, [&]() {
+        long long sum = 0;
+        for (const auto &cell_pair : table.getElements()) {
+            sum += cell_pair.second;
+        }
+        doNotOptimize(sum);
+    });
+
+    benchmark.run("flatten", 5, [&]() {
+        long long sum = 0;
+        for (const auto &row : table.flatten()) {
+            for (const auto &cell : row) {
+                sum += cell;
+            }
+        }
+        doNotOptimize(sum);
+    });
+}
+
+
+// Cell of the same size as Expression
+struct WideCell
+{
+    std::array<int64_t, 6> words;
+};
+
+
+// Filled table is returned to be kept alive, so memory of the next one is not taken from freed memory
+template <typename Table>
+std::shared_ptr<void> measureMemory(const std::string &storage_name, const SheetShape &shape) {
+    auto coordinates = makeCoordinates(shape);
+    size_t memory_size_before = getResidentMemorySize();
+    auto table = std::make_shared<Table>(shape.height, shape.width);
+    table->reserve(shape.element_count);
+    for (const auto &coordinate : coordinates) {
+        (*table)(coordinate).words[0] = coordinate.row + coordinate.column;
+    }
+    size_t memory_size_after = getResidentMemorySize();
+    std::cout << "Memory of " << storage_name << " with 48-byte cells, " << shape.name << ": ";
+    std::cout << (memory_size_after - memory_size_before) / (1 << 20) << " MiB" << std::endl;
+    return table;
+}
+
+
+int main()
+{
+    std::vector<SheetShape> shapes = {
+        {"dense 10000x100", 10000, 100, 10000 * 100},
+        // Most of cells of chunks of narrow table are empty
+        {"dense narrow 400000x5", 400000, 5, 400000 * 5},
+        {"sparse 100000x1000 with 1000000 cells", 100000, 1000, 1000000},
+    };
+
+    // Memory is measured first, while freed memory cannot be reused yet.
+    // ChunkedStorage is left out, as chunks covering sparse table take gigabytes
+    std::vector<std::shared_ptr<void>> measured_tables;
+    for (const auto &shape : shapes) {
+        measured_tables.push_back(measureMemory<SparseTable<WideCell, MapStorage<WideCell>>>("MapStorage", shape));
+        measured_tables.push_back(
+            measureMemory<SparseTable<WideCell, AdaptiveStorage<WideCell>>>("AdaptiveStorage", shape)
+        );
+    }
+    measured_tables.clear();
+
+    for (const auto &shape : shapes) {
+        benchmarkStorage<SparseTable<int, MapStorage<int>>>("MapStorage", shape);
+        benchmarkStorage<SparseTable<int, ChunkedStorage<int>>>("ChunkedStorage", shape);
+        benchmarkStorage<SparseTable<int, AdaptiveStorage<int>>>("AdaptiveStorage", shape);
+    }
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <string>
+#include <sstream>
+#include <random>
+
+#include "benchmark.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+
+
+// Sheet of labels repeated in every row and numbers, some cells are malformed formulas
+std::string makeLabelSheet(int height, int width, int label_count) {
+    std::mt19937 generator(42);
+    std::ostringstream sheet_stream;
+    sheet_stream << height << '\t' << width << '\n';
+    for (int row_index = 0; row_index < height; ++row_index) {
+        for (int column_index = 0; column_index < width; ++column_index) {
+            int kind = static_cast<int>(generator() % 10);
+            if (kind < 7) {
+                sheet_stream << "'Quarterly revenue of department " << generator() % static_cast<unsigned>(label_count);
+            } else if (kind < 9) {
+                sheet_stream << generator() % 100000;
+            } else {
+                sheet_stream << "=1+" << (generator() % 2 ? "x" : "y");
+            }
+            sheet_stream << (column_index + 1 == width ? '\n' : '\t');
+        }
+    }
+    return sheet_stream.str();
+}
+
+
+int main()
+{
+    Benchmark benchmark("Text cells");
+
+    auto raw_sheet = makeLabelSheet(1000, 1000, 200);
+    std::string sheet_name = "1000x1000 sheet with 200 distinct labels";
+    std::istringstream in_stream(raw_sheet);
+    InputBuffer input(in_stream);
+
+    // Memory is measured first, while freed memory cannot be reused yet
+    size_t memory_size_before = getResidentMemorySize();
+    ExpressionTable table = readParsedTable(input);
+    size_t memory_size_after = getResidentMemorySize();
+    std::cout << "Memory of parsed " << sheet_name << ": ";
+    std::cout << (memory_size_after - memory_size_before) / (1 << 20) << " MiB" << std::endl;
+
+    benchmark.run("readParsedTable of " + sheet_name, 3, [&]() {
+        doNotOptimize(readParsedTable(input));
+    });
+
+    return 0;
+}
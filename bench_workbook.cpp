@@ -0,0 +1,72 @@
+#include <vector>
+#include <string>
+#include <random>
+
+#include "benchmark.h"
+#include "coordinate.h"
+#include "expression.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "workbook.h"
+
+
+const int BLOCK_HEIGHT = 10;
+
+
+// Square sheet of columns split into blocks: the first cell of block is a number,
+// every other cell refers to the cell above, so edit of number recalculates one block
+ExpressionTable makeBlockSheet(int side) {
+    ExpressionTable table(side, side);
+    for (int row_index = 0; row_index < side; ++row_index) {
+        for (int column_index = 0; column_index < side; ++column_index) {
+            if (row_index % BLOCK_HEIGHT == 0) {
+                table(row_index, column_index) = parseExpression("1");
+                continue;
+            }
+            Expression expression(ExpressionType::ARITHMETIC);
+            expression.pushToken(Coordinate2D(row_index - 1, column_index));
+            expression.pushToken(Operation::ADD);
+            expression.pushToken(1);
+            table(row_index, column_index) = expression;
+        }
+    }
+    return table;
+}
+
+
+int main()
+{
+    Benchmark benchmark("Workbook");
+
+    for (int side : {100, 316, 1000}) {
+        auto sheet = makeBlockSheet(side);
+        std::string size_name = std::to_string(side) + "x" + std::to_string(side) + " sheet";
+
+        benchmark.run("full calculation of " + size_name, 1, [&]() {
+            auto table = sheet;
+            calculateParsedTable(table);
+            doNotOptimize(table);
+        });
+
+        Workbook workbook(sheet);
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> block_distribution(0, (side - 1) / BLOCK_HEIGHT);
+        std::uniform_int_distribution<int> column_distribution(0, side - 1);
+        const int edit_count = 1000;
+
+        int next_number = 0;
+        benchmark.run(std::to_string(edit_count) + " edits of numbers in " + size_name, 1, [&]() {
+            int recalculated_count = 0;
+            for (int edit_index = 0; edit_index < edit_count; ++edit_index) {
+                Coordinate2D coordinate(block_distribution(generator) * BLOCK_HEIGHT, column_distribution(generator));
+                Expression number(ExpressionType::ARITHMETIC);
+                number.pushToken(++next_number);
+                recalculated_count += workbook.setCell(coordinate, number);
+            }
+            doNotOptimize(recalculated_count);
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <string>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "benchmark.h"
+
+
+Benchmark::Benchmark(const std::string &plan_name_tmp, std::ostream &stream_tmp)
+    : plan_name(plan_name_tmp), stream(stream_tmp), next_case_index(0) {
+    const char *format = std::getenv("BENCH_FORMAT");
+    is_json = (format && std::string(format) == "json");
+}
+
+
+void Benchmark::countAllocations(const std::function<uint64_t()> &getAllocationCount_tmp) {
+    getAllocationCount = getAllocationCount_tmp;
+}
+
+
+// Value which given fraction of sorted values does not exceed (nearest-rank method)
+double getPercentile(const std::vector<double> &sorted_values, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted_values.size())));
+    return sorted_values[std::max<size_t>(rank, 1) - 1];
+}
+
+
+// String in quotes with quotes and backslashes escaped
+std::string makeJsonString(const std::string &string) {
+    std::string json_string = "\"";
+    for (char character : string) {
+        if (character == '"' || character == '\\') {
+            json_string.push_back('\\');
+        }
+        json_string.push_back(character);
+    }
+    return json_string + "\"";
+}
+
+
+void Benchmark::report(const std::string &case_name, std::vector<double> run_seconds, double item_count, double allocation_count) {
+    ++next_case_index;
+    std::sort(run_seconds.begin(), run_seconds.end());
+    double mean_seconds = std::accumulate(run_seconds.begin(), run_seconds.end(), 0.0) / static_cast<double>(run_seconds.size());
+    size_t peak_memory_size = getPeakResidentMemorySize();
+
+    if (is_json) {
+        stream << std::fixed << std::setprecision(3);
+        stream << "{\"plan\": " << makeJsonString(plan_name) << ", \"case\": " << makeJsonString(case_name);
+        stream << ", \"runs\": " << run_seconds.size() << ", \"mean_ms\": " << mean_seconds * 1000;
+        stream << ", \"min_ms\": " << run_seconds.front() * 1000;
+        stream << ", \"p50_ms\": " << getPercentile(run_seconds, 0.5) * 1000;
+        stream << ", \"p90_ms\": " << getPercentile(run_seconds, 0.9) * 1000;
+        stream << ", \"p99_ms\": " << getPercentile(run_seconds, 0.99) * 1000;
+        stream << ", \"max_ms\": " << run_seconds.back() * 1000;
+        if (item_count > 0) {
+            stream << ", \"items_per_second\": " << item_count / mean_seconds;
+        }
+        if (allocation_count >= 0) {
+            stream << ", \"allocations_per_run\": " << allocation_count;
+        }
+        stream << ", \"peak_rss_bytes\": " << peak_memory_size << "}" << std::endl;
+        return;
+    }
+
+    if (next_case_index == 1) {
+        stream << std::endl << "\033[1m=== Benchmark " << plan_name << " ===\033[0m" << std::endl;
+    }
+    stream << std::setw(3) << next_case_index << ". " << case_name << ": ";
+    stream << std::fixed << std::setprecision(3) << mean_seconds * 1000 << " ms/run";
+    stream << " (" << run_seconds.size() << " runs";
+    stream << "; p50 " << getPercentile(run_seconds, 0.5) * 1000;
+    stream << ", p90 " << getPercentile(run_seconds, 0.9) * 1000;
+    stream << ", max " << run_seconds.back() * 1000 << " ms";
+    if (item_count > 0) {
+        stream << "; " << std::setprecision(2) << item_count / mean_seconds / 1e6 << "M items/s";
+    }
+    if (allocation_count >= 0) {
+        stream << "; " << std::setprecision(0) << allocation_count << " allocations/run";
+    }
+    stream << "; peak RSS " << (peak_memory_size >> 20) << " MiB)" << std::endl;
+}
+
+
+size_t getResidentMemorySize() {
+    std::ifstream statm_stream("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (!(statm_stream >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+
+size_t getPeakResidentMemorySize() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // Linux reports kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
@@ -0,0 +1,82 @@
+#ifndef BENCHMARK_H_INCLUDED
+#define BENCHMARK_H_INCLUDED
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+
+// Reports are lines of text, or JSON objects one per line if environment variable BENCH_FORMAT is "json"
+class Benchmark
+{
+    const std::string plan_name;
+    std::ostream &stream;
+    int next_case_index;
+    bool is_json;
+    // Empty if allocations are not counted
+    std::function<uint64_t()> getAllocationCount;
+
+    // Item count is 0 if throughput is not measured, allocation count is negative if it is not counted
+    void report(const std::string &case_name, std::vector<double> run_seconds, double item_count, double allocation_count);
+public:
+    Benchmark(const std::string &plan_name_tmp, std::ostream &stream_tmp = std::cout);
+
+    // Given counter of allocations of process is read around every run, and mean number of allocations
+    // of one run is reported too
+    void countAllocations(const std::function<uint64_t()> &getAllocationCount_tmp);
+
+    // Runs action given number of times and reports mean and percentiles of wall time of one run
+    // and peak resident memory of process
+    template <typename Action>
+    void run(const std::string &case_name, int repetitions, Action &&action);
+
+    // The same, and throughput: items processed by one run per second
+    template <typename Action>
+    void run(const std::string &case_name, int repetitions, double item_count, Action &&action);
+};
+
+
+// Resident set size of current process in bytes, 0 if it is unknown
+size_t getResidentMemorySize();
+
+// Maximal resident set size of current process so far in bytes, 0 if it is unknown
+size_t getPeakResidentMemorySize();
+
+
+// Prevents compiler from optimizing away computation of given value
+template <typename ValueType>
+void doNotOptimize(const ValueType &value);
+
+
+
+template <typename Action>
+void Benchmark::run(const std::string &case_name, int repetitions, Action &&action) {
+    run(case_name, repetitions, 0, action);
+}
+
+template <typename Action>
+void Benchmark::run(const std::string &case_name, int repetitions, double item_count, Action &&action) {
+    std::vector<double> run_seconds;
+    uint64_t allocation_count = 0;
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+        uint64_t start_allocation_count = (getAllocationCount ? getAllocationCount() : 0);
+        auto start_time = std::chrono::steady_clock::now();
+        action();
+        std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+        run_seconds.push_back(elapsed_time.count());
+        allocation_count += (getAllocationCount ? getAllocationCount() - start_allocation_count : 0);
+    }
+    report(case_name, run_seconds, item_count, getAllocationCount ? static_cast<double>(allocation_count) / repetitions : -1);
+}
+
+template <typename ValueType>
+void doNotOptimize(const ValueType &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+
+#endif // BENCHMARK_H_INCLUDED
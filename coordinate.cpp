@@ -1,4 +1,6 @@
-#include <functional>
+#include <cstdint>
+#include <string>
+#include <algorithm>
 
 #include "coordinate.h"
 
@@ -19,6 +21,36 @@ bool Coordinate2D::operator==(const Coordinate2D &second) const {
 }
 
 
+CellRange::CellRange(const Coordinate2D &corner, const Coordinate2D &opposite_corner)
+    : first(std::min(corner.row, opposite_corner.row), std::min(corner.column, opposite_corner.column)),
+      last(std::max(corner.row, opposite_corner.row), std::max(corner.column, opposite_corner.column)) {}
+
+bool CellRange::contains(const Coordinate2D &coordinate) const {
+    return
+        coordinate.row >= first.row && coordinate.row <= last.row
+        && coordinate.column >= first.column && coordinate.column <= last.column;
+}
+
+bool CellRange::operator==(const CellRange &second) const {
+    return first == second.first && last == second.last;
+}
+
+
+std::string makeOutOfRangeMessage(const Coordinate2D &coordinate, int height, int width) {
+    return
+        "Coordinates (" + std::to_string(coordinate.row) + ", " + std::to_string(coordinate.column) + ") "
+        + "are out of range (" + std::to_string(height) + ", " + std::to_string(width) + ")";
+}
+
+
 size_t Coordinate2DHash::operator()(const Coordinate2D &coordinate) const {
-    return std::hash<int>()(coordinate.row) ^ (std::hash<int>()(coordinate.row) << 16);
+    // Both halves are packed into one word and mixed by finalizer of MurmurHash3,
+    // so every bit of hash depends on row and column
+    uint64_t key = (uint64_t(static_cast<uint32_t>(coordinate.row)) << 32) | static_cast<uint32_t>(coordinate.column);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
 }
@@ -1,6 +1,9 @@
 #ifndef COORDINATE_H_INCLUDED
 #define COORDINATE_H_INCLUDED
 
+#include <cstddef>
+#include <string>
+
 
 // Helper struct for using as index in SparseTable
 struct Coordinate2D
@@ -15,6 +18,24 @@ struct Coordinate2D
 };
 
 
+// Rectangle of cells, both corners are included; first is top-left corner, last is bottom-right one
+struct CellRange
+{
+    Coordinate2D first;
+    Coordinate2D last;
+
+    // Corners are reordered if needed, so any two opposite corners may be given
+    CellRange(const Coordinate2D &corner = {}, const Coordinate2D &opposite_corner = {});
+
+    bool contains(const Coordinate2D &coordinate) const;
+    bool operator==(const CellRange &second) const;
+};
+
+
+// Message of error for coordinate lying outside of table of given size
+std::string makeOutOfRangeMessage(const Coordinate2D &coordinate, int height, int width);
+
+
 struct Coordinate2DHash
 {
     size_t operator()(const Coordinate2D &coordinate) const;
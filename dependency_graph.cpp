@@ -0,0 +1,251 @@
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <numeric>
+
+#include "utils.h"
+#include "coordinate.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "dependency_graph.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+
+
+DependencyGraph::DependencyGraph(const ExpressionTable &table) {
+    std::vector<const Expression*> expressions;
+    for (const auto &cell_pair : table.getElements()) {
+        if (cell_pair.second.getType() == ExpressionType::ARITHMETIC && !cell_pair.second.isNumber()) {
+            cells.push_back(cell_pair.first);
+            expressions.push_back(&cell_pair.second);
+        }
+    }
+    buildDependents(expressions, table);
+}
+
+
+DependencyGraph::DependencyGraph(const std::vector<Coordinate2D> &cells_tmp, const ExpressionTable &table) : cells(cells_tmp) {
+    std::vector<const Expression*> expressions;
+    for (const auto &coordinate : cells) {
+        expressions.push_back(&table(coordinate));
+    }
+    buildDependents(expressions, table);
+}
+
+
+void DependencyGraph::buildDependents(const std::vector<const Expression*> &expressions, const ExpressionTable &table) {
+    auto isColumnMajorLess = [](const Coordinate2D &first, const Coordinate2D &second) {
+        return first.column < second.column || (first.column == second.column && first.row < second.row);
+    };
+    // Cells in column-major order, so cells of range are found column by column; sorted at first range
+    std::vector<int> column_order;
+    auto forEachCellInRange = [this, &column_order, &isColumnMajorLess](const CellRange &range, auto action) {
+        if (column_order.size() != cells.size()) {
+            column_order.resize(cells.size());
+            std::iota(column_order.begin(), column_order.end(), 0);
+            std::sort(column_order.begin(), column_order.end(), [this, &isColumnMajorLess](int first_index, int second_index) {
+                return isColumnMajorLess(cells[static_cast<size_t>(first_index)], cells[static_cast<size_t>(second_index)]);
+            });
+        }
+        auto findFirst = [this, &column_order, &isColumnMajorLess](std::vector<int>::iterator begin, const Coordinate2D &coordinate) {
+            return std::lower_bound(begin, column_order.end(), coordinate, [this, &isColumnMajorLess](int cell_index, const Coordinate2D &other) {
+                return isColumnMajorLess(cells[static_cast<size_t>(cell_index)], other);
+            });
+        };
+        // Columns without cells are skipped, so wide ranges cost as much as columns of graph they cover
+        auto position = findFirst(column_order.begin(), range.first);
+        while (position != column_order.end()) {
+            const auto &cell = cells[static_cast<size_t>(*position)];
+            if (cell.column > range.last.column) {
+                break;
+            } else if (cell.row < range.first.row) {
+                position = findFirst(position, {range.first.row, cell.column});
+            } else if (cell.row > range.last.row) {
+                if (cell.column == range.last.column) {
+                    break;
+                }
+                position = findFirst(position, {range.first.row, cell.column + 1});
+            } else {
+                action(*position);
+                ++position;
+            }
+        }
+    };
+
+    // Calls action(referred_index, cell_index) for every reference between cells of graph;
+    // ranges with corners out of table are errors rather than references
+    auto forEachReference = [this, &expressions, &table, &forEachCellInRange](auto action) {
+        for (int cell_index = 0; cell_index < getCellCount(); ++cell_index) {
+            for (const auto &token : *expressions[static_cast<size_t>(cell_index)]) {
+                if (token.type == LexemType::CELL_REFERENCE) {
+                    int referred_index = findCell(token.coordinate);
+                    if (referred_index != -1) {
+                        action(referred_index, cell_index);
+                    }
+                } else if (
+                    token.type == LexemType::AGGREGATE && table.isInRange(token.getAggregate().range.first)
+                    && table.isInRange(token.getAggregate().range.last)
+                ) {
+                    forEachCellInRange(token.getAggregate().range, [&action, cell_index](int referred_index) {
+                        action(referred_index, cell_index);
+                    });
+                }
+            }
+        }
+    };
+
+    dependent_offsets.assign(cells.size() + 1, 0);
+    forEachReference([this](int referred_index, int) {
+        ++dependent_offsets[static_cast<size_t>(referred_index) + 1];
+    });
+    for (size_t cell_index = 0; cell_index < cells.size(); ++cell_index) {
+        dependent_offsets[cell_index + 1] += dependent_offsets[cell_index];
+    }
+
+    dependents.resize(static_cast<size_t>(dependent_offsets.back()));
+    std::vector<int> next_positions(dependent_offsets.begin(), dependent_offsets.end() - 1);
+    forEachReference([this, &next_positions](int referred_index, int cell_index) {
+        dependents[static_cast<size_t>(next_positions[static_cast<size_t>(referred_index)]++)] = cell_index;
+    });
+}
+
+
+const std::vector<Coordinate2D> &DependencyGraph::getCells() const {
+    return cells;
+}
+
+
+int DependencyGraph::getCellCount() const {
+    return static_cast<int>(cells.size());
+}
+
+
+const Coordinate2D &DependencyGraph::getCoordinate(int cell_index) const {
+    return cells[static_cast<size_t>(cell_index)];
+}
+
+
+int DependencyGraph::findCell(const Coordinate2D &coordinate) const {
+    auto iterator = std::lower_bound(cells.begin(), cells.end(), coordinate);
+    if (iterator == cells.end() || !(*iterator == coordinate)) {
+        return -1;
+    }
+    return static_cast<int>(iterator - cells.begin());
+}
+
+
+IteratorRange<DependencyGraph::DependentIterator> DependencyGraph::getDependents(int cell_index) const {
+    return {
+        dependents.begin() + dependent_offsets[static_cast<size_t>(cell_index)],
+        dependents.begin() + dependent_offsets[static_cast<size_t>(cell_index) + 1]
+    };
+}
+
+
+std::vector<int> DependencyGraph::sortTopologically(const std::vector<bool> &is_excluded, std::vector<int> *level_offsets) const {
+    std::vector<int> reference_counts(cells.size(), 0);
+    for (int cell_index = 0; cell_index < getCellCount(); ++cell_index) {
+        if (is_excluded[static_cast<size_t>(cell_index)]) {
+            continue;
+        }
+        for (int dependent_index : getDependents(cell_index)) {
+            ++reference_counts[static_cast<size_t>(dependent_index)];
+        }
+    }
+
+    std::vector<int> order;
+    for (int cell_index = 0; cell_index < getCellCount(); ++cell_index) {
+        if (!is_excluded[static_cast<size_t>(cell_index)] && reference_counts[static_cast<size_t>(cell_index)] == 0) {
+            order.push_back(cell_index);
+        }
+    }
+
+    // order is used as queue of cells whose references are all calculated;
+    // cells added while processing one level form the next level
+    if (level_offsets) {
+        level_offsets->assign(1, 0);
+    }
+    for (size_t order_position = 0; order_position < order.size(); ++order_position) {
+        if (level_offsets && static_cast<int>(order_position) == level_offsets->back()) {
+            level_offsets->push_back(static_cast<int>(order.size()));
+        }
+        for (int dependent_index : getDependents(order[order_position])) {
+            if (!is_excluded[static_cast<size_t>(dependent_index)] && --reference_counts[static_cast<size_t>(dependent_index)] == 0) {
+                order.push_back(dependent_index);
+            }
+        }
+    }
+
+    return order;
+}
+
+
+std::vector<int> DependencyGraph::findCycleCells(const std::vector<bool> &is_excluded) const {
+    std::vector<int> visit_indices(cells.size(), -1);
+    std::vector<int> low_links(cells.size(), 0);
+    std::vector<bool> is_on_stack(cells.size(), false);
+    std::vector<int> component_stack;
+    // Explicit DFS stack: cell and its next dependent to visit
+    std::vector<std::pair<int, DependentIterator>> dfs_stack;
+    int next_visit_index = 0;
+
+    std::vector<int> cycle_cells;
+
+    auto visit = [&](int cell_index) {
+        size_t index = static_cast<size_t>(cell_index);
+        visit_indices[index] = low_links[index] = next_visit_index++;
+        component_stack.push_back(cell_index);
+        is_on_stack[index] = true;
+        dfs_stack.emplace_back(cell_index, getDependents(cell_index).begin());
+    };
+
+    for (int root_index = 0; root_index < getCellCount(); ++root_index) {
+        if (is_excluded[static_cast<size_t>(root_index)] || visit_indices[static_cast<size_t>(root_index)] != -1) {
+            continue;
+        }
+
+        visit(root_index);
+        while (!dfs_stack.empty()) {
+            int cell_index = dfs_stack.back().first;
+            size_t index = static_cast<size_t>(cell_index);
+
+            if (dfs_stack.back().second != getDependents(cell_index).end()) {
+                int dependent_index = *dfs_stack.back().second++;
+                size_t dependent = static_cast<size_t>(dependent_index);
+                if (is_excluded[dependent]) {
+                    continue;
+                }
+                if (visit_indices[dependent] == -1) {
+                    visit(dependent_index);
+                } else if (is_on_stack[dependent]) {
+                    low_links[index] = std::min(low_links[index], visit_indices[dependent]);
+                }
+                continue;
+            }
+
+            dfs_stack.pop_back();
+            if (!dfs_stack.empty()) {
+                size_t parent = static_cast<size_t>(dfs_stack.back().first);
+                low_links[parent] = std::min(low_links[parent], low_links[index]);
+            }
+
+            if (low_links[index] == visit_indices[index]) {
+                auto component_begin = std::find(component_stack.rbegin(), component_stack.rend(), cell_index).base() - 1;
+                auto dependents_range = getDependents(cell_index);
+                bool is_cycle =
+                    component_stack.end() - component_begin > 1
+                    || std::find(dependents_range.begin(), dependents_range.end(), cell_index) != dependents_range.end();
+
+                for (auto iterator = component_begin; iterator != component_stack.end(); ++iterator) {
+                    is_on_stack[static_cast<size_t>(*iterator)] = false;
+                    if (is_cycle) {
+                        cycle_cells.push_back(*iterator);
+                    }
+                }
+                component_stack.erase(component_begin, component_stack.end());
+            }
+        }
+    }
+
+    return cycle_cells;
+}
@@ -0,0 +1,53 @@
+#ifndef DEPENDENCY_GRAPH_H_INCLUDED
+#define DEPENDENCY_GRAPH_H_INCLUDED
+
+#include <vector>
+
+#include "utils.h"
+#include "coordinate.h"
+#include "expression_table.h"
+
+
+// Graph of references between arithmetic cells of table.
+// Cells are numbered in row-major order; there is an edge from cell to every cell referring to it
+// directly or by range of aggregate.
+class DependencyGraph
+{
+    std::vector<Coordinate2D> cells;
+    // Dependents of cell i are dependents[dependent_offsets[i] .. dependent_offsets[i + 1])
+    std::vector<int> dependent_offsets;
+    std::vector<int> dependents;
+
+    using DependentIterator = std::vector<int>::const_iterator;
+
+    // expressions[i] is expression of cells[i] of table
+    void buildDependents(const std::vector<const Expression*> &expressions, const ExpressionTable &table);
+public:
+    // Graph of arithmetic cells of table which need calculation, cells of single numbers are omitted
+    explicit DependencyGraph(const ExpressionTable &table);
+
+    // Graph of given arithmetic cells of table sorted in row-major order,
+    // references to other cells are ignored
+    DependencyGraph(const std::vector<Coordinate2D> &cells_tmp, const ExpressionTable &table);
+
+    int getCellCount() const;
+    const Coordinate2D &getCoordinate(int cell_index) const;
+    // Coordinates of all cells in row-major order
+    const std::vector<Coordinate2D> &getCells() const;
+
+    // Index of arithmetic cell with given coordinate or -1 if there is no such cell
+    int findCell(const Coordinate2D &coordinate) const;
+
+    IteratorRange<DependentIterator> getDependents(int cell_index) const;
+
+    // Kahn's algorithm: every cell goes after all cells it refers to.
+    // Excluded cells are considered already calculated, cells on cycles and depending on them are omitted.
+    // If level_offsets is given, it receives bounds of levels: cells of one level do not refer to each other
+    std::vector<int> sortTopologically(const std::vector<bool> &is_excluded, std::vector<int> *level_offsets = nullptr) const;
+
+    // Cells of not excluded part of graph lying on reference cycles (Tarjan's algorithm)
+    std::vector<int> findCycleCells(const std::vector<bool> &is_excluded) const;
+};
+
+
+#endif // DEPENDENCY_GRAPH_H_INCLUDED
@@ -1,15 +1,19 @@
 #include <vector>
 #include <stdexcept>
-#include <sstream>
 #include <memory>
 #include <cctype>
 #include <string>
 #include <functional>
 #include <algorithm>
 #include <utility>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "utils.h"
 #include "expression.h"
+#include "formula_pool.h"
 
 
 LexemBase::LexemBase() {}
@@ -42,20 +46,18 @@ bool LexemText::equalTo(const LexemBase *other) const {
 LexemText::~LexemText() {}
 
 
-LexemNumber::LexemNumber(int number_tmp) : number(number_tmp) {}
+LexemNumber::LexemNumber(Number number_tmp) : number(number_tmp) {}
 
 LexemType LexemNumber::getType() const {
     return LexemType::NUMBER;
 }
 
-int LexemNumber::getNumber() const {
+Number LexemNumber::getNumber() const {
     return number;
 }
 
 std::string LexemNumber::getText() const {
-    std::stringstream number_stream;
-    number_stream << number;
-    return number_stream.str();
+    return formatNumber(number);
 }
 
 bool LexemNumber::operator==(const LexemNumber &other) const {
@@ -71,21 +73,6 @@ bool LexemNumber::equalTo(const LexemBase *other) const {
 LexemNumber::~LexemNumber() {}
 
 
-int parseNumber(const std::string &raw_number) {
-    if (
-        raw_number.empty()
-        || std::count_if(raw_number.begin(), raw_number.end(), [](char character){ return !std::isdigit(character); }) > 0
-    ) {
-        std::stringstream message_stream;
-        message_stream << "'" << raw_number << "' is not a non-negative integer number";
-        throw std::invalid_argument(message_stream.str());
-    }
-
-    std::stringstream number_stream(raw_number);
-    int number;
-    number_stream >> number;
-    return number;
-}
 
 
 LexemCellReference::LexemCellReference(const Coordinate2D &coordinate_tmp) : coordinate(coordinate_tmp) {}
@@ -113,17 +100,54 @@ bool LexemCellReference::equalTo(const LexemBase *other) const {
 LexemCellReference::~LexemCellReference() {}
 
 
-Coordinate2D parseCoordinate(const std::string &raw_coordinate) {
-    if (raw_coordinate.length() != 2 || !isalpha(raw_coordinate[0]) || !isdigit(raw_coordinate[1]) || raw_coordinate[1] == '0') {
-        std::stringstream message_stream;
-        message_stream << "Coordinate '" << raw_coordinate << "' is ill-formed";
-        throw std::invalid_argument(message_stream.str());
+Result<Coordinate2D> tryParseCoordinate(const StringRef &raw_coordinate) {
+    // Longer names do not fit into int anyway, so they are rejected before overflow can happen
+    const int MAX_COLUMN_LETTERS = 7;
+    const int MAX_ROW_DIGITS = 10;
+
+    const char *position = raw_coordinate.begin();
+    const char *end = raw_coordinate.end();
+    // '$' marks absolute column or row; references are never copied between cells, so marks are only skipped
+    if (position != end && *position == '$') {
+        ++position;
+    }
+
+    // Columns are named A..Z, AA..AZ, ..., ZZ, AAA, ... as numbers in bijective base-26 numeral system
+    const char *column_begin = position;
+    int64_t column_number = 0;
+    for (; position != end && position - column_begin <= MAX_COLUMN_LETTERS; ++position) {
+        char letter = static_cast<char>(*position | 0x20);
+        if (letter < 'a' || letter > 'z') {
+            break;
+        }
+        column_number = column_number * 26 + (letter - 'a' + 1);
+    }
+
+    if (position != end && *position == '$') {
+        ++position;
+    }
+
+    const char *row_begin = position;
+    int64_t row_number = 0;
+    for (; position != end && position - row_begin <= MAX_ROW_DIGITS; ++position) {
+        if (*position < '0' || *position > '9') {
+            break;
+        }
+        row_number = row_number * 10 + (*position - '0');
     }
 
-    char row_name = raw_coordinate[1];
-    char column_name = raw_coordinate[0];
+    if (
+        position != end || column_number == 0 || row_number == 0 || *row_begin == '0'
+        || column_number > std::numeric_limits<int>::max() || row_number > std::numeric_limits<int>::max()
+    ) {
+        return Error(ErrorCode::ILL_FORMED_COORDINATE, raw_coordinate);
+    }
+
+    return Coordinate2D(static_cast<int>(row_number - 1), static_cast<int>(column_number - 1));
+}
 
-    return {row_name - '1', std::tolower(column_name) - 'a'};
+Coordinate2D parseCoordinate(const StringRef &raw_coordinate) {
+    return tryParseCoordinate(raw_coordinate).getValueOrThrow();
 }
 
 
@@ -139,23 +163,11 @@ const Operation &LexemOperation::getOperation() const {
     return operation;
 }
 
-std::function<int(int, int)> LexemOperation::getAction() const {
-    if (operation == Operation::ADD) {
-        return std::plus<int>();
-    } else if (operation == Operation::SUBTRACT) {
-        return std::minus<int>();
-    } else if (operation == Operation::MULTIPLY) {
-        return std::multiplies<int>();
-    } else if (operation == Operation::DIVIDE) {
-        return [](int dividend, int divisor) {
-            if (divisor == 0) {
-                throw std::domain_error("Division by 0");
-            } else {
-                return dividend / divisor;
-            }
-        };
-    }
-    throw std::invalid_argument("Unimplemented operation");
+std::function<Number(Number, Number)> LexemOperation::getAction() const {
+    Operation lexem_operation = operation;
+    return [lexem_operation](Number left_operand, Number right_operand) {
+        return applyOperation(lexem_operation, left_operand, right_operand);
+    };
 }
 
 bool LexemOperation::operator==(const LexemOperation &other) const {
@@ -171,67 +183,336 @@ bool LexemOperation::equalTo(const LexemBase *other) const {
 LexemOperation::~LexemOperation() {}
 
 
-Operation parseOperation(const std::string &raw_operation) {
-    if (raw_operation == "+") {
-        return Operation::ADD;
-    } else if (raw_operation == "-") {
-        return Operation::SUBTRACT;
-    } else if (raw_operation == "*") {
-        return Operation::MULTIPLY;
-    } else if (raw_operation == "/") {
-        return Operation::DIVIDE;
-    } else {
-        std::stringstream message_stream;
-        message_stream << "Operation '" << raw_operation << "' is unknown";
-        throw std::invalid_argument(message_stream.str());
+Result<Operation> tryParseOperation(const StringRef &raw_operation) {
+    if (raw_operation.getSize() == 1) {
+        switch (raw_operation[0]) {
+        case '+':
+            return Operation::ADD;
+        case '-':
+            return Operation::SUBTRACT;
+        case '*':
+            return Operation::MULTIPLY;
+        case '/':
+            return Operation::DIVIDE;
+        }
+    }
+    return Error(ErrorCode::UNKNOWN_OPERATION, raw_operation);
+}
+
+Operation parseOperation(const StringRef &raw_operation) {
+    return tryParseOperation(raw_operation).getValueOrThrow();
+}
+
+
+AggregateCall::AggregateCall(Aggregate function_tmp, const CellRange &range_tmp) : function(function_tmp), range(range_tmp) {}
+
+bool AggregateCall::operator==(const AggregateCall &other) const {
+    return function == other.function && range == other.range;
+}
+
+
+LexemAggregate::LexemAggregate(const AggregateCall &call_tmp) : call(call_tmp) {}
+
+LexemType LexemAggregate::getType() const {
+    return LexemType::AGGREGATE;
+}
+
+const AggregateCall &LexemAggregate::getCall() const {
+    return call;
+}
+
+bool LexemAggregate::operator==(const LexemAggregate &other) const {
+    return call == other.call;
+}
+
+bool LexemAggregate::equalTo(const LexemBase *other) const {
+    return
+        getType() == other->getType()
+        && *this == *dynamic_cast<const LexemAggregate*>(other);
+}
+
+LexemAggregate::~LexemAggregate() {}
+
+
+// Function name is compared case-insensitively
+Result<Aggregate> tryParseAggregate(const StringRef &raw_name) {
+    const std::pair<const char*, Aggregate> functions[] = {
+        {"sum", Aggregate::SUM},
+        {"min", Aggregate::MIN},
+        {"max", Aggregate::MAX},
+        {"count", Aggregate::COUNT},
+        {"avg", Aggregate::AVERAGE},
+    };
+    for (const auto &function : functions) {
+        StringRef name(function.first);
+        if (
+            name.getSize() == raw_name.getSize()
+            && std::equal(name.begin(), name.end(), raw_name.begin(), [](char name_character, char raw_character) {
+                return name_character == std::tolower(raw_character);
+            })
+        ) {
+            return function.second;
+        }
+    }
+    return Error(ErrorCode::UNKNOWN_FUNCTION, raw_name);
+}
+
+Result<AggregateCall> tryParseAggregateCall(const StringRef &raw_call) {
+    const char *argument_begin = std::find(raw_call.begin(), raw_call.end(), '(');
+    if (argument_begin == raw_call.end() || raw_call.getSize() < 2 || raw_call[raw_call.getSize() - 1] != ')') {
+        return Error(ErrorCode::ILL_FORMED_FUNCTION_CALL, raw_call);
+    }
+
+    Result<Aggregate> function = tryParseAggregate(StringRef(raw_call.begin(), argument_begin));
+    if (!function.isOk()) {
+        return function.getError();
+    }
+
+    // Argument is range of two corners separated by ':' or single cell
+    ++argument_begin;
+    const char *argument_end = raw_call.end() - 1;
+    const char *separator = std::find(argument_begin, argument_end, ':');
+    Result<Coordinate2D> corner = tryParseCoordinate(StringRef(argument_begin, separator));
+    if (!corner.isOk()) {
+        return corner.getError();
+    }
+    if (separator == argument_end) {
+        return AggregateCall(function.getValue(), CellRange(corner.getValue(), corner.getValue()));
+    }
+    Result<Coordinate2D> opposite_corner = tryParseCoordinate(StringRef(separator + 1, argument_end));
+    if (!opposite_corner.isOk()) {
+        return opposite_corner.getError();
+    }
+    return AggregateCall(function.getValue(), CellRange(corner.getValue(), opposite_corner.getValue()));
+}
+
+AggregateCall parseAggregateCall(const StringRef &raw_call) {
+    return tryParseAggregateCall(raw_call).getValueOrThrow();
+}
+
+
+Token::Token(Number number_tmp) : type(LexemType::NUMBER), number(number_tmp) {}
+
+Token::Token(const Coordinate2D &coordinate_tmp) : type(LexemType::CELL_REFERENCE), coordinate(coordinate_tmp) {}
+
+Token::Token(Operation operation_tmp) : type(LexemType::OPERATION), operation(operation_tmp) {}
+
+// Aggregate call stored in StringPool as bytes
+InternedString internAggregateCall(const AggregateCall &call) {
+    static_assert(std::is_trivially_copyable<AggregateCall>::value, "AggregateCall is stored as bytes");
+    char bytes[sizeof(AggregateCall)];
+    std::memcpy(bytes, &call, sizeof(AggregateCall));
+    return InternedString(StringRef(bytes, bytes + sizeof(AggregateCall)));
+}
+
+Token::Token(const AggregateCall &aggregate_tmp)
+    : type(LexemType::AGGREGATE), aggregate_record(internAggregateCall(aggregate_tmp)) {}
+
+AggregateCall Token::getAggregate() const {
+    AggregateCall aggregate;
+    std::memcpy(&aggregate, aggregate_record.get().begin(), sizeof(AggregateCall));
+    return aggregate;
+}
+
+bool Token::operator==(const Token &other) const {
+    if (type != other.type) {
+        return false;
+    }
+    switch (type) {
+    case LexemType::NUMBER:
+        return number == other.number;
+    case LexemType::CELL_REFERENCE:
+        return coordinate == other.coordinate;
+    case LexemType::OPERATION:
+        return operation == other.operation;
+    case LexemType::AGGREGATE:
+        // Equal calls are interned once
+        return aggregate_record == other.aggregate_record;
+    default:
+        return true;
     }
 }
 
 
-Expression::Expression(ExpressionType type_tmp) : type(type_tmp) {}
+Expression::Expression(ExpressionType type_tmp)
+    : type(type_tmp), error_code(ErrorCode::OTHER), formula(nullptr), has_inline_token(false), inline_token() {}
 
 ExpressionType Expression::getType() const {
     return type;
 }
 
 size_t Expression::getSize() const {
-    return lexems.size();
+    bool has_text = (type == ExpressionType::TEXT || type == ExpressionType::ERROR);
+    size_t token_count = (formula ? formula->size() : (has_inline_token ? 1 : 0));
+    return token_count + (has_text ? 1 : 0);
 }
 
-void Expression::pushLexem(std::shared_ptr<LexemBase> lexem_pointer) {
-    lexems.push_back(lexem_pointer);
+bool Expression::isNumber() const {
+    return type == ExpressionType::ARITHMETIC && has_inline_token && inline_token.type == LexemType::NUMBER;
 }
 
-typename Expression::LexemIterator Expression::begin() {
-    return lexems.begin();
+Number Expression::getNumber() const {
+    return inline_token.number;
 }
 
-typename Expression::LexemIterator Expression::end() {
-    return lexems.end();
+const CompiledFormula *Expression::getFormula() const {
+    return formula;
 }
 
-typename Expression::LexemConstIterator Expression::begin() const {
-    return lexems.begin();
+const Coordinate2D &Expression::getAnchor() const {
+    return anchor;
 }
 
-typename Expression::LexemConstIterator Expression::end() const {
-    return lexems.end();
+void Expression::setFormula(const CompiledFormula *formula_tmp, const Coordinate2D &anchor_tmp) {
+    formula = formula_tmp;
+    has_inline_token = false;
+    anchor = anchor_tmp;
 }
 
-bool Expression::operator==(const Expression &other) const {
-    if (type != other.type || lexems.size() != other.lexems.size()) {
-        return false;
+StringRef Expression::getText() const {
+    return text.get();
+}
+
+void Expression::setText(const StringRef &text_tmp) {
+    text = InternedString(text_tmp);
+}
+
+Error Expression::getError() const {
+    return Error(error_code, text.get());
+}
+
+void Expression::setError(const Error &error) {
+    error_code = error.code;
+    setText(error.argument);
+}
+
+std::string Expression::getErrorMessage() const {
+    return makeErrorMessage(makeErrorDescription(getError()));
+}
+
+void Expression::setTokens(const std::vector<Token> &tokens, const Coordinate2D &anchor_tmp) {
+    if (tokens.size() <= 1) {
+        formula = nullptr;
+        has_inline_token = !tokens.empty();
+        inline_token = (has_inline_token ? tokens[0] : Token());
+        return;
+    }
+    thread_local std::vector<Token> relative_tokens;
+    relative_tokens.assign(tokens.begin(), tokens.end());
+    for (auto &token : relative_tokens) {
+        if (token.type == LexemType::CELL_REFERENCE) {
+            token.coordinate.row -= anchor_tmp.row;
+            token.coordinate.column -= anchor_tmp.column;
+        }
     }
+    formula = FormulaPool::getCurrent().intern(relative_tokens);
+    has_inline_token = false;
+    anchor = anchor_tmp;
+}
 
-    for (size_t lexem_index = 0; lexem_index < lexems.size(); ++lexem_index) {
-        if (!lexems[lexem_index]->equalTo(other.lexems[lexem_index].get())) {
-            return false;
+void Expression::pushToken(const Token &token) {
+    if (!formula && !has_inline_token) {
+        has_inline_token = true;
+        inline_token = token;
+        return;
+    }
+    std::vector<Token> tokens(begin(), end());
+    tokens.push_back(token);
+    setTokens(tokens, formula ? anchor : Coordinate2D());
+}
+
+Token makeToken(const LexemBase &lexem) {
+    switch (lexem.getType()) {
+    case LexemType::NUMBER:
+        return dynamic_cast<const LexemNumber&>(lexem).getNumber();
+    case LexemType::CELL_REFERENCE:
+        return dynamic_cast<const LexemCellReference&>(lexem).getCoordinate();
+    case LexemType::OPERATION:
+        return dynamic_cast<const LexemOperation&>(lexem).getOperation();
+    case LexemType::AGGREGATE:
+        return dynamic_cast<const LexemAggregate&>(lexem).getCall();
+    default:
+        throw std::invalid_argument("Text lexem is not token");
+    }
+}
+
+void Expression::pushLexem(const std::shared_ptr<LexemBase> &lexem_pointer) {
+    switch (lexem_pointer->getType()) {
+    case LexemType::TEXT: {
+        const std::string &lexem_text = dynamic_cast<const LexemText*>(lexem_pointer.get())->getText();
+        if (type == ExpressionType::ERROR) {
+            // Text lexem of error is the whole printed message
+            bool has_mark = !lexem_text.empty() && lexem_text[0] == '#';
+            setError(Error(ErrorCode::OTHER, StringRef(lexem_text).substr(has_mark ? 1 : 0)));
+        } else {
+            setText(lexem_text);
         }
+        break;
+    }
+    default:
+        pushToken(makeToken(*lexem_pointer));
+        break;
     }
+}
 
+std::vector<std::shared_ptr<LexemBase>> Expression::getLexems() const {
+    std::vector<std::shared_ptr<LexemBase>> lexems;
+    if (type == ExpressionType::TEXT) {
+        lexems.push_back(std::make_shared<LexemText>(getText().toString()));
+    } else if (type == ExpressionType::ERROR) {
+        lexems.push_back(std::make_shared<LexemText>(getErrorMessage()));
+    }
+    for (const auto &token : *this) {
+        if (token.type == LexemType::NUMBER) {
+            lexems.push_back(std::make_shared<LexemNumber>(token.number));
+        } else if (token.type == LexemType::CELL_REFERENCE) {
+            lexems.push_back(std::make_shared<LexemCellReference>(token.coordinate));
+        } else if (token.type == LexemType::OPERATION) {
+            lexems.push_back(std::make_shared<LexemOperation>(token.operation));
+        } else if (token.type == LexemType::AGGREGATE) {
+            lexems.push_back(std::make_shared<LexemAggregate>(token.getAggregate()));
+        }
+    }
+    return lexems;
+}
+
+typename Expression::TokenIterator Expression::begin() const {
+    if (formula) {
+        return {formula->begin(), anchor};
+    }
+    return {&inline_token, {}};
+}
+
+typename Expression::TokenIterator Expression::end() const {
+    if (formula) {
+        return {formula->end(), anchor};
+    }
+    return {&inline_token + (has_inline_token ? 1 : 0), {}};
+}
+
+// Tokens of expressions are compared with absolute references, so anchors do not matter
+bool haveEqualTokens(const Expression &first, const Expression &second) {
+    if (first.getSize() != second.getSize()) {
+        return false;
+    }
+    auto second_iterator = second.begin();
+    for (const auto &token : first) {
+        if (!(token == *second_iterator)) {
+            return false;
+        }
+        ++second_iterator;
+    }
     return true;
 }
 
+bool Expression::operator==(const Expression &other) const {
+    if (type == ExpressionType::ERROR && other.type == ExpressionType::ERROR) {
+        // The same message may be stored with different codes
+        return haveEqualTokens(*this, other) && getErrorMessage() == other.getErrorMessage();
+    }
+    return type == other.type && haveEqualTokens(*this, other) && text == other.text;
+}
+
 
 std::shared_ptr<LexemBase> makeLexemPointer(LexemType lexem_type, const std::string &raw_lexem) {
     if (lexem_type == LexemType::TEXT) {
@@ -242,114 +523,315 @@ std::shared_ptr<LexemBase> makeLexemPointer(LexemType lexem_type, const std::str
         return std::make_shared<LexemCellReference>(parseCoordinate(raw_lexem));
     } else if (lexem_type == LexemType::OPERATION) {
         return std::make_shared<LexemOperation>(parseOperation(raw_lexem));
+    } else if (lexem_type == LexemType::AGGREGATE) {
+        return std::make_shared<LexemAggregate>(parseAggregateCall(raw_lexem));
     }
     throw std::invalid_argument("Invalid lexem type");
 }
 
 
-Expression makeErrorExpression(const std::string &error_message) {
+Expression makeErrorExpression(const Error &error) {
     Expression expression(ExpressionType::ERROR);
-    expression.pushLexem(makeLexemPointer(LexemType::TEXT, makeErrorMessage(error_message)));
+    expression.setError(error);
     return expression;
 }
 
 
-Expression parseExpression(const std::string &raw_expression) {
-    if (raw_expression.empty()) {
-        return {};
+Expression makeErrorExpression(const std::string &error_message) {
+    return makeErrorExpression(Error(ErrorCode::OTHER, error_message));
+}
+
+
+// Token of arithmetic expression of given lexem type
+Result<Token> tryParseToken(LexemType lexem_type, const StringRef &raw_lexem) {
+    if (lexem_type == LexemType::NUMBER) {
+        Result<Number> number = tryParseNumber(raw_lexem);
+        return number.isOk() ? Result<Token>(number.getValue()) : Result<Token>(number.getError());
+    } else if (lexem_type == LexemType::CELL_REFERENCE) {
+        Result<Coordinate2D> coordinate = tryParseCoordinate(raw_lexem);
+        return coordinate.isOk() ? Result<Token>(coordinate.getValue()) : Result<Token>(coordinate.getError());
+    } else if (lexem_type == LexemType::AGGREGATE) {
+        Result<AggregateCall> call = tryParseAggregateCall(raw_lexem);
+        return call.isOk() ? Result<Token>(call.getValue()) : Result<Token>(call.getError());
+    } else {
+        Result<Operation> operation = tryParseOperation(raw_lexem);
+        return operation.isOk() ? Result<Token>(operation.getValue()) : Result<Token>(operation.getError());
     }
+}
 
-    try {
-        if (raw_expression[0] == '\'') {
-
-            Expression expression(ExpressionType::TEXT);
-            expression.pushLexem(makeLexemPointer(LexemType::TEXT, raw_expression.substr(1)));
-            return expression;
-
-        } else if (raw_expression[0] == '=') {
-
-            Expression expression(ExpressionType::ARITHMETIC);
-            LexemType lexem_type = LexemType::NUMBER;
-            std::string raw_lexem;
-            for (auto it = raw_expression.cbegin() + 1; it != raw_expression.cend(); ++it) {
-                char character = *it;
-                if (std::isalnum(character)) {
-                    if (raw_lexem.empty()) {
-                        lexem_type = (std::isdigit(character) ? LexemType::NUMBER : LexemType::CELL_REFERENCE);
-                    }
-                    raw_lexem.push_back(character);
-                } else {
-                    if (!raw_lexem.empty()) {
-                        expression.pushLexem(makeLexemPointer(lexem_type, raw_lexem));
-                        raw_lexem.clear();
-                    }
-                    expression.pushLexem(makeLexemPointer(LexemType::OPERATION, std::string(1, character)));
-                }
-            }
-            if (!raw_lexem.empty()) {
-                expression.pushLexem(makeLexemPointer(lexem_type, raw_lexem));
-            }
-            return expression;
 
-        } else {
+// Operations of higher precedence are applied first
+int getOperationPrecedence(Operation operation) {
+    return (operation == Operation::MULTIPLY || operation == Operation::DIVIDE ? 2 : 1);
+}
+
 
-            Expression expression(ExpressionType::ARITHMETIC);
-            expression.pushLexem(makeLexemPointer(LexemType::NUMBER, raw_expression));
-            return expression;
+// Operation waiting for its right operand to be compiled, or opening parenthesis
+struct PendingOperation
+{
+    Operation operation;
+    bool is_parenthesis;
+};
 
+
+// Compiles infix operands, operations and parentheses into postfix tokens by shunting-yard algorithm.
+// Order of operands and operations is checked once here, so evaluation does not check it.
+// Operations on two numbers are folded into their result, except division by zero left for evaluation.
+// The first error is kept and reported by tryFinish, so errors of lexems found later take priority
+class PostfixCompiler
+{
+    std::vector<Token> &tokens;
+    std::vector<PendingOperation> &pending_operations;
+    bool is_operand_expected;
+    Result<bool> status;
+
+    void fail(ErrorCode code);
+    void popPendingOperation();
+public:
+    // Tokens are written to given vector and pending operations are kept in another one,
+    // so their memory is reused between expressions
+    PostfixCompiler(std::vector<Token> &tokens_tmp, std::vector<PendingOperation> &pending_operations_tmp);
+
+    void pushOperand(const Token &token);
+    void pushOperation(Operation operation);
+    void openParenthesis();
+    void closeParenthesis();
+    Result<bool> tryFinish();
+};
+
+
+PostfixCompiler::PostfixCompiler(std::vector<Token> &tokens_tmp, std::vector<PendingOperation> &pending_operations_tmp)
+    : tokens(tokens_tmp), pending_operations(pending_operations_tmp), is_operand_expected(true), status(true) {
+    tokens.clear();
+    pending_operations.clear();
+}
+
+void PostfixCompiler::fail(ErrorCode code) {
+    if (status.isOk()) {
+        status = Error(code);
+    }
+}
+
+void PostfixCompiler::popPendingOperation() {
+    Operation operation = pending_operations.back().operation;
+    pending_operations.pop_back();
+    // Right operand is complete, so if it and the token before it are numbers, they are both operands
+    size_t token_count = tokens.size();
+    if (
+        token_count >= 2
+        && tokens[token_count - 2].type == LexemType::NUMBER && tokens[token_count - 1].type == LexemType::NUMBER
+    ) {
+        Result<Number> value = tryApplyOperation(operation, tokens[token_count - 2].number, tokens[token_count - 1].number);
+        if (value.isOk()) {
+            tokens.pop_back();
+            tokens.back() = value.getValue();
+            return;
         }
+    }
+    tokens.push_back(operation);
+}
 
-    } catch (const std::exception &exception) {
-        return makeErrorExpression(exception.what());
+void PostfixCompiler::pushOperand(const Token &token) {
+    if (!is_operand_expected) {
+        fail(ErrorCode::OPERATION_IN_WRONG_PLACE);
+    }
+    if (status.isOk()) {
+        tokens.push_back(token);
+        is_operand_expected = false;
     }
 }
 
+void PostfixCompiler::pushOperation(Operation operation) {
+    if (is_operand_expected) {
+        fail(ErrorCode::OPERATION_IN_WRONG_PLACE);
+    }
+    if (!status.isOk()) {
+        return;
+    }
+    // Operations are left-associative
+    while (
+        !pending_operations.empty() && !pending_operations.back().is_parenthesis
+        && getOperationPrecedence(pending_operations.back().operation) >= getOperationPrecedence(operation)
+    ) {
+        popPendingOperation();
+    }
+    pending_operations.push_back({operation, false});
+    is_operand_expected = true;
+}
 
-int calculateArithmeticExpression(const Expression &expression) {
-    int result = 0;
-    bool is_result_defined = false;
-    LexemType last_lexem_type = LexemType::OPERATION;
-    std::shared_ptr<LexemOperation> last_operation;
+void PostfixCompiler::openParenthesis() {
+    if (!is_operand_expected) {
+        fail(ErrorCode::OPERATION_IN_WRONG_PLACE);
+    }
+    if (status.isOk()) {
+        pending_operations.push_back({Operation::ADD, true});
+    }
+}
 
-    for (const auto &lexem_pointer : expression) {
-        if (!is_result_defined || last_lexem_type == LexemType::OPERATION) {  // Operand is needed
+void PostfixCompiler::closeParenthesis() {
+    if (is_operand_expected) {
+        fail(ErrorCode::OPERATION_IN_WRONG_PLACE);
+    }
+    if (!status.isOk()) {
+        return;
+    }
+    while (!pending_operations.empty() && !pending_operations.back().is_parenthesis) {
+        popPendingOperation();
+    }
+    if (pending_operations.empty()) {
+        fail(ErrorCode::UNBALANCED_PARENTHESES);
+        return;
+    }
+    pending_operations.pop_back();
+}
+
+Result<bool> PostfixCompiler::tryFinish() {
+    if (is_operand_expected) {
+        if (!pending_operations.empty() && pending_operations.back().is_parenthesis) {
+            fail(ErrorCode::UNBALANCED_PARENTHESES);
+        } else {
+            fail(!tokens.empty() || !pending_operations.empty() ? ErrorCode::EXCESS_OPERATION : ErrorCode::EMPTY_EXPRESSION);
+        }
+    }
+    while (status.isOk() && !pending_operations.empty()) {
+        if (pending_operations.back().is_parenthesis) {
+            fail(ErrorCode::UNBALANCED_PARENTHESES);
+        } else {
+            popPendingOperation();
+        }
+    }
+    return status;
+}
+
+
+void Expression::compileInfixTokens(const std::vector<Token> &infix_tokens) {
+    std::vector<Token> postfix_tokens;
+    std::vector<PendingOperation> pending_operations;
+    PostfixCompiler compiler(postfix_tokens, pending_operations);
+    for (const auto &token : infix_tokens) {
+        if (token.type == LexemType::OPERATION) {
+            compiler.pushOperation(token.operation);
+        } else {
+            compiler.pushOperand(token);
+        }
+    }
+    Result<bool> compiled = compiler.tryFinish();
+    if (!compiled.isOk()) {
+        *this = makeErrorExpression(compiled.getError());
+        return;
+    }
+    setTokens(postfix_tokens);
+}
 
-            if (lexem_pointer->getType() == LexemType::OPERATION) {
-                throw std::invalid_argument("Operation in wrong place");
+
+Expression parseExpression(const StringRef &raw_expression, const Coordinate2D &anchor) {
+    if (raw_expression.empty()) {
+        return {};
+    }
+
+    if (raw_expression[0] == '\'') {
+
+        Expression expression(ExpressionType::TEXT);
+        expression.setText(raw_expression.substr(1));
+        return expression;
+
+    } else if (raw_expression[0] == '=') {
+
+        thread_local std::vector<Token> postfix_tokens;
+        thread_local std::vector<PendingOperation> pending_operations;
+        PostfixCompiler compiler(postfix_tokens, pending_operations);
+        LexemType lexem_type = LexemType::NUMBER;
+        // Lexems are slices of raw_expression; arguments of errors refer to it until they are interned
+        auto lexem_begin = raw_expression.begin() + 1;
+        auto tryPushOperand = [&compiler](LexemType operand_type, const char *begin, const char *end) -> Result<bool> {
+            Result<Token> token = tryParseToken(operand_type, StringRef(begin, end));
+            if (!token.isOk()) {
+                return token.getError();
             }
-            int lexem_value = 0;
-            if (lexem_pointer->getType() == LexemType::NUMBER) {
-                lexem_value = dynamic_cast<LexemNumber*>(lexem_pointer.get())->getNumber();
-            } else {
-                throw std::invalid_argument("Unimplemented lexem type");
+            compiler.pushOperand(token.getValue());
+            return true;
+        };
+        for (auto it = raw_expression.begin() + 1; it != raw_expression.end(); ++it) {
+            char character = *it;
+            // Point is part of decimal numbers
+            if (std::isalnum(character) || character == '$' || (character == '.' && NUMBER_FRACTION_DIGITS > 0)) {
+                if (it == lexem_begin) {
+                    lexem_type = (std::isdigit(character) ? LexemType::NUMBER : LexemType::CELL_REFERENCE);
+                }
+                continue;
             }
-
-            if (!is_result_defined) {
-                result = lexem_value;
-                is_result_defined = true;
+            if (character == '(' && it != lexem_begin && lexem_type == LexemType::CELL_REFERENCE) {
+                // Name before '(' is function, its call lasts till ')'
+                auto call_end = std::find(it, raw_expression.end(), ')');
+                if (call_end != raw_expression.end()) {
+                    ++call_end;
+                }
+                Result<bool> pushed = tryPushOperand(LexemType::AGGREGATE, lexem_begin, call_end);
+                if (!pushed.isOk()) {
+                    return makeErrorExpression(pushed.getError());
+                }
+                it = call_end - 1;
+                lexem_begin = call_end;
+                continue;
+            }
+            if (it != lexem_begin) {
+                Result<bool> pushed = tryPushOperand(lexem_type, lexem_begin, it);
+                if (!pushed.isOk()) {
+                    return makeErrorExpression(pushed.getError());
+                }
+            }
+            if (character == '(') {
+                compiler.openParenthesis();
+            } else if (character == ')') {
+                compiler.closeParenthesis();
             } else {
-                result = last_operation->getAction()(result, lexem_value);
+                Result<Operation> operation = tryParseOperation(StringRef(it, it + 1));
+                if (!operation.isOk()) {
+                    return makeErrorExpression(operation.getError());
+                }
+                compiler.pushOperation(operation.getValue());
             }
-
-        } else {     // Operation is needed
-
-            if (lexem_pointer->getType() != LexemType::OPERATION) {
-                throw std::invalid_argument("Operation in wrong place");
+            lexem_begin = it + 1;
+        }
+        if (lexem_begin != raw_expression.end()) {
+            Result<bool> pushed = tryPushOperand(lexem_type, lexem_begin, raw_expression.end());
+            if (!pushed.isOk()) {
+                return makeErrorExpression(pushed.getError());
             }
-            last_operation = std::make_shared<LexemOperation>(dynamic_cast<LexemOperation*>(lexem_pointer.get())->getOperation());
-
         }
+        Result<bool> compiled = compiler.tryFinish();
+        if (!compiled.isOk()) {
+            return makeErrorExpression(compiled.getError());
+        }
+        Expression expression(ExpressionType::ARITHMETIC);
+        expression.setTokens(postfix_tokens, anchor);
+        return expression;
 
-        last_lexem_type = lexem_pointer->getType();
-    }
+    } else {
 
-    if (last_lexem_type == LexemType::OPERATION) {
-        if (expression.getSize()) {
-            throw std::invalid_argument("Excess operation in the end");
-        } else {
-            throw std::invalid_argument("Empty expression");
+        Result<Number> number = tryParseNumber(raw_expression);
+        if (!number.isOk()) {
+            return makeErrorExpression(number.getError());
         }
+        Expression expression(ExpressionType::ARITHMETIC);
+        expression.pushToken(number.getValue());
+        return expression;
+
     }
+}
+
+
+Number applyOperation(Operation operation, Number left_operand, Number right_operand) {
+    return tryApplyOperation(operation, left_operand, right_operand).getValueOrThrow();
+}
+
+
+Result<Number> tryCalculateArithmeticExpression(const Expression &expression) {
+    return tryCalculateArithmeticExpression(expression, [](const Token&) -> Result<Number> {
+        return Error(ErrorCode::UNIMPLEMENTED_LEXEM_TYPE);
+    });
+}
 
-    return result;
+Number calculateArithmeticExpression(const Expression &expression) {
+    return tryCalculateArithmeticExpression(expression).getValueOrThrow();
 }
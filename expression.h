@@ -6,8 +6,15 @@
 #include <memory>
 #include <string>
 #include <functional>
+#include <stdexcept>
+#include <iterator>
+#include <cstddef>
 
+#include "utils.h"
 #include "coordinate.h"
+#include "string_pool.h"
+#include "result.h"
+#include "number.h"
 
 
 
@@ -22,7 +29,8 @@ enum class LexemType {
     TEXT,
     NUMBER,
     CELL_REFERENCE,
-    OPERATION
+    OPERATION,
+    AGGREGATE
 };
 
 enum class Operation {
@@ -32,6 +40,14 @@ enum class Operation {
     DIVIDE
 };
 
+enum class Aggregate {
+    SUM,
+    MIN,
+    MAX,
+    COUNT,
+    AVERAGE
+};
+
 
 class LexemBase {
 public:
@@ -56,19 +72,17 @@ public:
 
 
 class LexemNumber : public LexemBase {
-    int number;
+    Number number;
 public:
-    LexemNumber(int number_tmp);
+    LexemNumber(Number number_tmp);
     LexemType getType() const;
-    int getNumber() const;
+    Number getNumber() const;
     std::string getText() const;
     bool operator==(const LexemNumber &other) const;
     bool equalTo(const LexemBase *other) const;
     ~LexemNumber();
 };
 
-int parseNumber(const std::string &raw_number);
-
 
 class LexemCellReference : public LexemBase {
     Coordinate2D coordinate;
@@ -82,7 +96,9 @@ public:
     ~LexemCellReference();
 };
 
-Coordinate2D parseCoordinate(const std::string &raw_coordinate);
+Result<Coordinate2D> tryParseCoordinate(const StringRef &raw_coordinate);
+
+Coordinate2D parseCoordinate(const StringRef &raw_coordinate);
 
 
 class LexemOperation : public LexemBase {
@@ -92,53 +108,292 @@ public:
     LexemOperation(Operation &&operation_tmp);
     LexemType getType() const;
     const Operation &getOperation() const;
-    std::function<int(int, int)> getAction() const;
+    std::function<Number(Number, Number)> getAction() const;
     bool operator==(const LexemOperation &other) const;
     bool equalTo(const LexemBase *other) const;
     ~LexemOperation();
 };
 
-Operation parseOperation(const std::string &raw_operation);
+Result<Operation> tryParseOperation(const StringRef &raw_operation);
+
+Operation parseOperation(const StringRef &raw_operation);
+
+
+// Aggregate function applied to range of cells, e.g. SUM(A1:A100)
+struct AggregateCall
+{
+    Aggregate function;
+    CellRange range;
+
+    AggregateCall(Aggregate function_tmp = Aggregate::SUM, const CellRange &range_tmp = {});
+    bool operator==(const AggregateCall &other) const;
+};
+
+
+class LexemAggregate : public LexemBase {
+    AggregateCall call;
+public:
+    LexemAggregate(const AggregateCall &call_tmp);
+    LexemType getType() const;
+    const AggregateCall &getCall() const;
+    bool operator==(const LexemAggregate &other) const;
+    bool equalTo(const LexemBase *other) const;
+    ~LexemAggregate();
+};
 
+// Call of SUM, MIN, MAX, COUNT or AVG (in any case) with range or single cell argument
+Result<AggregateCall> tryParseAggregateCall(const StringRef &raw_call);
 
+AggregateCall parseAggregateCall(const StringRef &raw_call);
+
+
+// Lexem of arithmetic expression stored by value: tagged union instead of polymorphic LexemBase
+struct Token
+{
+    LexemType type;
+    union {
+        Number number;
+        Coordinate2D coordinate;
+        Operation operation;
+        // Bytes of aggregate call interned in StringPool, so tokens stay as small as references
+        InternedString aggregate_record;
+    };
+
+    Token(Number number_tmp = 0);
+    Token(const Coordinate2D &coordinate_tmp);
+    Token(Operation operation_tmp);
+    Token(const AggregateCall &aggregate_tmp);
+    // Call of AGGREGATE token
+    AggregateCall getAggregate() const;
+    bool operator==(const Token &other) const;
+};
+
+
+struct CompiledFormula;
+
+
+// Expression keeps its lexems as tokens; tokens of parsed ARITHMETIC expression are in postfix order,
+// e.g. =(A1+2)*3 is A1 2 + 3 *, and parts of them without references are folded into numbers.
+// Tokens of formulas are shared through FormulaPool with references relative to anchor cell,
+// and a single token, e.g. value of calculated cell, is stored in place.
+// Text of TEXT expressions and argument of error of ERROR ones are interned, so repeated labels are stored once.
+// Lexem* classes remain as compatibility view, see pushLexem and getLexems
 class Expression
 {
     ExpressionType type;
-    std::vector<std::shared_ptr<LexemBase>> lexems;
-    using LexemIterator = std::vector<std::shared_ptr<LexemBase>>::iterator;
-    using LexemConstIterator = std::vector<std::shared_ptr<LexemBase>>::const_iterator;
+    ErrorCode error_code;
+    InternedString text;
+    // Shared tokens or nullptr if the only token, if any, is in place
+    const CompiledFormula *formula;
+    bool has_inline_token;
+    union {
+        Token inline_token;
+        // Cell which relative references of formula are counted from
+        Coordinate2D anchor;
+    };
+
+    // Reorders infix tokens of ARITHMETIC expression into postfix order, ill-formed expression becomes ERROR
+    void compileInfixTokens(const std::vector<Token> &infix_tokens);
 public:
+    // Iterates over tokens with absolute references
+    class TokenIterator
+    {
+        const Token *position;
+        Coordinate2D anchor;
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Token*;
+        using reference = Token;
+
+        TokenIterator(const Token *position_tmp, const Coordinate2D &anchor_tmp) : position(position_tmp), anchor(anchor_tmp) {}
+
+        Token operator*() const {
+            Token token = *position;
+            if (token.type == LexemType::CELL_REFERENCE) {
+                token.coordinate.row += anchor.row;
+                token.coordinate.column += anchor.column;
+            }
+            return token;
+        }
+        TokenIterator &operator++() {
+            ++position;
+            return *this;
+        }
+        bool operator==(const TokenIterator &other) const {
+            return position == other.position;
+        }
+        bool operator!=(const TokenIterator &other) const {
+            return position != other.position;
+        }
+    };
+
     Expression(ExpressionType type_tmp = ExpressionType::NONE);
 
-    // Construct expression with given type and args of lexems constructor
+    // Construct expression with given type and args of lexems vector constructor;
+    // lexems of ARITHMETIC expression are in infix order and compiled like parsed ones
     template <typename... LexemsArgs>
     Expression(ExpressionType type_tmp, LexemsArgs&&... lexems_args);
 
     ExpressionType getType() const;
     size_t getSize() const;
-    void pushLexem(std::shared_ptr<LexemBase> lexem_pointer);
-    LexemIterator begin();
-    LexemIterator end();
-    LexemConstIterator begin() const;
-    LexemConstIterator end() const;
+    // Arithmetic expression of single number, e.g. calculated value
+    bool isNumber() const;
+    // Value of number expression, see isNumber
+    Number getNumber() const;
+    // Shared tokens of formula of several tokens or nullptr
+    const CompiledFormula *getFormula() const;
+    // Cell which references of shared formula are counted from, valid if getFormula() is not nullptr
+    const Coordinate2D &getAnchor() const;
+    // Replaces tokens by formula from FormulaPool, e.g. one restored from snapshot
+    void setFormula(const CompiledFormula *formula_tmp, const Coordinate2D &anchor_tmp);
+    // Text of TEXT expression or argument of error of ERROR one
+    StringRef getText() const;
+    void setText(const StringRef &text_tmp);
+    Error getError() const;
+    void setError(const Error &error);
+    // Printed value of ERROR expression
+    std::string getErrorMessage() const;
+    // Replaces tokens by given postfix ones with absolute references; several tokens are stored relative to anchor
+    void setTokens(const std::vector<Token> &tokens, const Coordinate2D &anchor_tmp = {});
+    // Token is appended as is, so tokens of ARITHMETIC expression should be pushed in postfix order;
+    // appending to several tokens copies them, so long formulas should be set at once by setTokens
+    void pushToken(const Token &token);
+    void pushLexem(const std::shared_ptr<LexemBase> &lexem_pointer);
+    std::vector<std::shared_ptr<LexemBase>> getLexems() const;
+    TokenIterator begin() const;
+    TokenIterator end() const;
     bool operator==(const Expression &other) const;
 };
 
 
+// Token of lexem other than TEXT one
+Token makeToken(const LexemBase &lexem);
+
 // Parse lexem of given type from given string and return pointer to it
 std::shared_ptr<LexemBase> makeLexemPointer(LexemType lexem_type, const std::string &raw_lexem);
 
+Expression makeErrorExpression(const Error &error);
+
 Expression makeErrorExpression(const std::string &error_message);
 
-Expression parseExpression(const std::string &raw_expression);
+// References of formula are stored relative to anchor, which should be cell of expression,
+// so the same formula copied along row or column is stored once
+Expression parseExpression(const StringRef &raw_expression, const Coordinate2D &anchor = {});
+
+// Inline, as it is applied in loop of evaluation; overflow is ARITHMETIC_OVERFLOW error
+inline Result<Number> tryApplyOperation(Operation operation, Number left_operand, Number right_operand);
+
+Number applyOperation(Operation operation, Number left_operand, Number right_operand);
+
+// Evaluates postfix tokens in one pass with stack of operands; values of cell references and aggregates
+// are given by resolve_operand(token), which returns Result<Number>
+template <typename OperandResolver>
+Result<Number> tryCalculateArithmeticExpression(const Expression &expression, OperandResolver &&resolve_operand);
+
+Result<Number> tryCalculateArithmeticExpression(const Expression &expression);
 
-int calculateArithmeticExpression(const Expression &expression);
+Number calculateArithmeticExpression(const Expression &expression);
 
 
 
 template <typename... LexemsArgs>
-Expression::Expression(ExpressionType type_tmp, LexemsArgs&&... lexems_args)
-    : type(type_tmp), lexems(std::forward<LexemsArgs>(lexems_args)...) {}
+Expression::Expression(ExpressionType type_tmp, LexemsArgs&&... lexems_args) : Expression(type_tmp) {
+    std::vector<Token> lexem_tokens;
+    for (const auto &lexem_pointer : std::vector<std::shared_ptr<LexemBase>>(std::forward<LexemsArgs>(lexems_args)...)) {
+        if (lexem_pointer->getType() == LexemType::TEXT) {
+            pushLexem(lexem_pointer);
+        } else {
+            lexem_tokens.push_back(makeToken(*lexem_pointer));
+        }
+    }
+    if (type == ExpressionType::ARITHMETIC) {
+        compileInfixTokens(lexem_tokens);
+    } else if (!lexem_tokens.empty()) {
+        setTokens(lexem_tokens);
+    }
+}
+
+
+inline Result<Number> tryApplyOperation(Operation operation, Number left_operand, Number right_operand) {
+    switch (operation) {
+    case Operation::ADD:
+        return tryAddNumbers(left_operand, right_operand);
+    case Operation::SUBTRACT:
+        return trySubtractNumbers(left_operand, right_operand);
+    case Operation::MULTIPLY:
+        return tryMultiplyNumbers(left_operand, right_operand);
+    case Operation::DIVIDE:
+        return tryDivideNumbers(left_operand, right_operand);
+    }
+    return Error(ErrorCode::UNIMPLEMENTED_OPERATION);
+}
+
+
+// Evaluates postfix tokens with given memory for operands below the top one, which should fit all of them
+template <typename OperandResolver>
+Result<Number> tryCalculatePostfixTokens(
+    const Expression &expression, Number *lower_operands, OperandResolver &resolve_operand
+) {
+    // The top operand is kept apart, so it stays in register like result of left to right evaluation
+    Number top_operand = 0;
+    size_t operand_count = 0;
+
+    for (const auto &token : expression) {
+        switch (token.type) {
+        case LexemType::NUMBER:
+            lower_operands[operand_count] = top_operand;
+            top_operand = token.number;
+            ++operand_count;
+            break;
+        case LexemType::CELL_REFERENCE:
+        case LexemType::AGGREGATE: {
+            Result<Number> resolved_operand = resolve_operand(token);
+            if (!resolved_operand.isOk()) {
+                return resolved_operand;
+            }
+            lower_operands[operand_count] = top_operand;
+            top_operand = resolved_operand.getValue();
+            ++operand_count;
+            break;
+        }
+        case LexemType::OPERATION: {
+            // Order of parsed tokens is checked by parser, only tokens pushed by hand may lack operands
+            if (operand_count < 2) {
+                return Error(ErrorCode::OPERATION_IN_WRONG_PLACE);
+            }
+            --operand_count;
+            Result<Number> operation_result = tryApplyOperation(token.operation, lower_operands[operand_count], top_operand);
+            if (!operation_result.isOk()) {
+                return operation_result;
+            }
+            top_operand = operation_result.getValue();
+            break;
+        }
+        default:
+            return Error(ErrorCode::UNIMPLEMENTED_LEXEM_TYPE);
+        }
+    }
+
+    if (operand_count != 1) {
+        return Error(operand_count ? ErrorCode::OPERATION_IN_WRONG_PLACE : ErrorCode::EMPTY_EXPRESSION);
+    }
+    return top_operand;
+}
+
+
+template <typename OperandResolver>
+Result<Number> tryCalculateArithmeticExpression(const Expression &expression, OperandResolver &&resolve_operand) {
+    // Usual short formulas keep their operands on call stack
+    const size_t inline_operand_count = 64;
+    if (expression.getSize() <= inline_operand_count) {
+        Number lower_operands[inline_operand_count];
+        return tryCalculatePostfixTokens(expression, lower_operands, resolve_operand);
+    }
+    std::vector<Number> lower_operands(expression.getSize());
+    return tryCalculatePostfixTokens(expression, lower_operands.data(), resolve_operand);
+}
 
 
 #endif // EXPRESSION_H_INCLUDED
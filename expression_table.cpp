@@ -1,156 +1,484 @@
 #include <iostream>
 #include <vector>
-#include <set>
 #include <stdexcept>
-#include <sstream>
 #include <memory>
 #include <algorithm>
 #include <string>
 #include <functional>
+#include <limits>
+#include <cctype>
+#include <utility>
+#include <cstdio>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
 #include "expression_table.h"
+#include "dependency_graph.h"
+#include "range_aggregator.h"
+#include "value_cache.h"
 #include "sparse_table.h"
 #include "sparse_table.cpp"
 #include "expression.h"
+#include "formula_pool.h"
+#include "stats.h"
 #include "logger.h"
 
 
 
-TextTable readTextTable(std::istream &in_stream) {
-    int height, width;
-
-    if (!(in_stream >> height >> width)) {
-        throw std::invalid_argument("First input line should contain two integers: table height and width");
+// Reads integer as "in_stream >> number" does: after whitespace, with optional sign, fails on overflow
+bool scanNumber(const char *&position, const char *end, int &number) {
+    while (position != end && std::isspace(static_cast<unsigned char>(*position))) {
+        ++position;
+    }
+    bool is_negative = false;
+    if (position != end && (*position == '+' || *position == '-')) {
+        is_negative = (*position == '-');
+        ++position;
+    }
+    if (position == end || !std::isdigit(static_cast<unsigned char>(*position))) {
+        return false;
     }
 
-    if (height < 0 || width < 0) {
-        throw std::invalid_argument("Table height and width should be positive integers");
+    long long value = 0;
+    bool is_overflow = false;
+    for (; position != end && std::isdigit(static_cast<unsigned char>(*position)); ++position) {
+        value = value * 10 + (*position - '0');
+        if (value > std::numeric_limits<int>::max() + 1LL) {
+            is_overflow = true;
+            value = 0;
+        }
     }
-    if (height == 0 || width == 0) {
-        log_warn("Table height or width is 0, do nothing");
-        return {};
+    value = (is_negative ? -value : value);
+    if (is_overflow || value > std::numeric_limits<int>::max() || value < std::numeric_limits<int>::min()) {
+        return false;
     }
+    number = static_cast<int>(value);
+    return true;
+}
 
-    TextTable table(height, width);
-    std::string temp;
 
-    if (!getline(in_stream, temp)) {
-        log_warn("Table has 0 rows instead of ", height);
-        return table;
+// Splits input into cells piece by piece: calls startTable(height, width) once size is known, then
+// addCell(coordinate, cell) for every non-empty cell in row-major order.
+// Warnings and recovery from malformed input are the same as when input stream is read line by line;
+// warnings are not reported again if input was scanned already
+class TextTableScanner
+{
+    bool is_reported;
+    bool is_started;
+    bool is_finished;
+    int height;
+    int width;
+    // The first row which is not scanned yet
+    int row_index;
+public:
+    explicit TextTableScanner(bool is_reported_tmp = true)
+        : is_reported(is_reported_tmp), is_started(false), is_finished(false), height(0), width(0), row_index(0) {}
+
+    bool isFinished() const {
+        return is_finished;
     }
-    if (!temp.empty()) {
-        log_warn("Excess information in first line, ignore it");
+
+    // Scans text of [position, end) following text scanned before, returns end of scanned text.
+    // Unless text is the rest of input, it should end at the end of line, see findLinesEnd;
+    // its last line and incomplete header are left to be scanned with text read later
+    template <typename TableStarter, typename CellAdder>
+    const char *scan(const char *position, const char *end, bool is_last, TableStarter &&startTable, CellAdder &&addCell);
+};
+
+
+template <typename TableStarter, typename CellAdder>
+const char *TextTableScanner::scan(
+    const char *position, const char *end, bool is_last, TableStarter &&startTable, CellAdder &&addCell
+) {
+    if (is_finished) {
+        return end;
     }
+    LineCellReader reader(position, end);
 
-    for (int row_index = 0; row_index < height; ++row_index) {
-        std::string raw_row;
+    if (!is_started) {
+        const char *header_end = position;
+        bool is_header_read = scanNumber(header_end, end, height) && scanNumber(header_end, end, width);
+        if (!is_last && header_end == end) {
+            return position;
+        }
+        if (!is_header_read) {
+            throw std::invalid_argument("First input line should contain two integers: table height and width");
+        }
 
-        if (!getline(in_stream, raw_row) && row_index < height - 1) {
-            log_warn("Table has ", row_index + 1, " rows instead of ", height);
-            break;
+        if (height < 0 || width < 0) {
+            throw std::invalid_argument("Table height and width should be positive integers");
         }
+        is_started = true;
+        is_finished = true;
+        if (height == 0 || width == 0) {
+            log_warn("Table height or width is 0, do nothing");
+            return end;
+        }
+
+        startTable(height, width);
+        // Stream reaches its end while reading width if nothing follows it
+        reader = LineCellReader(header_end, end, header_end == end);
 
-        std::stringstream row_stream(raw_row);
+        if (!reader.nextLine()) {
+            if (is_reported) {
+                log_warn("Table has 0 rows instead of ", height);
+            }
+            return end;
+        }
+        if (!reader.isLineEmpty() && is_reported) {
+            log_warn("Excess information in first line, ignore it");
+        }
+        is_finished = false;
+    }
+
+    for (; row_index < height; ++row_index) {
+        bool is_line_read = reader.nextLine();
+        if (!is_last && reader.isLineAtEnd()) {
+            return end;
+        }
+        if (!is_line_read && row_index < height - 1) {
+            if (is_reported) {
+                log_warn("Table has ", row_index + 1, " rows instead of ", height);
+            }
+            break;
+        }
 
         for (int column_index = 0; column_index < width; ++column_index) {
-            std::string cell;
+            StringRef cell;
 
-            if (!std::getline(row_stream, cell, '\t') && column_index < width - 1) {
-                log_warn("Row ", row_index + 1, " has ", column_index + 1, " cells instead of ", width);
+            if (!reader.nextCell(cell) && column_index < width - 1) {
+                if (is_reported) {
+                    log_warn("Row ", row_index + 1, " has ", column_index + 1, " cells instead of ", width);
+                }
                 break;
             }
             if (!cell.empty()) {
-                table(row_index, column_index) = cell;
+                addCell(Coordinate2D(row_index, column_index), cell);
             }
         }
     }
+    is_finished = true;
+    return end;
+}
+
+
+// Scans the whole input at once, see TextTableScanner
+template <typename TableStarter, typename CellAdder>
+void scanTextTable(
+    const char *position, const char *end, TableStarter &&startTable, CellAdder &&addCell, bool is_reported = true
+) {
+    TextTableScanner scanner(is_reported);
+    scanner.scan(position, end, true, startTable, addCell);
+}
+
 
+TextTable readTextTable(std::istream &in_stream) {
+    InputBuffer input(in_stream);
+    return readTextTable(input);
+}
+
+
+TextTable readTextTable(const InputBuffer &input) {
+    TextTable table;
+    scanTextTable(
+        input.begin(), input.end(),
+        [&table](int height, int width) {
+            table = TextTable(height, width);
+        },
+        [&table](const Coordinate2D &coordinate, const StringRef &cell) {
+            table(coordinate) = cell.toString();
+        }
+    );
     return table;
 }
 
 
+ExpressionTable::ExpressionTable(int height_tmp, int width_tmp)
+    : ExpressionTable(height_tmp, width_tmp, CellPoolsScope::getCurrentPools()) {}
+
+
+ExpressionTable::ExpressionTable(int height_tmp, int width_tmp, const std::shared_ptr<CellPools> &pools_tmp)
+    : CellTable(height_tmp, width_tmp), pools(pools_tmp) {}
+
+
+ExpressionTable::ExpressionTable(CellTable table) : CellTable(std::move(table)), pools(CellPoolsScope::getCurrentPools()) {}
+
+
+const std::shared_ptr<CellPools> &ExpressionTable::getPools() const {
+    return pools;
+}
+
+
+// Parses cells concurrently, every block of cells into its own part of expressions vector;
+// then parsed cells are moved to table in their original order by one thread.
+// Cells are interned into new pools of table
+ExpressionTable parseCells(
+    int height, int width,
+    const std::vector<Coordinate2D> &coordinates, const std::vector<StringRef> &raw_cells,
+    ThreadPool &thread_pool
+) {
+    StatsStageTimer timer(StatsStage::PARSE);
+    addStatsCounter(StatsCounter::CELLS, raw_cells.size());
+    auto pools = std::make_shared<CellPools>();
+    std::vector<Expression> expressions(raw_cells.size());
+    thread_pool.parallelFor(0, static_cast<int>(raw_cells.size()), [&expressions, &coordinates, &raw_cells, &pools](int begin, int end) {
+        CellPoolsScope scope(pools);
+        for (size_t cell_index = static_cast<size_t>(begin); cell_index < static_cast<size_t>(end); ++cell_index) {
+            expressions[cell_index] = parseExpression(raw_cells[cell_index], coordinates[cell_index]);
+        }
+    });
+
+    ExpressionTable parsed_table(height, width, pools);
+    parsed_table.reserve(static_cast<int>(expressions.size()));
+    for (size_t cell_index = 0; cell_index < expressions.size(); ++cell_index) {
+        parsed_table(coordinates[cell_index]) = std::move(expressions[cell_index]);
+    }
+    return parsed_table;
+}
+
+
+// Cells of input parsed as readParsedTable does, warnings are not reported if input was scanned already
+ExpressionTable scanParsedTable(const InputBuffer &input, ThreadPool &thread_pool, bool is_reported) {
+    int table_height = 0;
+    int table_width = 0;
+    std::vector<Coordinate2D> coordinates;
+    std::vector<StringRef> raw_cells;
+    scanTextTable(
+        input.begin(), input.end(),
+        [&table_height, &table_width](int height, int width) {
+            table_height = height;
+            table_width = width;
+        },
+        [&coordinates, &raw_cells](const Coordinate2D &coordinate, const StringRef &cell) {
+            coordinates.push_back(coordinate);
+            raw_cells.push_back(cell);
+        },
+        is_reported
+    );
+    return parseCells(table_height, table_width, coordinates, raw_cells, thread_pool);
+}
+
+
+ExpressionTable readParsedTable(const InputBuffer &input) {
+    ThreadPool serial_pool(1);
+    return readParsedTable(input, serial_pool);
+}
+
+
+ExpressionTable readParsedTable(const InputBuffer &input, ThreadPool &thread_pool) {
+    return scanParsedTable(input, thread_pool, true);
+}
+
+
 ExpressionTable parseRawTable(const TextTable &raw_table) {
-    ExpressionTable parsed_table(raw_table.getHeight(), raw_table.getWidth());
+    ThreadPool serial_pool(1);
+    return parseRawTable(raw_table, serial_pool);
+}
+
+
+ExpressionTable parseRawTable(const TextTable &raw_table, ThreadPool &thread_pool) {
+    std::vector<Coordinate2D> coordinates;
+    std::vector<StringRef> raw_cells;
     for (const auto &cell_pair : raw_table.getElements()) {
-        parsed_table(cell_pair.first) = parseExpression(cell_pair.second);
+        coordinates.push_back(cell_pair.first);
+        raw_cells.push_back(cell_pair.second);
     }
-    return parsed_table;
+    return parseCells(raw_table.getHeight(), raw_table.getWidth(), coordinates, raw_cells, thread_pool);
 }
 
 
-int getProcessedArithmeticExpressionValue(const Expression &expression) {
+Result<Number> tryGetProcessedArithmeticExpressionValue(const Expression &expression) {
     if (expression.getType() == ExpressionType::ERROR) {
-        throw std::invalid_argument("Error in referred cell");
+        return Error(ErrorCode::ERROR_IN_REFERRED_CELL);
     } else if (expression.getType() != ExpressionType::ARITHMETIC) {
-        throw std::invalid_argument("Not a number in referred cell");
-    } else if (expression.getSize() != 1 || (*expression.begin())->getType() != LexemType::NUMBER) {
-        throw std::logic_error("Infinite cycle in references");
+        return Error(ErrorCode::NOT_A_NUMBER_IN_REFERRED_CELL);
+    } else if (!expression.isNumber()) {
+        return Error(ErrorCode::INFINITE_CYCLE);
     } else {
-        return dynamic_cast<LexemNumber*>(expression.begin()->get())->getNumber();
+        return expression.getNumber();
     }
 }
 
 
-void calculateCell(ExpressionTable &table, std::set<Coordinate2D> &visited_coordinates, const Coordinate2D &coordinate) {
-    visited_coordinates.insert(coordinate);
-    Expression &current_expression = table(coordinate);
-
-    try {
+Number getProcessedArithmeticExpressionValue(const Expression &expression) {
+    return tryGetProcessedArithmeticExpressionValue(expression).getValueOrThrow();
+}
 
-        Expression new_expression;
-        for (const auto &lexem_pointer : current_expression) {
-            if (lexem_pointer->getType() == LexemType::CELL_REFERENCE) {
 
-                auto referred_coordinate = dynamic_cast<LexemCellReference*>(lexem_pointer.get())->getCoordinate();
-                const auto &referred_expression = table(referred_coordinate);
-                if (visited_coordinates.count(referred_coordinate) == 0 && referred_expression.getType() == ExpressionType::ARITHMETIC) {
-                    calculateCell(table, visited_coordinates, referred_coordinate);
-                }
-                new_expression.pushLexem(std::make_shared<LexemNumber>(getProcessedArithmeticExpressionValue(referred_expression)));
+// Referred cell and aggregate over range for both kinds of tables of calculated values
+Result<Number> tryGetReferredValue(const ExpressionTable &values, const Coordinate2D &coordinate) {
+    // Read-only lookup, so references to empty cells do not insert them
+    return tryGetProcessedArithmeticExpressionValue(values(coordinate));
+}
 
-            } else {
+Result<Number> tryGetReferredValue(const ValueCache &values, const Coordinate2D &coordinate) {
+    return values.tryGetNumber(coordinate);
+}
 
-                new_expression.pushLexem(lexem_pointer);
 
+template <typename Values>
+Expression calculateExpressionOver(
+    const Expression &expression, const Values &values, const RangeAggregator *aggregator
+) {
+    // Values of references and aggregates are resolved before evaluation, so errors of referred cells take priority
+    thread_local std::vector<Number> reference_values;
+    reference_values.clear();
+    for (const auto &token : expression) {
+        Result<Number> value = 0;
+        // Counted before lookup, so references ending calculation with error are counted too
+        if (token.type == LexemType::CELL_REFERENCE || token.type == LexemType::AGGREGATE) {
+            addStatsCounter(StatsCounter::REFERENCES, 1);
+        }
+        if (token.type == LexemType::CELL_REFERENCE) {
+            const auto &coordinate = token.coordinate;
+            if (!values.isInRange(coordinate)) {
+                return makeErrorExpression(makeOutOfRangeMessage(coordinate, values.getHeight(), values.getWidth()));
             }
+            value = tryGetReferredValue(values, coordinate);
+        } else if (token.type == LexemType::AGGREGATE) {
+            AggregateCall call = token.getAggregate();
+            for (const auto &corner : {call.range.first, call.range.last}) {
+                if (!values.isInRange(corner)) {
+                    return makeErrorExpression(makeOutOfRangeMessage(corner, values.getHeight(), values.getWidth()));
+                }
+            }
+            value = (aggregator ? aggregator->tryAggregate(call) : tryAggregateRange(call, values));
+        } else {
+            continue;
+        }
+        if (!value.isOk()) {
+            return makeErrorExpression(value.getError());
         }
+        reference_values.push_back(value.getValue());
+    }
 
-        current_expression = Expression(ExpressionType::ARITHMETIC);
-        current_expression.pushLexem(std::make_shared<LexemNumber>(calculateArithmeticExpression(new_expression)));
+    size_t next_value_index = 0;
+    Result<Number> value = tryCalculateArithmeticExpression(expression, [&next_value_index](const Token&) {
+        return Result<Number>(reference_values[next_value_index++]);
+    });
+    if (!value.isOk()) {
+        return makeErrorExpression(value.getError());
+    }
 
-    } catch (const std::exception &exception) {
-        current_expression = makeErrorExpression(exception.what());
+    Expression calculated_expression(ExpressionType::ARITHMETIC);
+    calculated_expression.pushToken(value.getValue());
+    return calculated_expression;
+}
+
+
+Expression calculateExpression(const Expression &expression, const ExpressionTable &values) {
+    return calculateExpressionOver(expression, values, nullptr);
+}
+
+Expression calculateExpression(const Expression &expression, const ValueCache &values, const RangeAggregator *aggregator) {
+    return calculateExpressionOver(expression, values, aggregator);
+}
+
+
+void calculateCell(
+    ExpressionTable &table, ValueCache &values, const Coordinate2D &coordinate, const RangeAggregator *aggregator
+) {
+    // Cell is looked up without insertion, so cells may be calculated concurrently
+    Expression *expression_pointer = table.tryGet(coordinate);
+    if (expression_pointer) {
+        *expression_pointer = calculateExpression(*expression_pointer, values, aggregator);
+        values.set(coordinate, *expression_pointer);
     }
 }
 
 
 void calculateParsedTable(ExpressionTable &table) {
-    std::set<Coordinate2D> visited_coordinates;
+    ThreadPool serial_pool(1);
+    calculateParsedTable(table, serial_pool);
+}
+
 
+void calculateParsedTable(ExpressionTable &table, ThreadPool &thread_pool) {
+    DependencyGraph graph(table);
+    std::vector<bool> is_calculated(static_cast<size_t>(graph.getCellCount()), false);
+    addStatsCounter(StatsCounter::FORMULAS, static_cast<uint64_t>(graph.getCellCount()));
+
+    // Only cells of graph change during calculation, so ranges of aggregates are summarized beforehand
+    std::vector<CellRange> ranges;
+    std::vector<bool> is_column_referred(static_cast<size_t>(table.getWidth()), false);
     for (const auto &cell_pair : table.getElements()) {
-        const auto &coordinate = cell_pair.first;
-        const auto &expression = cell_pair.second;
-        if (visited_coordinates.count(coordinate)) {
-            continue;
+        for (const auto &token : cell_pair.second) {
+            if (token.type == LexemType::CELL_REFERENCE) {
+                int column = token.coordinate.column;
+                if (column >= 0 && column < table.getWidth()) {
+                    is_column_referred[static_cast<size_t>(column)] = true;
+                }
+            } else if (token.type == LexemType::AGGREGATE) {
+                const auto &range = token.getAggregate().range;
+                ranges.push_back(range);
+                int last_column = std::min(range.last.column, table.getWidth() - 1);
+                for (int column = std::max(range.first.column, 0); column <= last_column; ++column) {
+                    is_column_referred[static_cast<size_t>(column)] = true;
+                }
+            }
+        }
+    }
+    // References are resolved through columns of cached values rather than through expressions of table;
+    // only columns formulas refer to are cached, results themselves stay in table
+    ValueCache values(table, is_column_referred);
+    std::unique_ptr<RangeAggregator> aggregator;
+    if (!ranges.empty()) {
+        aggregator = std::make_unique<RangeAggregator>(values, ranges);
+    }
+
+    // Calculates all cells which do not depend on cycles, level by level
+    auto calculateLevels = [&graph, &table, &values, &thread_pool, &is_calculated, &aggregator]() {
+        std::vector<int> level_offsets;
+        auto order = graph.sortTopologically(is_calculated, &level_offsets);
+        raiseStatsCounter(StatsCounter::DEPENDENCY_DEPTH, level_offsets.size() - 1);
+        for (size_t level_index = 0; level_index + 1 < level_offsets.size(); ++level_index) {
+            thread_pool.parallelFor(level_offsets[level_index], level_offsets[level_index + 1], [&](int begin, int end) {
+                // Messages of errors are interned into pools of table rather than into pools of the whole run
+                CellPoolsScope scope(table.getPools());
+                for (int order_position = begin; order_position < end; ++order_position) {
+                    calculateCell(table, values, graph.getCoordinate(order[static_cast<size_t>(order_position)]), aggregator.get());
+                }
+            });
         }
-        if (expression.getType() == ExpressionType::ARITHMETIC) {
-            calculateCell(table, visited_coordinates, coordinate);
+        for (int cell_index : order) {
+            is_calculated[static_cast<size_t>(cell_index)] = true;
         }
+    };
+
+    calculateLevels();
+
+    // Remaining cells lie on reference cycles or depend on them
+    CellPoolsScope scope(table.getPools());
+    auto cycle_cells = graph.findCycleCells(is_calculated);
+    addStatsCounter(StatsCounter::CYCLE_CELLS, cycle_cells.size());
+    for (int cell_index : cycle_cells) {
+        const auto &coordinate = graph.getCoordinate(cell_index);
+        table(coordinate) = makeErrorExpression(ErrorCode::INFINITE_CYCLE);
+        values.set(coordinate, table(coordinate));
+        is_calculated[static_cast<size_t>(cell_index)] = true;
     }
+    calculateLevels();
 }
 
 
 TextTable makePrintedTable(const ExpressionTable &table) {
+    StatsStageTimer timer(StatsStage::FORMAT);
     TextTable printed_table(table.getHeight(), table.getWidth());
 
     for (const auto &cell_pair : table.getElements()) {
         const auto &coordinate = cell_pair.first;
         const auto &expression = cell_pair.second;
         if (expression.getType() == ExpressionType::NONE) {
-        } else if (expression.getType() == ExpressionType::TEXT || expression.getType() == ExpressionType::ERROR) {
-            printed_table(coordinate) = dynamic_cast<LexemText*>(expression.begin()->get())->getText();
-        } else if (expression.getType() == ExpressionType::ARITHMETIC && expression.getSize() == 1) {
-            printed_table(coordinate) = dynamic_cast<LexemNumber*>(expression.begin()->get())->getText();
+        } else if (expression.getType() == ExpressionType::TEXT) {
+            printed_table(coordinate) = expression.getText().toString();
+        } else if (expression.getType() == ExpressionType::ERROR) {
+            printed_table(coordinate) = expression.getErrorMessage();
+        } else if (expression.isNumber()) {
+            printed_table(coordinate) = formatNumber(expression.getNumber());
         } else {
             printed_table(coordinate) = makeErrorMessage("Illegal expression");
         }
@@ -160,11 +488,230 @@ TextTable makePrintedTable(const ExpressionTable &table) {
 }
 
 
+// Prints cells of rows [begin_row, end_row) of table row by row separated by tabs;
+// runs of empty cells are filled at once
+template <typename Table, typename CellPrinter>
+void printCells(const Table &table, int begin_row, int end_row, OutputBuffer &output, CellPrinter &&printCell) {
+    if (table.getWidth() == 0) {
+        return;
+    }
+
+    int row_index = begin_row;
+    // Column of the last printed cell, tabs before it are printed already
+    int column_index = 0;
+    auto finishRow = [&table, &output, &row_index, &column_index]() {
+        output.appendRepeated('\t', static_cast<size_t>(table.getWidth() - 1 - column_index));
+        output.append('\n');
+        ++row_index;
+        column_index = 0;
+    };
+
+    for (const auto &cell_pair : table.getElements()) {
+        if (cell_pair.first.row < begin_row) {
+            continue;
+        } else if (cell_pair.first.row >= end_row) {
+            break;
+        }
+        while (row_index < cell_pair.first.row) {
+            finishRow();
+        }
+        output.appendRepeated('\t', static_cast<size_t>(cell_pair.first.column - column_index));
+        column_index = cell_pair.first.column;
+        printCell(cell_pair.second);
+    }
+    while (row_index < end_row) {
+        finishRow();
+    }
+}
+
+
 void printTextTable(const TextTable &table, std::ostream &out_stream) {
-    for (const auto &row : table.flatten()) {
-        int column_index = 0;
-        for (const auto &cell : row) {
-            out_stream << cell << (++column_index == table.getWidth() ? '\n' : '\t');
+    OutputBuffer output(out_stream);
+    printCells(table, 0, table.getHeight(), output, [&output](const std::string &cell) {
+        output.append(cell);
+    });
+}
+
+
+void printExpressionTable(const ExpressionTable &table, OutputBuffer &output) {
+    printExpressionTableRows(table, 0, table.getHeight(), output);
+}
+
+
+void printExpressionTableRows(const ExpressionTable &table, int begin_row, int end_row, OutputBuffer &output) {
+    StatsStageTimer timer(StatsStage::FORMAT);
+    printCells(table, begin_row, end_row, output, [&output](const Expression &expression) {
+        if (expression.getType() == ExpressionType::NONE) {
+        } else if (expression.getType() == ExpressionType::TEXT) {
+            output.append(expression.getText());
+        } else if (expression.getType() == ExpressionType::ERROR) {
+            // Message is assembled right in output
+            addStatsCounter(StatsCounter::ERRORS, 1);
+            Error error = expression.getError();
+            output.append('#');
+            output.append(getErrorMessagePrefix(error.code));
+            output.append(error.argument);
+            output.append(getErrorMessageSuffix(error.code));
+        } else if (expression.isNumber()) {
+            output.append(expression.getNumber());
+        } else {
+            output.append(makeErrorMessage("Illegal expression"));
+        }
+    });
+}
+
+
+// Rows read by streamParsedTable before they are calculated, unless window is larger
+const int MIN_STREAM_BLOCK_HEIGHT = 1024;
+
+
+// Whether cells of arithmetic expression of given row refer only to that row and window_height rows above it;
+// references out of table are errors rather than references, so they do not matter
+bool isInRowWindow(const Expression &expression, int row, int window_height, const ExpressionTable &table) {
+    for (const auto &token : expression) {
+        CellRange range;
+        if (token.type == LexemType::CELL_REFERENCE) {
+            range = CellRange(token.coordinate, token.coordinate);
+        } else if (token.type == LexemType::AGGREGATE) {
+            range = token.getAggregate().range;
+        } else {
+            continue;
+        }
+        if (
+            table.isInRange(range.first) && table.isInRange(range.last)
+            && (range.first.row < row - window_height || range.last.row > row)
+        ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void streamParsedTable(int file_descriptor, int window_height, OutputBuffer &output, ThreadPool &thread_pool) {
+    // Input which cannot be read again, e.g. pipe, is copied into temporary file for the case window is exceeded
+    struct stat file_status;
+    bool is_rereadable = (
+        fstat(file_descriptor, &file_status) == 0 && S_ISREG(file_status.st_mode)
+        && lseek(file_descriptor, 0, SEEK_CUR) == 0
+    );
+    std::unique_ptr<FILE, int (*)(FILE*)> input_copy(nullptr, fclose);
+    if (!is_rereadable) {
+        input_copy.reset(tmpfile());
+        if (!input_copy) {
+            throw std::runtime_error("Cannot create temporary file for input");
+        }
+    }
+    InputReader input(file_descriptor, is_rereadable ? -1 : fileno(input_copy.get()));
+
+    int table_height = 0;
+    int table_width = 0;
+    const int block_height = std::max(window_height, MIN_STREAM_BLOCK_HEIGHT);
+    // Rows before block_begin_row are printed, the last window_height of them are kept calculated in window_table
+    int block_begin_row = 0;
+    ExpressionTable window_table;
+    // Cells of block are kept as offsets of input, as text of input moves while it is read
+    std::vector<Coordinate2D> coordinates;
+    std::vector<std::pair<size_t, size_t>> raw_cell_spans;
+    std::vector<StringRef> raw_cells;
+    bool is_window_exceeded = false;
+
+    // Block is calculated together with window before it, so calculation is the same as of the whole table
+    auto finishBlock = [&](int end_row) {
+        for (const auto &span : raw_cell_spans) {
+            raw_cells.emplace_back(input.getPosition(span.first), input.getPosition(span.second));
+        }
+        auto block_table = parseCells(table_height, table_width, coordinates, raw_cells, thread_pool);
+        coordinates.clear();
+        raw_cell_spans.clear();
+        raw_cells.clear();
+        for (const auto &cell_pair : block_table.getElements()) {
+            const auto &expression = cell_pair.second;
+            if (
+                expression.getType() == ExpressionType::ARITHMETIC && !expression.isNumber()
+                && !isInRowWindow(expression, cell_pair.first.row, window_height, block_table)
+            ) {
+                is_window_exceeded = true;
+                return;
+            }
+        }
+        for (const auto &cell_pair : window_table.getElements()) {
+            block_table(cell_pair.first) = cell_pair.second;
+        }
+
+        {
+            StatsStageTimer timer(StatsStage::EVALUATE);
+            calculateParsedTable(block_table, thread_pool);
+        }
+        // Block is written out before the next one is read, so output does not wait for the end of input
+        printExpressionTableRows(block_table, block_begin_row, end_row, output);
+        output.flush();
+
+        window_table = ExpressionTable(table_height, table_width, block_table.getPools());
+        for (const auto &cell_pair : block_table.getElements()) {
+            if (cell_pair.first.row >= end_row - window_height) {
+                window_table(cell_pair.first) = cell_pair.second;
+            }
+        }
+        block_begin_row = end_row;
+    };
+
+    // Only complete lines are scanned, text of cells of unfinished block is kept
+    TextTableScanner scanner;
+    size_t scanned_offset = 0;
+    bool is_read = true;
+    while (is_read && !scanner.isFinished()) {
+        is_read = input.read(raw_cell_spans.empty() ? scanned_offset : raw_cell_spans.front().first);
+        const char *scan_begin = input.getPosition(scanned_offset);
+        const char *scan_end = (is_read ? findLinesEnd(scan_begin, input.end()) : input.end());
+        const char *scanned_end = scanner.scan(
+            scan_begin, scan_end, !is_read,
+            [&table_height, &table_width, &window_table](int height, int width) {
+                table_height = height;
+                table_width = width;
+                window_table = ExpressionTable(height, width);
+            },
+            [&](const Coordinate2D &coordinate, const StringRef &cell) {
+                // Cells of the rest of input are only scanned, so warnings about it are reported once
+                while (!is_window_exceeded && coordinate.row >= block_begin_row + block_height) {
+                    finishBlock(block_begin_row + block_height);
+                }
+                if (!is_window_exceeded) {
+                    coordinates.push_back(coordinate);
+                    raw_cell_spans.emplace_back(input.getOffset(cell.begin()), input.getOffset(cell.end()));
+                }
+            }
+        );
+        scanned_offset = input.getOffset(scanned_end);
+    }
+    if (table_width == 0) {
+        return;
+    }
+    if (!is_window_exceeded) {
+        finishBlock(table_height);
+    }
+
+    if (is_window_exceeded) {
+        log_info(
+            "Formulas refer to rows beyond window of ", window_height,
+            " rows, rows from ", block_begin_row + 1, " are calculated with the whole table"
+        );
+        window_table = ExpressionTable();
+        // The rest of input is copied too, then the whole input is read again
+        int whole_descriptor = file_descriptor;
+        if (!is_rereadable) {
+            while (input.read(input.getOffset(input.end()))) {}
+            whole_descriptor = fileno(input_copy.get());
+        }
+        if (lseek(whole_descriptor, 0, SEEK_SET) != 0) {
+            throw std::runtime_error("Cannot read input again");
+        }
+        InputBuffer whole_input(whole_descriptor);
+        auto table = scanParsedTable(whole_input, thread_pool, false);
+        {
+            StatsStageTimer timer(StatsStage::EVALUATE);
+            calculateParsedTable(table, thread_pool);
         }
+        printExpressionTableRows(table, block_begin_row, table_height, output);
     }
 }
@@ -3,39 +3,108 @@
 
 #include <string>
 #include <iostream>
-#include <set>
+#include <memory>
 
 #include "sparse_table.h"
 #include "expression.h"
+#include "thread_pool.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
 
 
 using TextTable = SparseTable<std::string>;
 
 
+// Stream is read to its end at once, see readTextTable(const InputBuffer&)
 TextTable readTextTable(std::istream &in_stream = std::cin);
 
+// Cells are taken from input without copying lines
+TextTable readTextTable(const InputBuffer &input);
 
-using ExpressionTable = SparseTable<Expression>;
+
+struct CellPools;
+
+// Tables which are known to be dense when created are kept in chunks, see AdaptiveStorage.
+// Table holds pools its cells are interned into, so they are freed with the last table sharing them
+class ExpressionTable : public SparseTable<Expression, AdaptiveStorage<Expression>>
+{
+    // nullptr for pools of the whole run of program
+    std::shared_ptr<CellPools> pools;
+public:
+    using CellTable = SparseTable<Expression, AdaptiveStorage<Expression>>;
+
+    // Pools are the current ones of CellPoolsScope
+    ExpressionTable(int height_tmp = 0, int width_tmp = 0);
+    ExpressionTable(int height_tmp, int width_tmp, const std::shared_ptr<CellPools> &pools_tmp);
+    // Cells interned into current pools, e.g. of table made by makeSparseTable
+    ExpressionTable(CellTable table);
+
+    const std::shared_ptr<CellPools> &getPools() const;
+};
+
+class RangeAggregator;
+class ValueCache;
 
 
 ExpressionTable parseRawTable(const TextTable &raw_table);
 
+// The same, but cells are parsed concurrently on given pool
+ExpressionTable parseRawTable(const TextTable &raw_table, ThreadPool &thread_pool);
+
+// The same as parseRawTable(readTextTable(input)), but cells are parsed right from input
+ExpressionTable readParsedTable(const InputBuffer &input);
+
+ExpressionTable readParsedTable(const InputBuffer &input, ThreadPool &thread_pool);
+
+
+// Value of calculated cell referred to by arithmetic expression
+Result<Number> tryGetProcessedArithmeticExpressionValue(const Expression &expression);
 
-int getProcessedArithmeticExpressionValue(const Expression &expression);
+Number getProcessedArithmeticExpressionValue(const Expression &expression);
 
 
-// One step of DFS: calculates value of given cell
-void calculateCell(ExpressionTable &table, std::set<Coordinate2D> &visited_coordinates, const Coordinate2D &coordinate);
+// Value of arithmetic expression, cells it refers to are taken from table of calculated values
+Expression calculateExpression(const Expression &expression, const ExpressionTable &values);
+
+// The same, but cells are taken from cache of calculated values. Aggregates over ranges are
+// taken from aggregator made for values if it is given, otherwise ranges are scanned
+Expression calculateExpression(
+    const Expression &expression, const ValueCache &values, const RangeAggregator *aggregator = nullptr
+);
+
+
+// Calculates value of given cell and stores it both in table and in cache of its values,
+// all arithmetic cells it refers to should be calculated already
+void calculateCell(
+    ExpressionTable &table, ValueCache &values, const Coordinate2D &coordinate, const RangeAggregator *aggregator = nullptr
+);
 
 
 // Calculates values of all arithmetic expressions in table
 void calculateParsedTable(ExpressionTable &table);
 
+// The same, but cells of one dependency level are calculated concurrently on given pool
+void calculateParsedTable(ExpressionTable &table, ThreadPool &thread_pool);
+
 
 TextTable makePrintedTable(const ExpressionTable &table);
 
 
 void printTextTable(const TextTable &table, std::ostream &out_stream = std::cout);
 
+// The same as printTextTable(makePrintedTable(table)), but values are formatted right into output
+void printExpressionTable(const ExpressionTable &table, OutputBuffer &output);
+
+// The same for rows [begin_row, end_row) of table
+void printExpressionTableRows(const ExpressionTable &table, int begin_row, int end_row, OutputBuffer &output);
+
+
+// Reads, calculates and prints table block by block as input arrives, keeping in memory only text and cells
+// of block being read and window_height rows before it. Output is the same as of readParsedTable,
+// calculateParsedTable and printExpressionTable: if some formula refers to a row below its own one or more
+// than window_height rows above it, the rest of table is calculated together with the whole table, which is
+// read again from input file or from its copy in temporary file if input is a pipe
+void streamParsedTable(int file_descriptor, int window_height, OutputBuffer &output, ThreadPool &thread_pool);
+
 
 #endif // PROCESS_TABLE_H_INCLUDED
@@ -0,0 +1,206 @@
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+#include "coordinate.h"
+#include "flat_hash_map.h"
+
+
+template <typename ValueType>
+void FlatHashMap<ValueType>::Iterator::skipEmptySlots() {
+    while (slot < map->slots.size() && !map->is_filled[slot]) {
+        ++slot;
+    }
+}
+
+template <typename ValueType>
+FlatHashMap<ValueType>::Iterator::Iterator(const FlatHashMap *map_tmp, size_t slot_tmp) : map(map_tmp), slot(slot_tmp) {
+    skipEmptySlots();
+}
+
+template <typename ValueType>
+const typename FlatHashMap<ValueType>::Entry &FlatHashMap<ValueType>::Iterator::operator*() const {
+    return map->slots[slot];
+}
+
+template <typename ValueType>
+const typename FlatHashMap<ValueType>::Entry *FlatHashMap<ValueType>::Iterator::operator->() const {
+    return &map->slots[slot];
+}
+
+template <typename ValueType>
+typename FlatHashMap<ValueType>::Iterator &FlatHashMap<ValueType>::Iterator::operator++() {
+    ++slot;
+    skipEmptySlots();
+    return *this;
+}
+
+template <typename ValueType>
+typename FlatHashMap<ValueType>::Iterator FlatHashMap<ValueType>::Iterator::operator++(int) {
+    auto iterator_copy = *this;
+    ++*this;
+    return iterator_copy;
+}
+
+template <typename ValueType>
+bool FlatHashMap<ValueType>::Iterator::operator==(const Iterator &other) const {
+    return slot == other.slot;
+}
+
+template <typename ValueType>
+bool FlatHashMap<ValueType>::Iterator::operator!=(const Iterator &other) const {
+    return !operator==(other);
+}
+
+
+template <typename ValueType>
+FlatHashMap<ValueType>::FlatHashMap(size_t expected_count) : element_count(0) {
+    reserve(expected_count);
+}
+
+template <typename ValueType>
+size_t FlatHashMap<ValueType>::getHomeSlot(const Coordinate2D &key) const {
+    return Coordinate2DHash()(key) & (slots.size() - 1);
+}
+
+template <typename ValueType>
+size_t FlatHashMap<ValueType>::findSlot(const Coordinate2D &key) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = getHomeSlot(key);
+    while (is_filled[slot] && !(slots[slot].first == key)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+template <typename ValueType>
+void FlatHashMap<ValueType>::rehash(size_t slot_count) {
+    std::vector<Entry> old_slots(slot_count);
+    std::vector<uint8_t> old_is_filled(slot_count, 0);
+    old_slots.swap(slots);
+    old_is_filled.swap(is_filled);
+
+    for (size_t old_slot = 0; old_slot < old_slots.size(); ++old_slot) {
+        if (old_is_filled[old_slot]) {
+            size_t slot = findSlot(old_slots[old_slot].first);
+            slots[slot] = std::move(old_slots[old_slot]);
+            is_filled[slot] = 1;
+        }
+    }
+}
+
+template <typename ValueType>
+size_t FlatHashMap<ValueType>::insertSlot(const Coordinate2D &key, bool &is_inserted) {
+    // Load factor is kept at most 3/4, so probe sequences stay short
+    if ((element_count + 1) * 4 > slots.size() * 3) {
+        rehash(slots.empty() ? 16 : slots.size() * 2);
+    }
+    size_t slot = findSlot(key);
+    is_inserted = !is_filled[slot];
+    if (is_inserted) {
+        slots[slot].first = key;
+        is_filled[slot] = 1;
+        ++element_count;
+    }
+    return slot;
+}
+
+template <typename ValueType>
+ValueType &FlatHashMap<ValueType>::operator[](const Coordinate2D &key) {
+    bool is_inserted;
+    return slots[insertSlot(key, is_inserted)].second;
+}
+
+template <typename ValueType>
+bool FlatHashMap<ValueType>::insert(const Coordinate2D &key, const ValueType &value) {
+    bool is_inserted;
+    size_t slot = insertSlot(key, is_inserted);
+    if (is_inserted) {
+        slots[slot].second = value;
+    }
+    return is_inserted;
+}
+
+template <typename ValueType>
+const ValueType *FlatHashMap<ValueType>::find(const Coordinate2D &key) const {
+    if (element_count == 0) {
+        return nullptr;
+    }
+    size_t slot = findSlot(key);
+    return (is_filled[slot] ? &slots[slot].second : nullptr);
+}
+
+template <typename ValueType>
+ValueType *FlatHashMap<ValueType>::find(const Coordinate2D &key) {
+    return const_cast<ValueType*>(static_cast<const FlatHashMap*>(this)->find(key));
+}
+
+template <typename ValueType>
+bool FlatHashMap<ValueType>::contains(const Coordinate2D &key) const {
+    return find(key) != nullptr;
+}
+
+template <typename ValueType>
+bool FlatHashMap<ValueType>::erase(const Coordinate2D &key) {
+    if (element_count == 0) {
+        return false;
+    }
+    size_t slot = findSlot(key);
+    if (!is_filled[slot]) {
+        return false;
+    }
+
+    // Following entries of the same probe run are moved back if the freed slot is not before their home slot
+    size_t mask = slots.size() - 1;
+    for (size_t next_slot = (slot + 1) & mask; is_filled[next_slot]; next_slot = (next_slot + 1) & mask) {
+        size_t home_slot = getHomeSlot(slots[next_slot].first);
+        if (((next_slot - home_slot) & mask) >= ((next_slot - slot) & mask)) {
+            slots[slot] = std::move(slots[next_slot]);
+            slot = next_slot;
+        }
+    }
+    slots[slot] = Entry();
+    is_filled[slot] = 0;
+    --element_count;
+    return true;
+}
+
+template <typename ValueType>
+size_t FlatHashMap<ValueType>::size() const {
+    return element_count;
+}
+
+template <typename ValueType>
+bool FlatHashMap<ValueType>::empty() const {
+    return element_count == 0;
+}
+
+template <typename ValueType>
+void FlatHashMap<ValueType>::clear() {
+    slots.clear();
+    is_filled.clear();
+    element_count = 0;
+}
+
+template <typename ValueType>
+void FlatHashMap<ValueType>::reserve(size_t expected_count) {
+    size_t slot_count = (slots.empty() ? 16 : slots.size());
+    while (expected_count * 4 > slot_count * 3) {
+        slot_count *= 2;
+    }
+    if (expected_count > 0 && slot_count != slots.size()) {
+        rehash(slot_count);
+    }
+}
+
+template <typename ValueType>
+typename FlatHashMap<ValueType>::Iterator FlatHashMap<ValueType>::begin() const {
+    return {this, 0};
+}
+
+template <typename ValueType>
+typename FlatHashMap<ValueType>::Iterator FlatHashMap<ValueType>::end() const {
+    return {this, slots.size()};
+}
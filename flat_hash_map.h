@@ -0,0 +1,80 @@
+#ifndef FLAT_HASH_MAP_H_INCLUDED
+#define FLAT_HASH_MAP_H_INCLUDED
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+#include "coordinate.h"
+
+
+// Hash map of cells with open addressing: entries lie in one array of power of two size and
+// collisions are resolved by linear probing, so lookup touches one or few adjacent slots.
+// Erasing shifts following entries back instead of leaving tombstones.
+// Any insertion may move entries, pointers and iterators are valid only until it
+template <typename ValueType>
+class FlatHashMap
+{
+public:
+    using Entry = std::pair<Coordinate2D, ValueType>;
+
+private:
+    std::vector<Entry> slots;
+    std::vector<uint8_t> is_filled;
+    size_t element_count;
+
+    size_t getHomeSlot(const Coordinate2D &key) const;
+    // Slot of key or the empty slot where it should be inserted, table should have an empty slot
+    size_t findSlot(const Coordinate2D &key) const;
+    void rehash(size_t slot_count);
+    // Slot of key, inserted with default value if it is absent
+    size_t insertSlot(const Coordinate2D &key, bool &is_inserted);
+
+public:
+    // Filled entries in order of slots, which is not related to order of keys
+    class Iterator : public std::iterator<std::forward_iterator_tag, Entry, int, const Entry*, const Entry&>
+    {
+        const FlatHashMap *map;
+        size_t slot;
+
+        void skipEmptySlots();
+    public:
+        Iterator(const FlatHashMap *map_tmp, size_t slot_tmp);
+        const Entry &operator*() const;
+        const Entry *operator->() const;
+        Iterator &operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+    };
+
+    explicit FlatHashMap(size_t expected_count = 0);
+
+    // Value of key, inserted with default value if it is absent
+    ValueType &operator[](const Coordinate2D &key);
+
+    // Returns false and leaves map unchanged if key is present already
+    bool insert(const Coordinate2D &key, const ValueType &value = ValueType());
+
+    // Value of key or nullptr, never inserts
+    const ValueType *find(const Coordinate2D &key) const;
+    ValueType *find(const Coordinate2D &key);
+    bool contains(const Coordinate2D &key) const;
+
+    // Returns false if key is absent
+    bool erase(const Coordinate2D &key);
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+    // Allocates slots for given number of entries at once
+    void reserve(size_t expected_count);
+
+    Iterator begin() const;
+    Iterator end() const;
+};
+
+
+#endif // FLAT_HASH_MAP_H_INCLUDED
@@ -0,0 +1,184 @@
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+#include "expression.h"
+#include "formula_pool.h"
+#include "arena.h"
+
+
+bool TokenRange::operator==(const TokenRange &other) const {
+    return end - begin == other.end - other.begin && std::equal(begin, end, other.begin);
+}
+
+
+size_t TokenRangeHash::operator()(const TokenRange &tokens) const {
+    // FNV-1a over fields of tokens; aggregate calls are interned, so their records identify them
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+    for (const Token *token = tokens.begin; token != tokens.end; ++token) {
+        mix(static_cast<uint64_t>(token->type));
+        switch (token->type) {
+        case LexemType::NUMBER:
+            // Halves are mixed apart, so high bits of number reach low bits of hash
+            mix(static_cast<uint32_t>(token->number));
+            mix(static_cast<uint32_t>(static_cast<uint64_t>(token->number) >> 32));
+            break;
+        case LexemType::CELL_REFERENCE:
+            mix(static_cast<uint32_t>(token->coordinate.row));
+            mix(static_cast<uint32_t>(token->coordinate.column));
+            break;
+        case LexemType::OPERATION:
+            mix(static_cast<uint64_t>(token->operation));
+            break;
+        case LexemType::AGGREGATE:
+            mix(reinterpret_cast<uintptr_t>(token->aggregate_record.get().begin()));
+            break;
+        default:
+            break;
+        }
+    }
+    return hash;
+}
+
+
+std::atomic<uint64_t> next_formula_pool_id(1);
+thread_local FormulaPool *current_formula_pool = nullptr;
+
+
+FormulaPool::FormulaPool() : id(next_formula_pool_id++) {}
+
+
+FormulaPool &FormulaPool::getCurrent() {
+    static FormulaPool program_pool;
+    return (current_formula_pool ? *current_formula_pool : program_pool);
+}
+
+
+FormulaPool *FormulaPool::setCurrent(FormulaPool *pool) {
+    FormulaPool *previous_pool = current_formula_pool;
+    current_formula_pool = pool;
+    return previous_pool;
+}
+
+
+// Slots of index are probed from this one, shard is chosen by the lowest bits of hash
+size_t getHomeIndexSlot(size_t hash, size_t slot_count, int shard_count) {
+    return (hash / static_cast<size_t>(shard_count)) & (slot_count - 1);
+}
+
+
+void FormulaPool::growIndex(Shard &shard) {
+    std::vector<IndexSlot> index(shard.index.empty() ? 64 : shard.index.size() * 2, IndexSlot{0, nullptr});
+    for (const auto &old_slot : shard.index) {
+        if (old_slot.formula) {
+            size_t slot = getHomeIndexSlot(old_slot.hash, index.size(), SHARD_COUNT);
+            while (index[slot].formula) {
+                slot = (slot + 1) & (index.size() - 1);
+            }
+            index[slot] = old_slot;
+        }
+    }
+    shard.index.swap(index);
+}
+
+
+const CompiledFormula *FormulaPool::intern(const std::vector<Token> &tokens) {
+    TokenRange key{tokens.data(), tokens.data() + tokens.size()};
+    size_t hash = TokenRangeHash()(key);
+
+    // Formulas repeated in neighbouring cells are usually found in small per-thread cache without locking;
+    // it is cleared when thread interns into another pool
+    const int recent_formula_count = 1024;
+    thread_local uint64_t recent_pool_id = 0;
+    thread_local const CompiledFormula *recent_formulas[recent_formula_count] = {};
+    if (recent_pool_id != id) {
+        std::fill(recent_formulas, recent_formulas + recent_formula_count, nullptr);
+        recent_pool_id = id;
+    }
+    const CompiledFormula *&recent_formula = recent_formulas[hash % recent_formula_count];
+    if (recent_formula && TokenRange{recent_formula->begin(), recent_formula->end()} == key) {
+        return recent_formula;
+    }
+
+    auto &shard = shards[hash % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (static_cast<size_t>(shard.formula_count + 1) * 2 > shard.index.size()) {
+        growIndex(shard);
+    }
+    size_t slot = getHomeIndexSlot(hash, shard.index.size(), SHARD_COUNT);
+    for (; shard.index[slot].formula; slot = (slot + 1) & (shard.index.size() - 1)) {
+        const auto *formula = shard.index[slot].formula;
+        if (shard.index[slot].hash == hash && TokenRange{formula->begin(), formula->end()} == key) {
+            recent_formula = formula;
+            return formula;
+        }
+    }
+
+    CompiledFormula stored_formula{shard.arena.copy(key.begin, key.end), tokens.size()};
+    const CompiledFormula *formula = shard.arena.copy(&stored_formula, &stored_formula + 1);
+    shard.index[slot] = IndexSlot{hash, formula};
+    ++shard.formula_count;
+    shard.token_count += tokens.size();
+    recent_formula = formula;
+    return formula;
+}
+
+
+int FormulaPool::getFormulaCount() const {
+    int formula_count = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        formula_count += shard.formula_count;
+    }
+    return formula_count;
+}
+
+
+size_t FormulaPool::getTokenCount() const {
+    size_t token_count = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        token_count += shard.token_count;
+    }
+    return token_count;
+}
+
+
+size_t FormulaPool::getMemorySize() const {
+    size_t memory_size = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        memory_size += shard.arena.getMemorySize();
+    }
+    return memory_size;
+}
+
+
+thread_local const std::shared_ptr<CellPools> *current_cell_pools = nullptr;
+
+
+CellPoolsScope::CellPoolsScope(const std::shared_ptr<CellPools> &pools_tmp)
+    : pools(pools_tmp), previous_pools(current_cell_pools),
+      previous_strings(StringPool::setCurrent(pools ? &pools->strings : nullptr)),
+      previous_formulas(FormulaPool::setCurrent(pools ? &pools->formulas : nullptr)) {
+    current_cell_pools = &pools;
+}
+
+
+CellPoolsScope::~CellPoolsScope() {
+    current_cell_pools = previous_pools;
+    StringPool::setCurrent(previous_strings);
+    FormulaPool::setCurrent(previous_formulas);
+}
+
+
+std::shared_ptr<CellPools> CellPoolsScope::getCurrentPools() {
+    return (current_cell_pools ? *current_cell_pools : nullptr);
+}
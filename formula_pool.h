@@ -0,0 +1,127 @@
+#ifndef FORMULA_POOL_H_INCLUDED
+#define FORMULA_POOL_H_INCLUDED
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+#include "expression.h"
+#include "arena.h"
+
+
+// Postfix tokens of formula shared by all expressions with the same formula relative to their anchors,
+// e.g. =A1+B1 anchored at C1 and =A2+B2 anchored at C2; references are stored relative to anchor.
+// Formula and its tokens are placed in arena of pool
+struct CompiledFormula
+{
+    const Token *tokens;
+    size_t token_count;
+
+    const Token *begin() const {
+        return tokens;
+    }
+
+    const Token *end() const {
+        return tokens + token_count;
+    }
+
+    size_t size() const {
+        return token_count;
+    }
+};
+
+
+// Tokens of formula being looked up or stored in pool
+struct TokenRange
+{
+    const Token *begin;
+    const Token *end;
+
+    bool operator==(const TokenRange &other) const;
+};
+
+struct TokenRangeHash
+{
+    size_t operator()(const TokenRange &tokens) const;
+};
+
+
+// Set of distinct compiled formulas kept as long as pool lives, like StringPool.
+// Pool is split into independently locked shards, so formulas may be interned concurrently.
+// Interning a new formula allocates nothing but arena blocks and growth of index
+class FormulaPool
+{
+    static const int SHARD_COUNT = 16;
+
+    struct IndexSlot
+    {
+        size_t hash;
+        // nullptr for empty slot
+        const CompiledFormula *formula;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        // Open addressing with linear probing, at most half of slots are filled
+        std::vector<IndexSlot> index;
+        int formula_count = 0;
+        size_t token_count = 0;
+        MonotonicArena arena;
+    };
+    Shard shards[SHARD_COUNT];
+    // Distinct for every pool ever made, so per-thread caches of destroyed pools are never used
+    uint64_t id;
+
+    static void growIndex(Shard &shard);
+public:
+    FormulaPool();
+    FormulaPool(const FormulaPool&) = delete;
+    FormulaPool &operator=(const FormulaPool&) = delete;
+
+    // Pool formulas are interned into by this thread, see StringPool::getCurrent
+    static FormulaPool &getCurrent();
+    static FormulaPool *setCurrent(FormulaPool *pool);
+
+    // Formula with given relative postfix tokens
+    const CompiledFormula *intern(const std::vector<Token> &tokens);
+
+    int getFormulaCount() const;
+    size_t getTokenCount() const;
+    // Size of arena blocks of all shards
+    size_t getMemorySize() const;
+};
+
+
+
+// Strings and formulas which cells of tables are interned into. Tables made from the same input share pools
+// by std::shared_ptr, so pools are freed with the last of them, see ExpressionTable
+struct CellPools
+{
+    StringPool strings;
+    FormulaPool formulas;
+};
+
+
+// Makes pools current for this thread while scope lives, so cells parsed in it are interned into them;
+// nullptr stands for pools of the whole run of program
+class CellPoolsScope
+{
+    std::shared_ptr<CellPools> pools;
+    const std::shared_ptr<CellPools> *previous_pools;
+    StringPool *previous_strings;
+    FormulaPool *previous_formulas;
+public:
+    explicit CellPoolsScope(const std::shared_ptr<CellPools> &pools_tmp);
+    ~CellPoolsScope();
+    CellPoolsScope(const CellPoolsScope&) = delete;
+    CellPoolsScope &operator=(const CellPoolsScope&) = delete;
+
+    // Pools of the innermost scope of this thread, nullptr outside of scopes
+    static std::shared_ptr<CellPools> getCurrentPools();
+};
+
+
+#endif // FORMULA_POOL_H_INCLUDED
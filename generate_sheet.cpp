@@ -0,0 +1,43 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "number.h"
+#include "sheet_generator.h"
+#include "logger.h"
+
+
+// Writes generated input of process_table to standard output
+int main(int argc, char **argv) {
+
+    try {
+
+        if (argc < 3) {
+            throw std::invalid_argument(
+                "Usage: generate_sheet HEIGHT WIDTH [SEED] > input_file\n"
+                "       generate_sheet HEIGHT WIDTH [--density P] [--formulas P] [--texts P] [--errors P]\n"
+                "           [--aggregates P] [--parentheses P] [--fan-in N] [--chain N] [--seed N] > input_file"
+            );
+        }
+        int height = parseCount(argv[1]);
+        int width = parseCount(argv[2]);
+
+        // Sheet of fixed mix of cells is made unless options are given
+        if (argc > 3 && std::string(argv[3]).compare(0, 2, "--") == 0) {
+            std::cout << generateRawSheet(parseSheetOptions(height, width, argc - 3, argv + 3));
+        } else if (argc <= 4) {
+            unsigned seed = (argc == 4 ? static_cast<unsigned>(parseCount(argv[3])) : 42);
+            std::cout << generateRawSheet(height, width, seed);
+        } else {
+            throw std::invalid_argument("Usage: generate_sheet HEIGHT WIDTH [SEED] > input_file");
+        }
+
+    } catch (const std::exception &exception) {
+
+        log_error(exception.what());
+        return EXIT_FAILURE;
+
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,266 @@
+#include <vector>
+#include <istream>
+#include <stdexcept>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "utils.h"
+#include "input_buffer.h"
+
+
+InputBuffer::InputBuffer(int file_descriptor) : data(nullptr), size(0), mapping(MAP_FAILED) {
+    struct stat file_status;
+    // Mapping starts at the beginning of file, so it is used only if nothing is read yet
+    if (
+        fstat(file_descriptor, &file_status) == 0 && S_ISREG(file_status.st_mode) && file_status.st_size > 0
+        && lseek(file_descriptor, 0, SEEK_CUR) == 0
+    ) {
+        size = static_cast<size_t>(file_status.st_size);
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(mapping);
+            return;
+        }
+    }
+
+    const size_t block_size = 1 << 16;
+    size = 0;
+    while (true) {
+        buffer.resize(size + block_size);
+        ssize_t read_size = read(file_descriptor, buffer.data() + size, block_size);
+        if (read_size < 0) {
+            throw std::runtime_error("Cannot read input");
+        } else if (read_size == 0) {
+            break;
+        }
+        size += static_cast<size_t>(read_size);
+    }
+    useBuffer();
+}
+
+
+InputBuffer::InputBuffer(std::istream &in_stream) : data(nullptr), size(0), mapping(MAP_FAILED) {
+    const size_t block_size = 1 << 16;
+    std::streambuf *streambuf = in_stream.rdbuf();
+    while (true) {
+        buffer.resize(size + block_size);
+        std::streamsize read_size = streambuf->sgetn(buffer.data() + size, block_size);
+        if (read_size <= 0) {
+            break;
+        }
+        size += static_cast<size_t>(read_size);
+    }
+    useBuffer();
+}
+
+
+InputBuffer::InputBuffer(const StringRef &text)
+    : data(text.begin()), size(text.getSize()), mapping(MAP_FAILED) {}
+
+
+void InputBuffer::useBuffer() {
+    buffer.resize(size);
+    data = buffer.data();
+}
+
+
+InputBuffer::~InputBuffer() {
+    if (mapping != MAP_FAILED) {
+        munmap(mapping, size);
+    }
+}
+
+
+const char *InputBuffer::begin() const {
+    return data;
+}
+
+
+const char *InputBuffer::end() const {
+    return data + size;
+}
+
+
+InputReader::InputReader(int file_descriptor_tmp, int copy_descriptor_tmp)
+    : file_descriptor(file_descriptor_tmp), copy_descriptor(copy_descriptor_tmp), buffer(1 << 16), kept_offset(0), size(0) {}
+
+
+bool InputReader::read(size_t begin_offset) {
+    const size_t block_size = 1 << 16;
+    if (size + block_size > buffer.size()) {
+        // Kept text is moved to the beginning only when buffer is full, so every character is moved few times
+        size_t dropped_size = begin_offset - kept_offset;
+        std::copy(
+            buffer.begin() + static_cast<ptrdiff_t>(dropped_size), buffer.begin() + static_cast<ptrdiff_t>(size),
+            buffer.begin()
+        );
+        size -= dropped_size;
+        kept_offset = begin_offset;
+        if (size + block_size > buffer.size()) {
+            buffer.resize(std::max(buffer.size() * 2, size + block_size));
+        }
+    }
+
+    ssize_t read_size;
+    do {
+        read_size = ::read(file_descriptor, buffer.data() + size, buffer.size() - size);
+    } while (read_size < 0 && errno == EINTR);
+    if (read_size < 0) {
+        throw std::runtime_error("Cannot read input");
+    } else if (read_size == 0) {
+        return false;
+    }
+
+    size_t written_size = 0;
+    while (copy_descriptor != -1 && written_size < static_cast<size_t>(read_size)) {
+        ssize_t result = write(copy_descriptor, buffer.data() + size + written_size, static_cast<size_t>(read_size) - written_size);
+        if (result < 0 && errno != EINTR) {
+            throw std::runtime_error("Cannot write copy of input");
+        }
+        written_size += static_cast<size_t>(std::max<ssize_t>(result, 0));
+    }
+    size += static_cast<size_t>(read_size);
+    return true;
+}
+
+
+const char *InputReader::begin() const {
+    return buffer.data();
+}
+
+
+const char *InputReader::end() const {
+    return buffer.data() + size;
+}
+
+
+size_t InputReader::getOffset(const char *position) const {
+    return kept_offset + static_cast<size_t>(position - buffer.data());
+}
+
+
+const char *InputReader::getPosition(size_t offset) const {
+    return buffer.data() + (offset - kept_offset);
+}
+
+
+const char *findLinesEnd(const char *begin, const char *end) {
+    // '\r' at the end of text may be followed by '\n' read later
+    for (const char *position = (begin != end && end[-1] == '\r' ? end - 1 : end); position != begin; --position) {
+        if (position[-1] == '\n' || position[-1] == '\r') {
+            return position;
+        }
+    }
+    return begin;
+}
+
+
+const char *findCellDelimiter(const char *begin, const char *end) {
+#ifdef __SSE2__
+    const __m128i tabs = _mm_set1_epi8('\t');
+    const __m128i line_feeds = _mm_set1_epi8('\n');
+    const __m128i carriage_returns = _mm_set1_epi8('\r');
+    while (end - begin >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i matches = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, tabs), _mm_cmpeq_epi8(block, line_feeds)),
+            _mm_cmpeq_epi8(block, carriage_returns)
+        );
+        int match_mask = _mm_movemask_epi8(matches);
+        if (match_mask != 0) {
+            return begin + __builtin_ctz(static_cast<unsigned>(match_mask));
+        }
+        begin += 16;
+    }
+#endif
+    return findCellDelimiterScalar(begin, end);
+}
+
+
+const char *findCellDelimiterScalar(const char *begin, const char *end) {
+    while (begin != end && *begin != '\t' && *begin != '\n' && *begin != '\r') {
+        ++begin;
+    }
+    return begin;
+}
+
+
+LineCellReader::LineCellReader(const char *begin_tmp, const char *end_tmp, bool is_exhausted_tmp)
+    : position(begin_tmp), end(end_tmp), line_begin(begin_tmp),
+      is_exhausted(is_exhausted_tmp), is_line_open(false), is_line_finished(true) {}
+
+
+bool LineCellReader::nextLine() {
+    if (is_line_open) {
+        // Skip unread cells
+        position = findCellDelimiter(position, end);
+        while (position != end && *position == '\t') {
+            position = findCellDelimiter(position + 1, end);
+        }
+
+        if (position == end) {
+            // getline sets eofbit only if it reads nothing before the end of input
+            if (line_begin == end) {
+                is_exhausted = true;
+            }
+        } else if (*position == '\r' && position + 1 != end && position[1] == '\n') {
+            position += 2;
+        } else {
+            ++position;
+        }
+    }
+
+    is_line_open = false;
+    is_line_finished = true;
+    if (is_exhausted) {
+        return false;
+    }
+
+    line_begin = position;
+    is_line_open = true;
+    is_line_finished = false;
+    return true;
+}
+
+
+bool LineCellReader::isLineEmpty() const {
+    return position == end || *position == '\n' || *position == '\r';
+}
+
+
+bool LineCellReader::isLineAtEnd() const {
+    return line_begin == end;
+}
+
+
+bool LineCellReader::nextCell(StringRef &cell) {
+    if (is_line_finished) {
+        return false;
+    }
+
+    const char *cell_end = findCellDelimiter(position, end);
+    if (cell_end != end && *cell_end == '\t') {
+        cell = StringRef(position, cell_end);
+        position = cell_end + 1;
+        return true;
+    }
+
+    // Last cell of line is read only if it is not empty, as std::getline fails if it extracts nothing
+    is_line_finished = true;
+    if (cell_end == position) {
+        return false;
+    }
+    cell = StringRef(position, cell_end);
+    position = cell_end;
+    return true;
+}
@@ -0,0 +1,103 @@
+#ifndef INPUT_BUFFER_H_INCLUDED
+#define INPUT_BUFFER_H_INCLUDED
+
+#include <vector>
+#include <istream>
+
+#include "utils.h"
+
+
+// Whole input in contiguous memory: regular files are memory-mapped,
+// pipes, terminals and streams are read into buffer, text kept elsewhere is used as it is
+class InputBuffer
+{
+    const char *data;
+    size_t size;
+    void *mapping;
+    std::vector<char> buffer;
+
+    void useBuffer();
+public:
+    explicit InputBuffer(int file_descriptor);
+    explicit InputBuffer(std::istream &in_stream);
+    // Text should outlive buffer
+    explicit InputBuffer(const StringRef &text);
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer &operator=(const InputBuffer&) = delete;
+    ~InputBuffer();
+
+    const char *begin() const;
+    const char *end() const;
+};
+
+
+// Input read from file descriptor block by block, so it is processed before its end is read.
+// Only text after the given offset of input is kept; every block read may be copied to another file as well
+class InputReader
+{
+    int file_descriptor;
+    // -1 if input is not copied
+    int copy_descriptor;
+    std::vector<char> buffer;
+    // Offset of input of the first kept character
+    size_t kept_offset;
+    size_t size;
+public:
+    explicit InputReader(int file_descriptor_tmp, int copy_descriptor_tmp = -1);
+    InputReader(const InputReader&) = delete;
+    InputReader &operator=(const InputReader&) = delete;
+
+    // Drops text before given offset of input and reads next block after the rest, returns false at the end of input.
+    // Positions of kept text are invalidated
+    bool read(size_t begin_offset);
+
+    // Kept text
+    const char *begin() const;
+    const char *end() const;
+
+    size_t getOffset(const char *position) const;
+    const char *getPosition(size_t offset) const;
+};
+
+
+// End of the last line of text which ends with '\n' or '\r' not followed by the end of text, so the line
+// cannot continue in text read later; begin if there is no such line
+const char *findLinesEnd(const char *begin, const char *end);
+
+
+// First '\t', '\n' or '\r' in given range or end if there is none; SSE2 is used when available
+const char *findCellDelimiter(const char *begin, const char *end);
+
+const char *findCellDelimiterScalar(const char *begin, const char *end);
+
+
+// Reads lines and their tab-separated cells with the same rules as
+// getline from utils.h and std::getline(row_stream, cell, '\t') on every line
+class LineCellReader
+{
+    const char *position;
+    const char *end;
+    const char *line_begin;
+    // Next line cannot be read, as getline on stream with eofbit
+    bool is_exhausted;
+    bool is_line_open;
+    // Current line has no more cells
+    bool is_line_finished;
+public:
+    LineCellReader(const char *begin_tmp, const char *end_tmp, bool is_exhausted_tmp = false);
+
+    // Skips rest of current line and starts the next one, returns false if it cannot be read
+    bool nextLine();
+
+    // Whether current line has no characters, valid right after nextLine
+    bool isLineEmpty() const;
+
+    // Whether current line starts at the end of text, valid right after nextLine
+    bool isLineAtEnd() const;
+
+    // Next cell of current line, returns false if there are no more cells
+    bool nextCell(StringRef &cell);
+};
+
+
+#endif // INPUT_BUFFER_H_INCLUDED
@@ -0,0 +1,332 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <stdexcept>
+#include <chrono>
+#include <cstdint>
+
+#include "logger.h"
+
+
+std::atomic<int> log_threshold(static_cast<int>(LogLevel::INFO));
+
+
+struct LogRecord
+{
+    LogLevel level;
+    std::string text;
+};
+
+
+// Messages of one thread; the thread pushes them and the writer pops them, both without locks
+class LogRing
+{
+    std::vector<LogRecord> records;
+    // Positions grow infinitely, record of position is records[position % records.size()]
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+public:
+    // Counters of messages of the same kind in window, used only by the thread
+    std::unordered_map<const void*, size_t> kind_counts;
+    uint64_t counted_window;
+    std::atomic<uint64_t> suppressed_count;
+    std::atomic<uint64_t> dropped_count;
+
+    explicit LogRing(size_t size) : records(size), head(0), tail(0), counted_window(0), suppressed_count(0), dropped_count(0) {}
+
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    bool isHalfFull() const {
+        return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed) >= records.size() / 2;
+    }
+
+    // Returns false if ring is full
+    bool tryPush(LogLevel level, std::string &&text) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position - tail.load(std::memory_order_acquire) == records.size()) {
+            return false;
+        }
+        auto &record = records[position % records.size()];
+        record.level = level;
+        record.text = std::move(text);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Should be called by one thread at a time
+    template <typename RecordHandler>
+    void popAll(RecordHandler &&handleRecord) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        size_t end = head.load(std::memory_order_acquire);
+        for (; position != end; ++position) {
+            handleRecord(records[position % records.size()]);
+            tail.store(position + 1, std::memory_order_release);
+        }
+    }
+};
+
+
+class Logger
+{
+    const size_t ring_size = 1024;
+
+    // Guards list of rings and popping from them
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<LogRing>> rings;
+    std::ostream *stream;
+    bool is_colored;
+    std::atomic<size_t> repeat_limit;
+    std::atomic<int64_t> repeat_window_milliseconds;
+    // Threads clear their counters of kinds when it changes
+    std::atomic<uint64_t> window_index;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake_condition;
+    bool is_stopping;
+    std::thread writer;
+
+    // Writes messages of all rings at once, rings of finished threads are removed
+    void drain(bool is_summary_written);
+    // Ring of calling thread, registered on the first call
+    LogRing &getRing();
+    void work();
+    void appendRecord(std::string &batch, LogLevel level, const std::string &text) const;
+public:
+    Logger();
+    Logger(const Logger&) = delete;
+    Logger &operator=(const Logger&) = delete;
+    ~Logger();
+
+    bool accept(LogLevel level, const void *kind);
+    void write(LogLevel level, std::string &&text);
+    void flush();
+    void setColored(bool is_colored_tmp);
+    void setStream(std::ostream &stream_tmp);
+    void setRepeatLimit(size_t limit, std::chrono::milliseconds window);
+};
+
+
+Logger::Logger() : stream(&std::cerr), is_colored(true), repeat_limit(100), repeat_window_milliseconds(1000),
+      window_index(0), is_stopping(false) {
+    writer = std::thread(&Logger::work, this);
+}
+
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        is_stopping = true;
+    }
+    wake_condition.notify_one();
+    writer.join();
+    drain(true);
+}
+
+
+void Logger::work() {
+    // Messages wait at most for one period unless a ring fills up to half
+    const auto period = std::chrono::milliseconds(10);
+    auto window_start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    while (!is_stopping) {
+        wake_condition.wait_for(lock, period);
+        lock.unlock();
+        // Suppressed messages of window are reported when it ends
+        auto now = std::chrono::steady_clock::now();
+        bool is_window_over =
+            (now - window_start >= std::chrono::milliseconds(repeat_window_milliseconds.load(std::memory_order_relaxed)));
+        if (is_window_over) {
+            window_start = now;
+            window_index.fetch_add(1, std::memory_order_relaxed);
+        }
+        drain(is_window_over);
+        lock.lock();
+    }
+}
+
+
+void Logger::appendRecord(std::string &batch, LogLevel level, const std::string &text) const {
+    const char *level_names[] = {"INFO", "WARN", "ERROR", "FATAL"};
+    const char *level_colors[] = {"39", "36", "31", "35"};
+    const char *level_name = level_names[static_cast<int>(level)];
+    if (!is_colored) {
+        batch.append("[").append(level_name).append("] ").append(text).append("\n");
+        return;
+    }
+    const char *color = level_colors[static_cast<int>(level)];
+    batch.append("\033[").append(color).append(";1m[").append(level_name).append("]\033[0m\033[");
+    batch.append(color).append("m ").append(text).append("\033[0m\n");
+}
+
+
+void Logger::drain(bool is_summary_written) {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+
+    std::string batch;
+    uint64_t suppressed_count = 0;
+    uint64_t dropped_count = 0;
+    for (size_t ring_index = 0; ring_index < rings.size();) {
+        auto &ring = *rings[ring_index];
+        ring.popAll([this, &batch](const LogRecord &record) {
+            appendRecord(batch, record.level, record.text);
+        });
+        if (is_summary_written) {
+            suppressed_count += ring.suppressed_count.exchange(0);
+            dropped_count += ring.dropped_count.exchange(0);
+        }
+        // Only the list owns ring of finished thread, nothing can be pushed to it
+        if (rings[ring_index].use_count() == 1 && ring.isEmpty() && ring.suppressed_count == 0 && ring.dropped_count == 0) {
+            rings[ring_index] = std::move(rings.back());
+            rings.pop_back();
+        } else {
+            ++ring_index;
+        }
+    }
+
+    if (suppressed_count > 0) {
+        appendRecord(batch, LogLevel::WARN, std::to_string(suppressed_count) + " repeated messages were suppressed");
+    }
+    if (dropped_count > 0) {
+        appendRecord(batch, LogLevel::WARN, std::to_string(dropped_count) + " messages were dropped, they came faster than written");
+    }
+    if (!batch.empty()) {
+        stream->write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        stream->flush();
+    }
+}
+
+
+LogRing &Logger::getRing() {
+    thread_local std::shared_ptr<LogRing> ring;
+    if (!ring) {
+        ring = std::make_shared<LogRing>(ring_size);
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        rings.push_back(ring);
+    }
+    return *ring;
+}
+
+
+bool Logger::accept(LogLevel level, const void *kind) {
+    size_t limit = repeat_limit.load(std::memory_order_relaxed);
+    if (level >= LogLevel::ERROR || !kind || limit == 0) {
+        return true;
+    }
+    auto &ring = getRing();
+    uint64_t window = window_index.load(std::memory_order_relaxed);
+    if (ring.counted_window != window) {
+        ring.kind_counts.clear();
+        ring.counted_window = window;
+    }
+    if (++ring.kind_counts[kind] <= limit) {
+        return true;
+    }
+    ring.suppressed_count.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+
+void Logger::write(LogLevel level, std::string &&text) {
+    auto &ring = getRing();
+    bool is_urgent = (level >= LogLevel::ERROR);
+    while (!ring.tryPush(level, std::move(text))) {
+        if (!is_urgent) {
+            ring.dropped_count.fetch_add(1, std::memory_order_relaxed);
+            wake_condition.notify_one();
+            return;
+        }
+        drain(false);
+    }
+
+    if (is_urgent) {
+        drain(false);
+    } else if (ring.isHalfFull()) {
+        wake_condition.notify_one();
+    }
+}
+
+
+void Logger::flush() {
+    drain(true);
+}
+
+
+void Logger::setColored(bool is_colored_tmp) {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    is_colored = is_colored_tmp;
+}
+
+
+void Logger::setStream(std::ostream &stream_tmp) {
+    drain(false);
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    stream = &stream_tmp;
+}
+
+
+void Logger::setRepeatLimit(size_t limit, std::chrono::milliseconds window) {
+    repeat_limit.store(limit, std::memory_order_relaxed);
+    repeat_window_milliseconds.store(static_cast<int64_t>(window.count()), std::memory_order_relaxed);
+    window_index.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+// Created with the first message or setting, writes the rest of messages at exit
+Logger &getLogger() {
+    static Logger logger;
+    return logger;
+}
+
+
+void setLogLevel(LogLevel level) {
+    log_threshold.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+
+LogLevel parseLogLevel(const std::string &name) {
+    const char *level_names[] = {"info", "warn", "error", "fatal", "none"};
+    for (int level_index = 0; level_index <= static_cast<int>(LogLevel::NONE); ++level_index) {
+        if (name == level_names[level_index]) {
+            return static_cast<LogLevel>(level_index);
+        }
+    }
+    throw std::invalid_argument("Unknown log level " + name + ", expected info, warn, error, fatal or none");
+}
+
+
+void setLogColored(bool is_colored) {
+    getLogger().setColored(is_colored);
+}
+
+
+void setLogStream(std::ostream &stream) {
+    getLogger().setStream(stream);
+}
+
+
+void setLogRepeatLimit(size_t limit, std::chrono::milliseconds window) {
+    getLogger().setRepeatLimit(limit, window);
+}
+
+
+void flushLog() {
+    getLogger().flush();
+}
+
+
+bool acceptLogMessage(LogLevel level, const void *kind) {
+    return getLogger().accept(level, kind);
+}
+
+
+void writeLogMessage(LogLevel level, std::string &&text) {
+    getLogger().write(level, std::move(text));
+}
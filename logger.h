@@ -1,70 +1,109 @@
 #ifndef LOGGER_H_INCLUDED
 #define LOGGER_H_INCLUDED
 
-#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <cstddef>
 
 
-static auto &log_stream = std::cerr;
+// Messages are formatted by logging thread and passed through its own ring buffer to background
+// writer, so logging never waits for stderr. Errors and fatal errors are written before returning.
+// Levels below threshold are skipped before formatting. Warnings and info messages starting with
+// the same string literal are limited per thread and time window, the rest of them are counted and
+// reported at the end of window and by flushLog
 
+enum class LogLevel {
+    INFO,
+    WARN,
+    ERROR,
+    FATAL,
+    NONE
+};
 
-template <typename Arg>
-void print(Arg &&arg);
 
-template <typename FirstArg, typename... Args>
-void print(FirstArg &&first_arg, Args&&... args);
+extern std::atomic<int> log_threshold;
 
-template <typename... MessageArgs>
-void print_log_message(const std::string &log_level, const std::string &formatting, MessageArgs&&... message_args);
+inline bool isLogged(LogLevel level) {
+    return static_cast<int>(level) >= log_threshold.load(std::memory_order_relaxed);
+}
 
-template <typename... MessageArgs>
-void log_info(MessageArgs&&... message_args);
+// Messages of lower levels are skipped, NONE turns logging off
+void setLogLevel(LogLevel level);
 
-template <typename... MessageArgs>
-void log_warn(MessageArgs&&... message_args);
+// Level by its name: info, warn, error, fatal or none
+LogLevel parseLogLevel(const std::string &name);
 
-template <typename... MessageArgs>
-void log_error(MessageArgs&&... message_args);
+// Plain messages have no ANSI colors
+void setLogColored(bool is_colored);
 
-template <typename... MessageArgs>
-void log_fatal(MessageArgs&&... message_args);
+// Stream for messages written after this call, std::cerr by default
+void setLogStream(std::ostream &stream);
+
+// Messages of the same kind beyond limit in one window are not written, 0 means no limit.
+// Counters of kinds start over with this call
+void setLogRepeatLimit(size_t limit, std::chrono::milliseconds window = std::chrono::seconds(1));
+
+// Waits until all messages logged so far are written, then reports suppressed ones
+void flushLog();
+
+// Backend of functions below. Kind is the first literal of message, nullptr if it is not limited;
+// message is formatted and written only if it is accepted
+bool acceptLogMessage(LogLevel level, const void *kind);
+void writeLogMessage(LogLevel level, std::string &&text);
 
 
 template <typename Arg>
-void print(Arg &&arg) {
-    log_stream << arg << std::endl;
+const void *get_log_message_kind(const Arg&) {
+    return nullptr;
+}
+
+template <size_t length>
+const void *get_log_message_kind(const char (&literal)[length]) {
+    return literal;
+}
+
+inline void append_log_arguments(std::ostream&) {
 }
 
 template <typename FirstArg, typename... Args>
-void print(FirstArg &&first_arg, Args&&... args) {
-    log_stream << first_arg;
-    print(std::forward<Args>(args)...);
+void append_log_arguments(std::ostream &stream, FirstArg &&first_arg, Args&&... args) {
+    stream << first_arg;
+    append_log_arguments(stream, std::forward<Args>(args)...);
 }
 
-template <typename... MessageArgs>
-void print_log_message(const std::string &log_level, const std::string &formatting, MessageArgs&&... message_args) {
-    print("\033[", formatting, ";1m[", log_level, "]\033[0m\033[", formatting, "m ", std::forward<MessageArgs>(message_args)..., "\033[0m");
+template <typename FirstArg, typename... MessageArgs>
+void print_log_message(LogLevel level, FirstArg &&first_arg, MessageArgs&&... message_args) {
+    if (!isLogged(level) || !acceptLogMessage(level, get_log_message_kind(first_arg))) {
+        return;
+    }
+    thread_local std::ostringstream stream;
+    stream.str(std::string());
+    append_log_arguments(stream, first_arg, std::forward<MessageArgs>(message_args)...);
+    writeLogMessage(level, stream.str());
 }
 
 template <typename... MessageArgs>
 void log_info(MessageArgs&&... message_args) {
-    print_log_message("INFO", "39", std::forward<MessageArgs>(message_args)...);
+    print_log_message(LogLevel::INFO, std::forward<MessageArgs>(message_args)...);
 }
 
 template <typename... MessageArgs>
 void log_warn(MessageArgs&&... message_args) {
-    print_log_message("WARN", "36", std::forward<MessageArgs>(message_args)...);
+    print_log_message(LogLevel::WARN, std::forward<MessageArgs>(message_args)...);
 }
 
 template <typename... MessageArgs>
 void log_error(MessageArgs&&... message_args) {
-    print_log_message("ERROR", "31", std::forward<MessageArgs>(message_args)...);
+    print_log_message(LogLevel::ERROR, std::forward<MessageArgs>(message_args)...);
 }
 
 template <typename... MessageArgs>
 void log_fatal(MessageArgs&&... message_args) {
-    print_log_message("FATAL", "35", std::forward<MessageArgs>(message_args)...);
+    print_log_message(LogLevel::FATAL, std::forward<MessageArgs>(message_args)...);
 }
 
 
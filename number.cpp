@@ -0,0 +1,116 @@
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "utils.h"
+#include "result.h"
+#include "number.h"
+
+
+bool isDigit(char character) {
+    return static_cast<unsigned char>(character - '0') < 10;
+}
+
+
+// Appends digits to value; the first 18 digits can not overflow Number, so only the rest are checked
+bool tryAccumulateDigits(const char *begin, const char *end, Number &value) {
+    const ptrdiff_t unchecked_digit_count = std::numeric_limits<Number>::digits10;
+    const char *unchecked_end = begin + std::min(end - begin, unchecked_digit_count);
+    for (; begin != unchecked_end; ++begin) {
+        value = value * 10 + (*begin - '0');
+    }
+    for (; begin != end; ++begin) {
+        if (__builtin_mul_overflow(value, 10, &value) || __builtin_add_overflow(value, *begin - '0', &value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+Result<Number> tryParseNumber(const StringRef &raw_number) {
+    const char *begin = raw_number.begin();
+    const char *end = raw_number.end();
+#ifdef DECIMAL_NUMBERS
+    const char *point = std::find(begin, end, '.');
+#else
+    const char *point = end;
+#endif
+    const char *fraction_begin = (point == end ? end : point + 1);
+    if (
+        begin == point || (point != end && fraction_begin == end)
+        || end - fraction_begin > NUMBER_FRACTION_DIGITS
+        || !std::all_of(begin, point, isDigit) || !std::all_of(fraction_begin, end, isDigit)
+    ) {
+        return Error(ErrorCode::NOT_A_NUMBER, raw_number);
+    }
+
+    Number number = 0;
+    Number fraction = 0;
+    tryAccumulateDigits(fraction_begin, end, fraction);
+    if (
+        !tryAccumulateDigits(begin, point, number)
+        || __builtin_mul_overflow(number, NUMBER_SCALE, &number)
+        || __builtin_add_overflow(number, fraction * getPowerOfTen(NUMBER_FRACTION_DIGITS - static_cast<int>(end - fraction_begin)), &number)
+    ) {
+        return Error(ErrorCode::NUMBER_TOO_LARGE, raw_number);
+    }
+    return number;
+}
+
+Number parseNumber(const StringRef &raw_number) {
+    return tryParseNumber(raw_number).getValueOrThrow();
+}
+
+
+int parseCount(const StringRef &raw_count) {
+    if (raw_count.empty() || !std::all_of(raw_count.begin(), raw_count.end(), isDigit)) {
+        throw std::invalid_argument(makeErrorDescription(Error(ErrorCode::NOT_A_NUMBER, raw_count)));
+    }
+    Number count = 0;
+    if (!tryAccumulateDigits(raw_count.begin(), raw_count.end(), count) || count > std::numeric_limits<int>::max()) {
+        throw std::invalid_argument(makeErrorDescription(Error(ErrorCode::NUMBER_TOO_LARGE, raw_count)));
+    }
+    return static_cast<int>(count);
+}
+
+
+size_t formatNumber(Number number, char *output) {
+    // Digits are written from the end of temporary array
+    char digits[MAX_NUMBER_LENGTH];
+    char *digits_begin = digits + MAX_NUMBER_LENGTH;
+    uint64_t absolute_value = (number < 0 ? 0u - static_cast<uint64_t>(number) : static_cast<uint64_t>(number));
+#ifdef DECIMAL_NUMBERS
+    uint64_t fraction = absolute_value % static_cast<uint64_t>(NUMBER_SCALE);
+    absolute_value /= static_cast<uint64_t>(NUMBER_SCALE);
+    if (fraction != 0) {
+        int fraction_digit_count = NUMBER_FRACTION_DIGITS;
+        for (; fraction % 10 == 0; fraction /= 10) {
+            --fraction_digit_count;
+        }
+        for (; fraction_digit_count > 0; --fraction_digit_count) {
+            *--digits_begin = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        *--digits_begin = '.';
+    }
+#endif
+    do {
+        *--digits_begin = static_cast<char>('0' + absolute_value % 10);
+        absolute_value /= 10;
+    } while (absolute_value != 0);
+    if (number < 0) {
+        *--digits_begin = '-';
+    }
+
+    std::copy(digits_begin, digits + MAX_NUMBER_LENGTH, output);
+    return static_cast<size_t>(digits + MAX_NUMBER_LENGTH - digits_begin);
+}
+
+std::string formatNumber(Number number) {
+    char digits[MAX_NUMBER_LENGTH];
+    return std::string(digits, formatNumber(number, digits));
+}
@@ -0,0 +1,111 @@
+#ifndef NUMBER_H_INCLUDED
+#define NUMBER_H_INCLUDED
+
+#include <string>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "utils.h"
+#include "result.h"
+
+
+// Value of number cell: 64-bit integer, or fixed-point decimal with NUMBER_FRACTION_DIGITS digits after point
+// stored as integer count of their units if program is built with DECIMAL_NUMBERS (make NUMBER=decimal).
+// Operations report overflow as error instead of wrapping around
+using Number = int64_t;
+
+// Exact sum of any count of numbers that fits into memory, e.g. of numbers of range
+__extension__ typedef __int128 WideNumber;
+
+#ifdef DECIMAL_NUMBERS
+const int NUMBER_FRACTION_DIGITS = 4;
+#else
+const int NUMBER_FRACTION_DIGITS = 0;
+#endif
+
+constexpr Number getPowerOfTen(int exponent) {
+    return exponent == 0 ? 1 : 10 * getPowerOfTen(exponent - 1);
+}
+
+// Number 1 in units of Number
+const Number NUMBER_SCALE = getPowerOfTen(NUMBER_FRACTION_DIGITS);
+
+// Length of the longest printed number: sign, 19 digits and point
+const size_t MAX_NUMBER_LENGTH = 21;
+
+
+// Integer count, e.g. result of COUNT, as number
+inline Number makeNumber(int count) {
+    return count * NUMBER_SCALE;
+}
+
+inline Result<Number> tryNarrowNumber(WideNumber value) {
+    if (value > std::numeric_limits<Number>::max() || value < std::numeric_limits<Number>::min()) {
+        return Error(ErrorCode::ARITHMETIC_OVERFLOW);
+    }
+    return static_cast<Number>(value);
+}
+
+inline Result<Number> tryAddNumbers(Number left_operand, Number right_operand) {
+    Number sum;
+    if (__builtin_add_overflow(left_operand, right_operand, &sum)) {
+        return Error(ErrorCode::ARITHMETIC_OVERFLOW);
+    }
+    return sum;
+}
+
+inline Result<Number> trySubtractNumbers(Number left_operand, Number right_operand) {
+    Number difference;
+    if (__builtin_sub_overflow(left_operand, right_operand, &difference)) {
+        return Error(ErrorCode::ARITHMETIC_OVERFLOW);
+    }
+    return difference;
+}
+
+// Fraction digits beyond NUMBER_FRACTION_DIGITS of product and quotient are truncated toward zero
+inline Result<Number> tryMultiplyNumbers(Number left_operand, Number right_operand) {
+#ifdef DECIMAL_NUMBERS
+    return tryNarrowNumber(static_cast<WideNumber>(left_operand) * right_operand / NUMBER_SCALE);
+#else
+    Number product;
+    if (__builtin_mul_overflow(left_operand, right_operand, &product)) {
+        return Error(ErrorCode::ARITHMETIC_OVERFLOW);
+    }
+    return product;
+#endif
+}
+
+inline Result<Number> tryDivideNumbers(Number left_operand, Number right_operand) {
+    if (right_operand == 0) {
+        return Error(ErrorCode::DIVISION_BY_ZERO);
+    }
+#ifdef DECIMAL_NUMBERS
+    return tryNarrowNumber(static_cast<WideNumber>(left_operand) * NUMBER_SCALE / right_operand);
+#else
+    // The only quotient of integers which does not fit
+    if (left_operand == std::numeric_limits<Number>::min() && right_operand == -1) {
+        return Error(ErrorCode::ARITHMETIC_OVERFLOW);
+    }
+    return left_operand / right_operand;
+#endif
+}
+
+
+// Non-negative number written with digits and, for decimal numbers, point and at most NUMBER_FRACTION_DIGITS
+// digits after it; too large number is NUMBER_TOO_LARGE error
+Result<Number> tryParseNumber(const StringRef &raw_number);
+
+Number parseNumber(const StringRef &raw_number);
+
+// Non-negative int of command line, e.g. number of threads, which is never fractional unlike number of cell
+int parseCount(const StringRef &raw_count);
+
+// Writes decimal representation of number, at most MAX_NUMBER_LENGTH characters, and returns its length;
+// decimal numbers are printed without trailing zeros of fraction
+size_t formatNumber(Number number, char *output);
+
+std::string formatNumber(Number number);
+
+
+#endif // NUMBER_H_INCLUDED
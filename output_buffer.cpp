@@ -0,0 +1,94 @@
+#include <vector>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstddef>
+
+#include <unistd.h>
+
+#include "utils.h"
+#include "output_buffer.h"
+#include "number.h"
+#include "stats.h"
+
+
+OutputBuffer::OutputBuffer(int file_descriptor_tmp, size_t capacity)
+    : file_descriptor(file_descriptor_tmp), out_stream(nullptr), buffer(capacity), size(0) {}
+
+
+OutputBuffer::OutputBuffer(std::ostream &out_stream_tmp, size_t capacity)
+    : file_descriptor(-1), out_stream(&out_stream_tmp), buffer(capacity), size(0) {}
+
+
+OutputBuffer::~OutputBuffer() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+    }
+}
+
+
+void OutputBuffer::reserve(size_t length) {
+    if (size + length > buffer.size()) {
+        flush();
+        if (length > buffer.size()) {
+            buffer.resize(length);
+        }
+    }
+}
+
+
+void OutputBuffer::append(char character) {
+    reserve(1);
+    buffer[size++] = character;
+}
+
+
+void OutputBuffer::append(const StringRef &string) {
+    reserve(string.getSize());
+    std::copy(string.begin(), string.end(), buffer.begin() + static_cast<std::ptrdiff_t>(size));
+    size += string.getSize();
+}
+
+
+void OutputBuffer::append(Number number) {
+    reserve(MAX_NUMBER_LENGTH);
+    size += formatNumber(number, buffer.data() + size);
+}
+
+
+void OutputBuffer::appendRepeated(char character, size_t count) {
+    while (count > 0) {
+        reserve(1);
+        size_t length = std::min(count, buffer.size() - size);
+        std::memset(buffer.data() + size, character, length);
+        size += length;
+        count -= length;
+    }
+}
+
+
+void OutputBuffer::flush() {
+    StatsStageTimer timer(StatsStage::PRINT);
+    if (out_stream) {
+        out_stream->write(buffer.data(), static_cast<std::streamsize>(size));
+        size = 0;
+        return;
+    }
+
+    size_t written_size = 0;
+    while (written_size < size) {
+        ssize_t result = write(file_descriptor, buffer.data() + written_size, size - written_size);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            size = 0;
+            throw std::runtime_error("Cannot write output");
+        }
+        written_size += static_cast<size_t>(result);
+    }
+    size = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef OUTPUT_BUFFER_H_INCLUDED
+#define OUTPUT_BUFFER_H_INCLUDED
+
+#include <vector>
+#include <ostream>
+
+#include "utils.h"
+#include "number.h"
+
+
+// Collects output in large reusable buffer and passes it to file descriptor
+// by batched write calls, or to stream if it is given instead
+class OutputBuffer
+{
+    int file_descriptor;
+    std::ostream *out_stream;
+    std::vector<char> buffer;
+    size_t size;
+
+    // Makes room for at least given number of characters
+    void reserve(size_t length);
+public:
+    explicit OutputBuffer(int file_descriptor_tmp, size_t capacity = 1 << 16);
+    explicit OutputBuffer(std::ostream &out_stream_tmp, size_t capacity = 1 << 16);
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer &operator=(const OutputBuffer&) = delete;
+    // Flushes rest of output, errors are ignored
+    ~OutputBuffer();
+
+    void append(char character);
+    void append(const StringRef &string);
+    // Representation of number given by formatNumber, without iostreams
+    void append(Number number);
+    void appendRepeated(char character, size_t count);
+
+    void flush();
+};
+
+
+#endif // OUTPUT_BUFFER_H_INCLUDED
@@ -8,21 +8,173 @@
 #include <string>
 #include <functional>
 
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "sparse_table.h"
+#include "sparse_table.cpp"
 #include "expression_table.h"
+#include "expression.h"
+#include "number.h"
+#include "thread_pool.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "snapshot.h"
+#include "sheet_engine.h"
+#include "sheet_server.h"
+#include "stats.h"
 #include "logger.h"
 
 
-int main() {
+struct ProcessOptions
+{
+    int thread_count;
+    // Snapshot to write after calculation, empty if it is not needed
+    std::string save_path;
+    // Snapshot to start from instead of input, empty if input is read
+    std::string load_path;
+    // Times of stages and counters are printed to stderr
+    bool is_stats_printed;
+    // Rows above its own one formulas may refer to when table is streamed, -1 if it is read at once
+    int window_height;
+    // Sheets are served one after another with framing of sheet_server.h, from stdin to stdout
+    bool is_served;
+    // Sheets are served on Unix-domain socket at this path instead, empty if it is not needed
+    std::string socket_path;
+
+    ProcessOptions() : thread_count(1), is_stats_printed(false), window_height(-1), is_served(false) {}
+};
+
+
+ProcessOptions parseOptions(int argc, char **argv) {
+    ProcessOptions options;
+
+    for (int argument_index = 1; argument_index < argc; ++argument_index) {
+        std::string argument = argv[argument_index];
+        if (argument == "--threads" && argument_index + 1 < argc) {
+            options.thread_count = parseCount(argv[++argument_index]);
+            if (options.thread_count == 0) {
+                throw std::invalid_argument("Number of threads should be positive");
+            }
+        } else if (argument == "--save" && argument_index + 1 < argc) {
+            options.save_path = argv[++argument_index];
+        } else if (argument == "--load" && argument_index + 1 < argc) {
+            options.load_path = argv[++argument_index];
+        } else if (argument == "--stream" && argument_index + 1 < argc) {
+            options.window_height = parseCount(argv[++argument_index]);
+        } else if (argument == "--serve") {
+            options.is_served = true;
+        } else if (argument == "--socket" && argument_index + 1 < argc) {
+            options.socket_path = argv[++argument_index];
+        } else if (argument == "--stats") {
+            options.is_stats_printed = true;
+        } else if (argument == "--log-level" && argument_index + 1 < argc) {
+            setLogLevel(parseLogLevel(argv[++argument_index]));
+        } else if (argument == "--plain-log") {
+            setLogColored(false);
+        } else {
+            throw std::invalid_argument(
+                "Usage: process_table [--threads N] [--stats] [--log-level LEVEL] [--plain-log] [--save snapshot_file] < input_file > output_file\n"
+                "       process_table [--threads N] [--stats] [--log-level LEVEL] [--plain-log] --load snapshot_file [--save snapshot_file] > output_file\n"
+                "       process_table [--threads N] [--stats] [--log-level LEVEL] [--plain-log] --stream WINDOW_ROWS < input_file > output_file\n"
+                "       process_table [--threads N] [--stats] [--log-level LEVEL] [--plain-log] --serve < requests > responses\n"
+                "       process_table [--threads N] [--stats] [--log-level LEVEL] [--plain-log] --socket socket_file"
+            );
+        }
+    }
+    if (options.window_height >= 0 && (!options.save_path.empty() || !options.load_path.empty())) {
+        throw std::invalid_argument("Streamed table cannot be saved to snapshot or loaded from it");
+    }
+    if (
+        (options.is_served || !options.socket_path.empty())
+        && (options.is_served == !options.socket_path.empty() || options.window_height >= 0
+            || !options.save_path.empty() || !options.load_path.empty())
+    ) {
+        throw std::invalid_argument("Server mode cannot be combined with other modes");
+    }
+
+    return options;
+}
+
+
+int openFile(const std::string &path, int flags) {
+    int file_descriptor = open(path.c_str(), flags, 0644);
+    if (file_descriptor < 0) {
+        throw std::runtime_error("Cannot open file " + path);
+    }
+    return file_descriptor;
+}
+
+
+int main(int argc, char **argv) {
 
     try {
 
-        auto raw_table = readTextTable();
+        auto options = parseOptions(argc, argv);
+        if (options.is_stats_printed && !enableStats()) {
+            log_warn("Statistics are not collected, program is built without them");
+        }
+
+        if (options.is_served || !options.socket_path.empty()) {
+            SheetEngine engine(options.thread_count);
+            if (options.is_served) {
+                int request_count = serveRequests(engine, STDIN_FILENO, STDOUT_FILENO);
+                log_info("Served requests: ", request_count);
+            } else {
+                serveSocket(engine, options.socket_path);
+            }
+            if (options.is_stats_printed) {
+                flushLog();
+                printStats(std::cerr);
+            }
+            return EXIT_SUCCESS;
+        }
+        ThreadPool thread_pool(options.thread_count);
+
+        OutputBuffer output(STDOUT_FILENO);
+        if (options.window_height >= 0) {
+            streamParsedTable(STDIN_FILENO, options.window_height, output, thread_pool);
+        } else {
+            // Parsing is timed inside of reading, the rest of it is scanning of input
+            TableSnapshot snapshot;
+            if (!options.load_path.empty()) {
+                StatsStageTimer timer(StatsStage::READ);
+                int snapshot_file = openFile(options.load_path, O_RDONLY);
+                InputBuffer snapshot_input(snapshot_file);
+                close(snapshot_file);
+                snapshot = loadSnapshot(snapshot_input);
+            } else {
+                {
+                    StatsStageTimer timer(StatsStage::READ);
+                    InputBuffer input(STDIN_FILENO);
+                    snapshot.values = readParsedTable(input, thread_pool);
+                }
+                // Formulas are kept only to be saved
+                if (!options.save_path.empty()) {
+                    snapshot.formulas = snapshot.values;
+                }
+                StatsStageTimer timer(StatsStage::EVALUATE);
+                calculateParsedTable(snapshot.values, thread_pool);
+            }
+
+            if (!options.save_path.empty()) {
+                StatsStageTimer timer(StatsStage::SAVE);
+                int snapshot_file = openFile(options.save_path, O_WRONLY | O_CREAT | O_TRUNC);
+                OutputBuffer snapshot_output(snapshot_file);
+                saveSnapshot(snapshot.formulas, snapshot.values, snapshot_output);
+                snapshot_output.flush();
+                close(snapshot_file);
+            }
 
-        auto parsed_table = parseRawTable(raw_table);
-        calculateParsedTable(parsed_table);
-        auto printed_table = makePrintedTable(parsed_table);
+            printExpressionTable(snapshot.values, output);
+        }
+        output.flush();
 
-        printTextTable(printed_table);
+        if (options.is_stats_printed) {
+            // Statistics follow all warnings
+            flushLog();
+            printStats(std::cerr);
+        }
 
     }  catch (const std::exception &exception) {
 
@@ -0,0 +1,255 @@
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+#include "coordinate.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "range_aggregator.h"
+#include "value_cache.h"
+#include "number.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+
+
+AggregateAccumulator::AggregateAccumulator()
+    : sum(0), count(0), minimum(std::numeric_limits<Number>::max()), maximum(std::numeric_limits<Number>::min()) {}
+
+void AggregateAccumulator::add(Number value) {
+    sum += value;
+    ++count;
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+}
+
+void AggregateAccumulator::addPart(WideNumber part_sum, int part_count, Number part_minimum, Number part_maximum) {
+    if (part_count == 0) {
+        return;
+    }
+    sum += part_sum;
+    count += part_count;
+    minimum = std::min(minimum, part_minimum);
+    maximum = std::max(maximum, part_maximum);
+}
+
+Result<Number> AggregateAccumulator::getResult(Aggregate function) const {
+    switch (function) {
+    case Aggregate::SUM:
+        return tryNarrowNumber(sum);
+    case Aggregate::MIN:
+        return (count > 0 ? minimum : 0);
+    case Aggregate::MAX:
+        return (count > 0 ? maximum : 0);
+    case Aggregate::COUNT:
+        return makeNumber(count);
+    case Aggregate::AVERAGE:
+        if (count == 0) {
+            return Error(ErrorCode::DIVISION_BY_ZERO);
+        }
+        return tryNarrowNumber(sum / count);
+    }
+    return Error(ErrorCode::UNIMPLEMENTED_OPERATION);
+}
+
+
+Result<bool> tryAccumulateCell(AggregateAccumulator &accumulator, const Expression *expression) {
+    if (!expression || expression->getType() == ExpressionType::NONE || expression->getType() == ExpressionType::TEXT) {
+        return false;
+    }
+    Result<Number> value = tryGetProcessedArithmeticExpressionValue(*expression);
+    if (!value.isOk()) {
+        return value.getError();
+    }
+    accumulator.add(value.getValue());
+    return true;
+}
+
+
+Result<bool> tryAccumulateCell(AggregateAccumulator &accumulator, const ValueCache &values, const Coordinate2D &coordinate) {
+    ValueState state = values.getState(coordinate);
+    if (state == ValueState::EMPTY || state == ValueState::TEXT) {
+        return false;
+    }
+    Result<Number> value = values.tryGetNumber(coordinate);
+    if (!value.isOk()) {
+        return value.getError();
+    }
+    accumulator.add(value.getValue());
+    return true;
+}
+
+
+Result<Number> tryAggregateRange(const AggregateCall &call, const ExpressionTable &values) {
+    AggregateAccumulator accumulator;
+    for (int row = call.range.first.row; row <= call.range.last.row; ++row) {
+        for (int column = call.range.first.column; column <= call.range.last.column; ++column) {
+            Result<bool> accumulated = tryAccumulateCell(accumulator, values.tryGet(row, column));
+            if (!accumulated.isOk()) {
+                return accumulated.getError();
+            }
+        }
+    }
+    return accumulator.getResult(call.function);
+}
+
+Result<Number> tryAggregateRange(const AggregateCall &call, const ValueCache &values) {
+    AggregateAccumulator accumulator;
+    for (int row = call.range.first.row; row <= call.range.last.row; ++row) {
+        for (int column = call.range.first.column; column <= call.range.last.column; ++column) {
+            Result<bool> accumulated = tryAccumulateCell(accumulator, values, {row, column});
+            if (!accumulated.isOk()) {
+                return accumulated.getError();
+            }
+        }
+    }
+    return accumulator.getResult(call.function);
+}
+
+
+int RangeAggregator::ColumnSummary::getEndRow() const {
+    return first_row + static_cast<int>(prefix_counts.size()) - 1;
+}
+
+
+RangeAggregator::RangeAggregator(const ValueCache &values_tmp, const std::vector<CellRange> &ranges)
+    : values(values_tmp), column_summary_indices(static_cast<size_t>(values_tmp.getWidth()), -1) {
+    // Summary of column covers rows from the first to the last one referred to
+    std::vector<int> first_rows(static_cast<size_t>(values.getWidth()), values.getHeight());
+    std::vector<int> end_rows(static_cast<size_t>(values.getWidth()), 0);
+    for (const auto &range : ranges) {
+        int last_column = std::min(range.last.column, values.getWidth() - 1);
+        for (int column = std::max(range.first.column, 0); column <= last_column; ++column) {
+            size_t column_index = static_cast<size_t>(column);
+            first_rows[column_index] = std::min(first_rows[column_index], std::max(range.first.row, 0));
+            end_rows[column_index] = std::max(end_rows[column_index], std::min(range.last.row + 1, values.getHeight()));
+        }
+    }
+
+    // Rows of dense columns are scanned in arrays of cache, rows of sparse ones are copied into reused arrays
+    std::vector<ValueState> copied_states;
+    std::vector<Number> copied_numbers;
+    for (int column = 0; column < values.getWidth(); ++column) {
+        int row_count = end_rows[static_cast<size_t>(column)] - first_rows[static_cast<size_t>(column)];
+        if (row_count <= 0) {
+            continue;
+        }
+        column_summary_indices[static_cast<size_t>(column)] = static_cast<int>(column_summaries.size());
+        column_summaries.emplace_back();
+        auto &summary = column_summaries.back();
+        summary.first_row = first_rows[static_cast<size_t>(column)];
+        summary.prefix_sums.assign(static_cast<size_t>(row_count) + 1, 0);
+        summary.prefix_counts.assign(static_cast<size_t>(row_count) + 1, 0);
+        summary.prefix_error_counts.assign(static_cast<size_t>(row_count) + 1, 0);
+
+        // Rows [stored_first_row, stored_first_row + stored_row_count) are stored in arrays, the others are empty
+        int stored_first_row = 0;
+        int stored_row_count = 0;
+        const ValueState *states = nullptr;
+        const Number *numbers = nullptr;
+        if (!values.tryGetDenseColumn(column, stored_first_row, stored_row_count, states, numbers)) {
+            copied_states.resize(static_cast<size_t>(row_count));
+            copied_numbers.resize(static_cast<size_t>(row_count));
+            values.copyColumn(column, summary.first_row, summary.getEndRow(), copied_states.data(), copied_numbers.data());
+            stored_first_row = summary.first_row;
+            stored_row_count = row_count;
+            states = copied_states.data();
+            numbers = copied_numbers.data();
+        }
+
+        for (size_t index = 0; index < static_cast<size_t>(row_count); ++index) {
+            int row = summary.first_row + static_cast<int>(index);
+            summary.prefix_sums[index + 1] = summary.prefix_sums[index];
+            summary.prefix_counts[index + 1] = summary.prefix_counts[index];
+            summary.prefix_error_counts[index + 1] = summary.prefix_error_counts[index];
+            if (row < stored_first_row || row >= stored_first_row + stored_row_count) {
+                continue;
+            }
+            size_t stored_index = static_cast<size_t>(row - stored_first_row);
+            ValueState state = states[stored_index];
+            // Numbers of cells which are not numbers are 0, so they are summed without branches
+            summary.prefix_sums[index + 1] += numbers[stored_index];
+            summary.prefix_counts[index + 1] += (state == ValueState::NUMBER);
+            summary.prefix_error_counts[index + 1] += (state == ValueState::ERROR);
+            if (state == ValueState::PENDING) {
+                summary.pending_rows.push_back(row);
+            }
+        }
+    }
+}
+
+
+Result<Number> RangeAggregator::tryAggregate(const AggregateCall &call) const {
+    const auto &range = call.range;
+    bool is_extremum = (call.function == Aggregate::MIN || call.function == Aggregate::MAX);
+    AggregateAccumulator accumulator;
+
+    for (int column = range.first.column; column <= range.last.column; ++column) {
+        int summary_index = column_summary_indices[static_cast<size_t>(column)];
+        if (
+            summary_index == -1 || range.first.row < column_summaries[static_cast<size_t>(summary_index)].first_row
+            || range.last.row >= column_summaries[static_cast<size_t>(summary_index)].getEndRow()
+        ) {
+            // Range was not known beforehand
+            for (int row = range.first.row; row <= range.last.row; ++row) {
+                Result<bool> accumulated = tryAccumulateCell(accumulator, values, {row, column});
+                if (!accumulated.isOk()) {
+                    return accumulated.getError();
+                }
+            }
+            continue;
+        }
+        const auto &summary = column_summaries[static_cast<size_t>(summary_index)];
+        size_t begin_index = static_cast<size_t>(range.first.row - summary.first_row);
+        size_t end_index = static_cast<size_t>(range.last.row + 1 - summary.first_row);
+
+        if (summary.prefix_error_counts[end_index] != summary.prefix_error_counts[begin_index]) {
+            return Error(ErrorCode::ERROR_IN_REFERRED_CELL);
+        }
+
+        // Pending cells of range are calculated already, so cached values of all cells of range are final;
+        // pending cells are added once more below, which does not change minimum or maximum
+        Number part_minimum = std::numeric_limits<Number>::max();
+        Number part_maximum = std::numeric_limits<Number>::min();
+        if (is_extremum) {
+            int stored_first_row = 0;
+            int stored_row_count = 0;
+            const ValueState *states = nullptr;
+            const Number *numbers = nullptr;
+            if (values.tryGetDenseColumn(column, stored_first_row, stored_row_count, states, numbers)) {
+                int begin_row = std::max(range.first.row, stored_first_row);
+                int end_row = std::min(range.last.row + 1, stored_first_row + stored_row_count);
+                for (int row = begin_row; row < end_row; ++row) {
+                    size_t index = static_cast<size_t>(row - stored_first_row);
+                    bool is_number = (states[index] == ValueState::NUMBER);
+                    part_minimum = std::min(part_minimum, is_number ? numbers[index] : std::numeric_limits<Number>::max());
+                    part_maximum = std::max(part_maximum, is_number ? numbers[index] : std::numeric_limits<Number>::min());
+                }
+            } else {
+                for (int row = range.first.row; row <= range.last.row; ++row) {
+                    if (values.getState({row, column}) == ValueState::NUMBER) {
+                        Number number = values.tryGetNumber({row, column}).getValue();
+                        part_minimum = std::min(part_minimum, number);
+                        part_maximum = std::max(part_maximum, number);
+                    }
+                }
+            }
+        }
+        accumulator.addPart(
+            summary.prefix_sums[end_index] - summary.prefix_sums[begin_index],
+            summary.prefix_counts[end_index] - summary.prefix_counts[begin_index],
+            part_minimum, part_maximum
+        );
+
+        auto pending_begin = std::lower_bound(summary.pending_rows.begin(), summary.pending_rows.end(), range.first.row);
+        auto pending_end = std::lower_bound(pending_begin, summary.pending_rows.end(), range.last.row + 1);
+        for (auto pending_row = pending_begin; pending_row != pending_end; ++pending_row) {
+            Result<bool> accumulated = tryAccumulateCell(accumulator, values, {*pending_row, column});
+            if (!accumulated.isOk()) {
+                return accumulated.getError();
+            }
+        }
+    }
+
+    return accumulator.getResult(call.function);
+}
@@ -0,0 +1,80 @@
+#ifndef RANGE_AGGREGATOR_H_INCLUDED
+#define RANGE_AGGREGATOR_H_INCLUDED
+
+#include <vector>
+#include <cstdint>
+
+#include "coordinate.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "value_cache.h"
+#include "number.h"
+
+
+// Running state of aggregate function over values of cells
+class AggregateAccumulator
+{
+    // Sum is wide, so only its final value may overflow
+    WideNumber sum;
+    int count;
+    Number minimum;
+    Number maximum;
+public:
+    AggregateAccumulator();
+
+    void add(Number value);
+    // Adds part of range summarized beforehand, its minimum and maximum matter only if part_count > 0
+    void addPart(WideNumber part_sum, int part_count, Number part_minimum, Number part_maximum);
+
+    // MIN and MAX of range without numbers are 0, AVG of it is division by zero
+    Result<Number> getResult(Aggregate function) const;
+};
+
+
+// Adds value of cell of range: empty and text cells are skipped, errors are reported
+Result<bool> tryAccumulateCell(AggregateAccumulator &accumulator, const Expression *expression);
+
+
+// Adds cached value of cell of range the same way
+Result<bool> tryAccumulateCell(AggregateAccumulator &accumulator, const ValueCache &values, const Coordinate2D &coordinate);
+
+
+// Aggregate over calculated cells of range lying in table, every cell is looked up
+Result<Number> tryAggregateRange(const AggregateCall &call, const ExpressionTable &values);
+
+Result<Number> tryAggregateRange(const AggregateCall &call, const ValueCache &values);
+
+
+// Aggregates over ranges of table being calculated.
+// Cells which are not pending keep their values during calculation, so prefix sums over them are computed
+// once per column and shared by all formulas; pending cells are looked up one by one and should be calculated
+// when their range is aggregated. Minimums and maximums are found by scanning column arrays of cache in place.
+class RangeAggregator
+{
+    struct ColumnSummary
+    {
+        // Summary covers rows [first_row, first_row + prefix_counts.size() - 1)
+        int first_row;
+        // Sums, numbers and errors of static cells of rows [first_row, first_row + i)
+        std::vector<WideNumber> prefix_sums;
+        std::vector<int> prefix_counts;
+        std::vector<int> prefix_error_counts;
+        std::vector<int> pending_rows;
+
+        int getEndRow() const;
+    };
+
+    const ValueCache &values;
+    // Index of summary of column in column_summaries or -1
+    std::vector<int> column_summary_indices;
+    std::vector<ColumnSummary> column_summaries;
+public:
+    // Summaries are made for columns of given ranges, cells which are PENDING in values are pending
+    RangeAggregator(const ValueCache &values_tmp, const std::vector<CellRange> &ranges);
+
+    // Range should lie in table
+    Result<Number> tryAggregate(const AggregateCall &call) const;
+};
+
+
+#endif // RANGE_AGGREGATOR_H_INCLUDED
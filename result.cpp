@@ -0,0 +1,75 @@
+#include <string>
+
+#include "utils.h"
+#include "result.h"
+
+
+StringRef getErrorMessagePrefix(ErrorCode code) {
+    switch (code) {
+    case ErrorCode::NOT_A_NUMBER:
+        return "'";
+    case ErrorCode::NUMBER_TOO_LARGE:
+        return "Number '";
+    case ErrorCode::ILL_FORMED_COORDINATE:
+        return "Coordinate '";
+    case ErrorCode::UNKNOWN_OPERATION:
+        return "Operation '";
+    case ErrorCode::UNKNOWN_FUNCTION:
+        return "Function '";
+    case ErrorCode::ILL_FORMED_FUNCTION_CALL:
+        return "Function call '";
+    case ErrorCode::UNIMPLEMENTED_OPERATION:
+        return "Unimplemented operation";
+    case ErrorCode::OPERATION_IN_WRONG_PLACE:
+        return "Operation in wrong place";
+    case ErrorCode::UNIMPLEMENTED_LEXEM_TYPE:
+        return "Unimplemented lexem type";
+    case ErrorCode::EXCESS_OPERATION:
+        return "Excess operation in the end";
+    case ErrorCode::EMPTY_EXPRESSION:
+        return "Empty expression";
+    case ErrorCode::UNBALANCED_PARENTHESES:
+        return "Unbalanced parentheses";
+    case ErrorCode::DIVISION_BY_ZERO:
+        return "Division by 0";
+    case ErrorCode::ARITHMETIC_OVERFLOW:
+        return "Arithmetic overflow";
+    case ErrorCode::ERROR_IN_REFERRED_CELL:
+        return "Error in referred cell";
+    case ErrorCode::NOT_A_NUMBER_IN_REFERRED_CELL:
+        return "Not a number in referred cell";
+    case ErrorCode::INFINITE_CYCLE:
+        return "Infinite cycle in references";
+    case ErrorCode::OTHER:
+        return "";
+    }
+    return "";
+}
+
+
+StringRef getErrorMessageSuffix(ErrorCode code) {
+    switch (code) {
+    case ErrorCode::NOT_A_NUMBER:
+#ifdef DECIMAL_NUMBERS
+        return "' is not a non-negative decimal number";
+#else
+        return "' is not a non-negative integer number";
+#endif
+    case ErrorCode::NUMBER_TOO_LARGE:
+        return "' is too large";
+    case ErrorCode::ILL_FORMED_COORDINATE:
+        return "' is ill-formed";
+    case ErrorCode::UNKNOWN_OPERATION:
+    case ErrorCode::UNKNOWN_FUNCTION:
+        return "' is unknown";
+    case ErrorCode::ILL_FORMED_FUNCTION_CALL:
+        return "' is ill-formed";
+    default:
+        return "";
+    }
+}
+
+
+std::string makeErrorDescription(const Error &error) {
+    return getErrorMessagePrefix(error.code).toString() + error.argument.toString() + getErrorMessageSuffix(error.code).toString();
+}
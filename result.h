@@ -0,0 +1,89 @@
+#ifndef RESULT_H_INCLUDED
+#define RESULT_H_INCLUDED
+
+#include <string>
+#include <utility>
+#include <stdexcept>
+
+#include "utils.h"
+
+
+// Errors in data found while parsing and calculating cells
+enum class ErrorCode {
+    NOT_A_NUMBER,
+    NUMBER_TOO_LARGE,
+    ILL_FORMED_COORDINATE,
+    UNKNOWN_OPERATION,
+    UNKNOWN_FUNCTION,
+    ILL_FORMED_FUNCTION_CALL,
+    UNIMPLEMENTED_OPERATION,
+    OPERATION_IN_WRONG_PLACE,
+    UNIMPLEMENTED_LEXEM_TYPE,
+    EXCESS_OPERATION,
+    EMPTY_EXPRESSION,
+    UNBALANCED_PARENTHESES,
+    DIVISION_BY_ZERO,
+    ARITHMETIC_OVERFLOW,
+    ERROR_IN_REFERRED_CELL,
+    NOT_A_NUMBER_IN_REFERRED_CELL,
+    INFINITE_CYCLE,
+    // Argument is the whole message
+    OTHER
+};
+
+
+// Code of error and text it refers to, e.g. malformed lexem; message is made only when it is needed
+struct Error
+{
+    ErrorCode code;
+    StringRef argument;
+
+    Error(ErrorCode code_tmp, const StringRef &argument_tmp = {}) : code(code_tmp), argument(argument_tmp) {}
+};
+
+// Message of error without leading '#', the same as message of exception thrown for it
+std::string makeErrorDescription(const Error &error);
+
+// Message is prefix, argument and suffix
+StringRef getErrorMessagePrefix(ErrorCode code);
+StringRef getErrorMessageSuffix(ErrorCode code);
+
+
+// Value or error: result of operation which may fail on ordinary data, reported without exceptions
+template <typename ValueType>
+class Result
+{
+    ValueType value;
+    bool is_ok;
+    Error error;
+public:
+    Result(const ValueType &value_tmp) : value(value_tmp), is_ok(true), error(ErrorCode::OTHER) {}
+    Result(const Error &error_tmp) : value(), is_ok(false), error(error_tmp) {}
+
+    bool isOk() const {
+        return is_ok;
+    }
+
+    const ValueType &getValue() const {
+        return value;
+    }
+
+    const Error &getError() const {
+        return error;
+    }
+
+    // Value or std::invalid_argument with message of error
+    const ValueType &getValueOrThrow() const;
+};
+
+
+template <typename ValueType>
+const ValueType &Result<ValueType>::getValueOrThrow() const {
+    if (!is_ok) {
+        throw std::invalid_argument(makeErrorDescription(error));
+    }
+    return value;
+}
+
+
+#endif // RESULT_H_INCLUDED
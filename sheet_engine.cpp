@@ -0,0 +1,117 @@
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "utils.h"
+#include "coordinate.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "workbook.h"
+#include "sheet_engine.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "stats.h"
+
+
+SheetEngine::SheetEngine(int thread_count) : thread_pool(thread_count), is_evaluated(false) {}
+
+
+void SheetEngine::load(const InputBuffer &input) {
+    StatsStageTimer timer(StatsStage::READ);
+    // Parsed table is moved rather than copied, sheet is replaced only if input is read
+    auto parsed_table = readParsedTable(input, thread_pool);
+    workbook.reset();
+    formulas = std::move(parsed_table);
+    values = ExpressionTable();
+    is_evaluated = false;
+}
+
+
+void SheetEngine::load(const ExpressionTable &formulas_tmp) {
+    workbook.reset();
+    formulas = formulas_tmp;
+    values = ExpressionTable();
+    is_evaluated = false;
+}
+
+
+void SheetEngine::evaluate() {
+    if (is_evaluated) {
+        return;
+    }
+    StatsStageTimer timer(StatsStage::EVALUATE);
+    values = formulas;
+    calculateParsedTable(values, thread_pool);
+    is_evaluated = true;
+}
+
+
+bool SheetEngine::isEvaluated() const {
+    return is_evaluated;
+}
+
+
+int SheetEngine::getHeight() const {
+    return (workbook ? workbook->getHeight() : formulas.getHeight());
+}
+
+
+int SheetEngine::getWidth() const {
+    return (workbook ? workbook->getWidth() : formulas.getWidth());
+}
+
+
+const ExpressionTable &SheetEngine::getValues() const {
+    return (workbook ? workbook->getValues() : values);
+}
+
+
+void SheetEngine::assertEvaluated() const {
+    if (!is_evaluated) {
+        throw std::logic_error("Sheet should be evaluated first");
+    }
+}
+
+
+const Expression &SheetEngine::getValue(const Coordinate2D &coordinate) const {
+    assertEvaluated();
+    if (!getValues().isInRange(coordinate)) {
+        throw std::out_of_range(makeOutOfRangeMessage(coordinate, getHeight(), getWidth()));
+    }
+    return getValues()(coordinate);
+}
+
+
+const Expression &SheetEngine::getFormula(const Coordinate2D &coordinate) const {
+    const auto &table = (workbook ? workbook->getFormulas() : formulas);
+    if (!table.isInRange(coordinate)) {
+        throw std::out_of_range(makeOutOfRangeMessage(coordinate, getHeight(), getWidth()));
+    }
+    return table(coordinate);
+}
+
+
+int SheetEngine::setCell(const Coordinate2D &coordinate, const std::string &raw_text) {
+    assertEvaluated();
+    if (!workbook) {
+        workbook = std::make_unique<Workbook>(formulas, values);
+        formulas = ExpressionTable();
+        values = ExpressionTable();
+    }
+    if (!workbook->getFormulas().isInRange(coordinate)) {
+        throw std::out_of_range(makeOutOfRangeMessage(coordinate, getHeight(), getWidth()));
+    }
+    return workbook->setCell(coordinate, raw_text);
+}
+
+
+void SheetEngine::print(OutputBuffer &output) const {
+    assertEvaluated();
+    printExpressionTable(getValues(), output);
+}
+
+
+const std::shared_ptr<CellPools> &SheetEngine::getPools() const {
+    return (workbook ? workbook->getFormulas() : formulas).getPools();
+}
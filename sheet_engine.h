@@ -0,0 +1,60 @@
+#ifndef SHEET_ENGINE_H_INCLUDED
+#define SHEET_ENGINE_H_INCLUDED
+
+#include <string>
+#include <memory>
+
+#include "coordinate.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "workbook.h"
+#include "thread_pool.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+
+
+// Table processing for programs using it as library: sheet is loaded from input of process_table,
+// evaluated, queried and edited cell by cell. Engine keeps its threads between sheets, while texts and
+// formulas of cells are interned into pools of loaded sheet, so they are freed when sheet is replaced.
+// Functions throw std::invalid_argument for malformed input and std::out_of_range for cells out of sheet
+class SheetEngine
+{
+    ThreadPool thread_pool;
+    ExpressionTable formulas;
+    ExpressionTable values;
+    bool is_evaluated;
+    // Made at the first edit, as loaded sheets are mostly evaluated and printed only;
+    // it holds formulas and values from then on
+    std::unique_ptr<Workbook> workbook;
+
+    const ExpressionTable &getValues() const;
+    void assertEvaluated() const;
+public:
+    explicit SheetEngine(int thread_count = 1);
+
+    // Replaces sheet with one read from input, it is not evaluated yet
+    void load(const InputBuffer &input);
+    void load(const ExpressionTable &formulas_tmp);
+    // Calculates values of all cells of loaded sheet
+    void evaluate();
+    bool isEvaluated() const;
+
+    int getHeight() const;
+    int getWidth() const;
+    // Value of cell of evaluated sheet
+    const Expression &getValue(const Coordinate2D &coordinate) const;
+    const Expression &getFormula(const Coordinate2D &coordinate) const;
+
+    // Replaces formula of cell of evaluated sheet and recalculates cells depending on it,
+    // returns number of recalculated cells
+    int setCell(const Coordinate2D &coordinate, const std::string &raw_text);
+
+    // Values of evaluated sheet the same way as process_table prints them
+    void print(OutputBuffer &output) const;
+
+    // Pools cells of loaded sheet are interned into
+    const std::shared_ptr<CellPools> &getPools() const;
+};
+
+
+#endif // SHEET_ENGINE_H_INCLUDED
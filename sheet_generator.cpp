@@ -0,0 +1,179 @@
+#include <string>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+#include "sheet_generator.h"
+
+
+// A1-style name of cell
+std::string makeCellName(int row, int column) {
+    // Columns are numbered in bijective base-26 numeral system
+    std::string name;
+    for (int column_number = column + 1; column_number > 0; column_number = (column_number - 1) / 26) {
+        name.insert(name.begin(), static_cast<char>('A' + (column_number - 1) % 26));
+    }
+    return name + std::to_string(row + 1);
+}
+
+
+// Reference to one of cells of table
+std::string makeRawReference(std::mt19937 &generator, int height, int width) {
+    int row = static_cast<int>(generator() % static_cast<unsigned>(height));
+    int column = static_cast<int>(generator() % static_cast<unsigned>(width));
+    return makeCellName(row, column);
+}
+
+
+// Aggregate function over range of table of at most 100 rows and 3 columns
+std::string makeRawAggregate(std::mt19937 &generator, int height, int width) {
+    const std::string functions[] = {"SUM", "MIN", "MAX", "COUNT", "AVG"};
+    int first_row = static_cast<int>(generator() % static_cast<unsigned>(height));
+    int first_column = static_cast<int>(generator() % static_cast<unsigned>(width));
+    int last_row = std::min(height - 1, first_row + static_cast<int>(generator() % 100));
+    int last_column = std::min(width - 1, first_column + static_cast<int>(generator() % 3));
+    return
+        functions[generator() % 5] + "("
+        + makeCellName(first_row, first_column) + ":" + makeCellName(last_row, last_column) + ")";
+}
+
+
+std::string generateRawSheet(int height, int width, unsigned seed) {
+    std::mt19937 generator(seed);
+    const std::string operations = "+-*/";
+
+    std::string sheet = std::to_string(height) + "\t" + std::to_string(width) + "\n";
+    for (int row_index = 0; row_index < height; ++row_index) {
+        for (int column_index = 0; column_index < width; ++column_index) {
+            switch (generator() % 8) {
+            case 0:
+                // Empty cell
+                break;
+            case 1:
+            case 2:
+                sheet += std::to_string(generator() % 100000);
+                break;
+            case 3:
+                sheet += "'Text " + std::to_string(row_index);
+                break;
+            case 4:
+                // Malformed cell
+                sheet += "=1+x" + std::to_string(column_index);
+                break;
+            default:
+                sheet += "=" + makeRawReference(generator, height, width);
+                for (int operand_index = generator() % 4; operand_index > 0; --operand_index) {
+                    sheet.push_back(operations[generator() % operations.size()]);
+                    switch (generator() % 5) {
+                    case 0:
+                    case 1:
+                        sheet += makeRawReference(generator, height, width);
+                        break;
+                    case 2:
+                        sheet += makeRawAggregate(generator, height, width);
+                        break;
+                    case 3:
+                        sheet += "(" + makeRawReference(generator, height, width);
+                        sheet.push_back(operations[generator() % operations.size()]);
+                        sheet += std::to_string(generator() % 1000) + ")";
+                        break;
+                    default:
+                        sheet += std::to_string(generator() % 1000);
+                    }
+                }
+            }
+            sheet.push_back(column_index + 1 == width ? '\n' : '\t');
+        }
+    }
+    return sheet;
+}
+
+
+SheetOptions::SheetOptions(int height_tmp, int width_tmp)
+    : height(height_tmp), width(width_tmp), seed(42), density(0.875), formula_ratio(0.43), text_ratio(0.14),
+      error_ratio(0.14), aggregate_ratio(0.2), parenthesis_ratio(0.2), fan_in(3), chain_depth(0) {}
+
+
+SheetOptions parseSheetOptions(int height, int width, int argument_count, char **arguments) {
+    SheetOptions options(height, width);
+    for (int argument_index = 0; argument_index < argument_count; ++argument_index) {
+        std::string argument = arguments[argument_index];
+        if (argument_index + 1 == argument_count) {
+            throw std::invalid_argument("Option " + argument + " should have value");
+        }
+        std::string value = arguments[++argument_index];
+        if (argument == "--density") {
+            options.density = std::stod(value);
+        } else if (argument == "--formulas") {
+            options.formula_ratio = std::stod(value);
+        } else if (argument == "--texts") {
+            options.text_ratio = std::stod(value);
+        } else if (argument == "--errors") {
+            options.error_ratio = std::stod(value);
+        } else if (argument == "--aggregates") {
+            options.aggregate_ratio = std::stod(value);
+        } else if (argument == "--parentheses") {
+            options.parenthesis_ratio = std::stod(value);
+        } else if (argument == "--fan-in") {
+            options.fan_in = std::stoi(value);
+        } else if (argument == "--chain") {
+            options.chain_depth = std::stoi(value);
+        } else if (argument == "--seed") {
+            options.seed = static_cast<unsigned>(std::stoul(value));
+        } else {
+            throw std::invalid_argument("Unknown option " + argument);
+        }
+    }
+    if (options.height <= 0 || options.width <= 0 || options.fan_in <= 0 || options.chain_depth < 0) {
+        throw std::invalid_argument("Sizes, fan-in and chain depth should be positive");
+    }
+    return options;
+}
+
+
+std::string generateRawSheet(const SheetOptions &options) {
+    std::mt19937 generator(options.seed);
+    std::uniform_real_distribution<double> fraction_distribution(0, 1);
+    auto isChosen = [&generator, &fraction_distribution](double fraction) {
+        return fraction_distribution(generator) < fraction;
+    };
+    const std::string operations = "+-*/";
+
+    std::string sheet = std::to_string(options.height) + "\t" + std::to_string(options.width) + "\n";
+    for (int row_index = 0; row_index < options.height; ++row_index) {
+        for (int column_index = 0; column_index < options.width; ++column_index) {
+            double kind = fraction_distribution(generator);
+            if (!isChosen(options.density)) {
+                // Empty cell
+            } else if ((kind -= options.formula_ratio) < 0) {
+                sheet.push_back('=');
+                for (int operand_index = 0; operand_index < options.fan_in; ++operand_index) {
+                    if (operand_index > 0) {
+                        sheet.push_back(operations[generator() % operations.size()]);
+                    }
+                    bool is_chained = (operand_index == 0 && options.chain_depth > 0 && row_index % options.chain_depth != 0);
+                    if (is_chained) {
+                        sheet += makeCellName(row_index - 1, column_index);
+                    } else if (isChosen(options.aggregate_ratio)) {
+                        sheet += makeRawAggregate(generator, options.height, options.width);
+                    } else if (isChosen(options.parenthesis_ratio)) {
+                        sheet += "(" + makeRawReference(generator, options.height, options.width);
+                        sheet.push_back(operations[generator() % operations.size()]);
+                        sheet += std::to_string(generator() % 1000) + ")";
+                    } else {
+                        sheet += makeRawReference(generator, options.height, options.width);
+                    }
+                }
+            } else if ((kind -= options.text_ratio) < 0) {
+                sheet += "'Text " + std::to_string(row_index);
+            } else if ((kind -= options.error_ratio) < 0) {
+                // Malformed cell
+                sheet += "=1+x" + std::to_string(column_index);
+            } else {
+                sheet += std::to_string(generator() % 100000);
+            }
+            sheet.push_back(column_index + 1 == options.width ? '\n' : '\t');
+        }
+    }
+    return sheet;
+}
@@ -0,0 +1,49 @@
+#ifndef SHEET_GENERATOR_H_INCLUDED
+#define SHEET_GENERATOR_H_INCLUDED
+
+#include <string>
+
+
+// A1-style name of cell
+std::string makeCellName(int row, int column);
+
+
+// Input of process_table: header and tab-separated cells with numbers, texts,
+// formulas referring to other cells and some malformed cells; the same seed gives the same sheet
+std::string generateRawSheet(int height, int width, unsigned seed = 42);
+
+
+// Shape of sheet made by generateRawSheet(const SheetOptions&)
+struct SheetOptions
+{
+    int height;
+    int width;
+    unsigned seed;
+    // Fraction of filled cells
+    double density;
+    // Fractions of filled cells which are formulas, texts and malformed cells; the rest are numbers
+    double formula_ratio;
+    double text_ratio;
+    double error_ratio;
+    // Fractions of operands of formulas which are aggregates over ranges and parenthesized operations;
+    // the rest are references to random cells
+    double aggregate_ratio;
+    double parenthesis_ratio;
+    // Number of operands of every formula
+    int fan_in;
+    // If positive, the first operand of formula refers to the cell above it, except for every chain_depth-th row,
+    // so columns of formulas make chains of references of this length
+    int chain_depth;
+
+    SheetOptions(int height_tmp = 1000, int width_tmp = 1000);
+};
+
+// Options are taken from arguments "--density P", "--formulas P", "--texts P", "--errors P",
+// "--aggregates P", "--parentheses P", "--fan-in N", "--chain N" and "--seed N",
+// throws std::invalid_argument for unknown or malformed ones
+SheetOptions parseSheetOptions(int height, int width, int argument_count, char **arguments);
+
+std::string generateRawSheet(const SheetOptions &options);
+
+
+#endif // SHEET_GENERATOR_H_INCLUDED
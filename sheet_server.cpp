@@ -0,0 +1,234 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "utils.h"
+#include "number.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "sheet_engine.h"
+#include "sheet_server.h"
+#include "logger.h"
+
+
+// Header line holds only length, so longer lines are not searched for its end
+const size_t MAX_HEADER_SIZE = 64;
+
+// Buffer grown for large request shrinks back to this size
+const size_t INITIAL_BUFFER_SIZE = 1 << 16;
+
+
+// Reads framed request bodies from descriptor into one buffer reused for all requests
+class FrameReader
+{
+    int file_descriptor;
+    size_t max_body_size;
+    std::vector<char> buffer;
+    // Unread data is buffer[begin, end)
+    size_t begin;
+    size_t end;
+    // Input after malformed header cannot be split into requests
+    bool is_framed;
+
+    // Appends next part of input to unread data, returns false at the end of input.
+    // Full buffer is doubled, but not beyond given size, so it grows only as data of frame arrives
+    bool readMore(size_t max_buffer_size);
+public:
+    FrameReader(int file_descriptor_tmp, size_t max_body_size_tmp);
+
+    // Body of next request, valid until the next call; returns false at the end of input or after malformed header.
+    // Error message is set instead of body for malformed header and for body longer than maximum, which is skipped
+    bool tryReadFrame(StringRef &body, std::string &error_message);
+};
+
+
+FrameReader::FrameReader(int file_descriptor_tmp, size_t max_body_size_tmp)
+    : file_descriptor(file_descriptor_tmp), max_body_size(max_body_size_tmp), buffer(INITIAL_BUFFER_SIZE), begin(0), end(0), is_framed(true) {}
+
+
+bool FrameReader::readMore(size_t max_buffer_size) {
+    if (end == buffer.size()) {
+        buffer.resize(std::min(buffer.size() * 2, max_buffer_size));
+    }
+    while (true) {
+        ssize_t read_size = read(file_descriptor, buffer.data() + end, buffer.size() - end);
+        if (read_size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot read request");
+        }
+        end += static_cast<size_t>(read_size);
+        return read_size > 0;
+    }
+}
+
+
+bool FrameReader::tryReadFrame(StringRef &body, std::string &error_message) {
+    error_message.clear();
+    if (!is_framed) {
+        return false;
+    }
+    // Unread data is moved to the beginning, so buffer grows only for large requests
+    std::copy(buffer.begin() + static_cast<ptrdiff_t>(begin), buffer.begin() + static_cast<ptrdiff_t>(end), buffer.begin());
+    end -= begin;
+    begin = 0;
+    // Memory of served large request is not kept for the lifetime of server
+    if (buffer.size() > INITIAL_BUFFER_SIZE && end <= INITIAL_BUFFER_SIZE) {
+        buffer.resize(INITIAL_BUFFER_SIZE);
+        buffer.shrink_to_fit();
+    }
+
+    const char *line_end = nullptr;
+    size_t searched_size = 0;
+    while (!(line_end = static_cast<const char*>(std::memchr(buffer.data() + searched_size, '\n', end - searched_size)))) {
+        searched_size = end;
+        if (searched_size > MAX_HEADER_SIZE) {
+            error_message = "Request header should not be longer than " + std::to_string(MAX_HEADER_SIZE) + " characters";
+            is_framed = false;
+            return true;
+        }
+        if (!readMore(buffer.size())) {
+            if (end == 0) {
+                return false;
+            }
+            throw std::runtime_error("Input ends inside of request header");
+        }
+    }
+    size_t header_size = static_cast<size_t>(line_end - buffer.data()) + 1;
+    size_t body_size = 0;
+    try {
+        body_size = static_cast<size_t>(parseCount(StringRef(buffer.data(), line_end)));
+    } catch (const std::invalid_argument &exception) {
+        error_message = std::string("Request header should be length of request: ") + exception.what();
+        is_framed = false;
+        return true;
+    }
+
+    if (body_size > max_body_size) {
+        // Body is read and dropped part by part, so requests after it are framed as usual
+        error_message = "Request should not be longer than " + std::to_string(max_body_size) + " bytes";
+        begin = header_size;
+        size_t skipped_size = std::min(end - begin, body_size);
+        while (true) {
+            begin += skipped_size;
+            body_size -= skipped_size;
+            if (body_size == 0) {
+                return true;
+            }
+            begin = end = 0;
+            if (!readMore(buffer.size())) {
+                throw std::runtime_error("Input ends inside of request body");
+            }
+            skipped_size = std::min(end, body_size);
+        }
+    }
+
+    while (end < header_size + body_size) {
+        if (!readMore(header_size + body_size)) {
+            throw std::runtime_error("Input ends inside of request body");
+        }
+    }
+    body = StringRef(buffer.data() + header_size, buffer.data() + header_size + body_size);
+    begin = header_size + body_size;
+    return true;
+}
+
+
+int serveRequests(SheetEngine &engine, int input_descriptor, int output_descriptor, size_t max_request_size) {
+    FrameReader reader(input_descriptor, max_request_size);
+    OutputBuffer response_output(output_descriptor);
+    // Printed sheet is collected to know its length before header is written
+    std::ostringstream body_stream;
+    OutputBuffer body_output(body_stream);
+
+    int request_count = 0;
+    StringRef request;
+    std::string frame_error;
+    while (reader.tryReadFrame(request, frame_error)) {
+        auto start_time = std::chrono::steady_clock::now();
+        body_stream.str("");
+        bool is_ok = frame_error.empty();
+        if (!is_ok) {
+            body_stream << frame_error;
+        }
+        try {
+            if (is_ok) {
+                InputBuffer input(request);
+                engine.load(input);
+                engine.evaluate();
+                engine.print(body_output);
+                body_output.flush();
+            }
+        } catch (const std::exception &exception) {
+            is_ok = false;
+            body_output.flush();
+            body_stream.str("");
+            body_stream << exception.what();
+        }
+        std::string body = body_stream.str();
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+
+        std::string header =
+            std::string(is_ok ? "OK " : "ERROR ") + std::to_string(body.size()) + " " + std::to_string(latency.count()) + "\n";
+        response_output.append(header);
+        response_output.append(body);
+        response_output.flush();
+        ++request_count;
+    }
+    return request_count;
+}
+
+
+void serveSocket(SheetEngine &engine, const std::string &socket_path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path should have from 1 to " + std::to_string(sizeof(address.sun_path) - 1) + " characters");
+    }
+    std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+
+    int listening_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listening_socket < 0) {
+        throw std::runtime_error("Cannot create socket");
+    }
+    unlink(socket_path.c_str());
+    if (
+        bind(listening_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+        || listen(listening_socket, SOMAXCONN) < 0
+    ) {
+        close(listening_socket);
+        throw std::runtime_error("Cannot listen on socket " + socket_path);
+    }
+    // Client closing its connection early should not stop server
+    std::signal(SIGPIPE, SIG_IGN);
+    log_info("Serving sheets on socket ", socket_path);
+
+    while (true) {
+        int connection = accept(listening_socket, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            close(listening_socket);
+            throw std::runtime_error("Cannot accept connection on socket " + socket_path);
+        }
+        try {
+            serveRequests(engine, connection, connection);
+        } catch (const std::exception &exception) {
+            log_warn("Connection is closed: ", exception.what());
+        }
+        close(connection);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef SHEET_SERVER_H_INCLUDED
+#define SHEET_SERVER_H_INCLUDED
+
+#include <string>
+#include <cstddef>
+
+#include "sheet_engine.h"
+
+
+// Server mode evaluates sheets sent one after another with the same engine, so its threads are reused,
+// while cells of every sheet are interned into its own pools, freed when the next sheet is loaded. Requests and responses are framed by header line with length of body:
+//   request:  "<length>\n" followed by sheet in input format of process_table
+//   response: "OK <length> <microseconds>\n" followed by printed values of sheet,
+//             or "ERROR <length> <microseconds>\n" followed by message
+// Microseconds are latency of request from the end of its reading to the start of writing of response.
+// Request longer than maximum is skipped and answered with error; malformed header is answered with error too,
+// but input after it cannot be split into requests, so serving stops
+
+
+// Requests are read into one buffer, so their length is limited
+const size_t MAX_REQUEST_SIZE = size_t(1) << 30;
+
+
+// Serves requests read from input descriptor until its end and writes responses to output descriptor,
+// returns number of responses. Throws std::runtime_error if input ends inside of request or output cannot be written
+int serveRequests(SheetEngine &engine, int input_descriptor, int output_descriptor, size_t max_request_size = MAX_REQUEST_SIZE);
+
+
+// Listens on Unix-domain socket at given path, replacing file there, and serves connections one by one forever
+void serveSocket(SheetEngine &engine, const std::string &socket_path);
+
+
+#endif // SHEET_SERVER_H_INCLUDED
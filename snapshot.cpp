@@ -0,0 +1,489 @@
+#include <vector>
+#include <memory>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+
+#include "utils.h"
+#include "coordinate.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "number.h"
+#include "formula_pool.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+
+
+// Snapshot is magic followed by variable-length numbers: version, count of fraction digits of numbers, height, width, count of cells
+// and cells in row-major order. Every cell is its position relative to previous cell, its formula and value.
+// Expression is tag of type and form, code of error for ERROR one, reference to text and argument of form.
+// Strings and formulas are written where they are used first and referred to by distance back later.
+// Formula is count of tokens, anchor relative to cell and tokens relative to anchor,
+// so formula copied along row or column is written once
+const char SNAPSHOT_MAGIC[8] = {'P', 'T', 'S', 'N', 'A', 'P', '\0', '\0'};
+const uint64_t SNAPSHOT_VERSION = 2;
+
+
+enum class SnapshotForm {
+    EMPTY,
+    // Argument is number of expression of single number
+    NUMBER,
+    // Argument is reference to formula
+    FORMULA
+};
+
+// References to strings and formulas: there is none, the new one is written right after reference,
+// or the reference is distance back to one written before plus 1
+const uint64_t NO_SNAPSHOT_ITEM = 0;
+const uint64_t NEW_SNAPSHOT_ITEM = 1;
+
+
+// Writes cells to output as they are added, remembering strings and formulas already written
+class SnapshotWriter
+{
+    OutputBuffer &output;
+    std::unordered_map<const char*, uint64_t> string_indices;
+    std::map<std::pair<const CompiledFormula*, Coordinate2D>, uint64_t> formula_indices;
+    uint64_t formula_count;
+    Coordinate2D previous_cell;
+
+    void writeUnsigned(uint64_t number);
+    // Zigzag encoding, so numbers of small magnitude are short
+    void writeSigned(int64_t number);
+    void writeText(const StringRef &text);
+    void writeToken(const Token &token);
+    // Reference to formula of given tokens, which are written if they are new
+    void writeFormula(const CompiledFormula *formula, const TokenRange &tokens, const Coordinate2D &anchor);
+    void writeExpression(const Expression &expression, const Coordinate2D &cell);
+public:
+    SnapshotWriter(OutputBuffer &output_tmp, int height, int width, size_t cell_count);
+
+    // Cells should be written in row-major order
+    void writeCell(const Coordinate2D &cell, const Expression &formula, const Expression &value);
+};
+
+
+SnapshotWriter::SnapshotWriter(OutputBuffer &output_tmp, int height, int width, size_t cell_count)
+    : output(output_tmp), formula_count(0), previous_cell(0, -1) {
+    output.append(StringRef(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC)));
+    writeUnsigned(SNAPSHOT_VERSION);
+    writeUnsigned(static_cast<uint64_t>(NUMBER_FRACTION_DIGITS));
+    writeUnsigned(static_cast<uint64_t>(height));
+    writeUnsigned(static_cast<uint64_t>(width));
+    writeUnsigned(cell_count);
+}
+
+
+void SnapshotWriter::writeUnsigned(uint64_t number) {
+    for (; number >= 0x80; number >>= 7) {
+        output.append(static_cast<char>(number | 0x80));
+    }
+    output.append(static_cast<char>(number));
+}
+
+
+void SnapshotWriter::writeSigned(int64_t number) {
+    writeUnsigned((static_cast<uint64_t>(number) << 1) ^ static_cast<uint64_t>(number >> 63));
+}
+
+
+void SnapshotWriter::writeText(const StringRef &text) {
+    if (text.empty()) {
+        writeUnsigned(NO_SNAPSHOT_ITEM);
+        return;
+    }
+    // Strings of expressions are interned, so equal strings have the same characters
+    auto inserted = string_indices.emplace(text.begin(), string_indices.size());
+    if (inserted.second) {
+        writeUnsigned(NEW_SNAPSHOT_ITEM);
+        writeUnsigned(text.getSize());
+        output.append(text);
+    } else {
+        writeUnsigned(string_indices.size() - inserted.first->second + 1);
+    }
+}
+
+
+void SnapshotWriter::writeToken(const Token &token) {
+    switch (token.type) {
+    case LexemType::NUMBER:
+        output.append(static_cast<char>(token.type));
+        writeSigned(token.number);
+        break;
+    case LexemType::CELL_REFERENCE:
+        output.append(static_cast<char>(token.type));
+        writeSigned(token.coordinate.row);
+        writeSigned(token.coordinate.column);
+        break;
+    case LexemType::OPERATION:
+        output.append(static_cast<char>(static_cast<int>(token.type) | static_cast<int>(token.operation) << 4));
+        break;
+    case LexemType::AGGREGATE: {
+        AggregateCall call = token.getAggregate();
+        output.append(static_cast<char>(static_cast<int>(token.type) | static_cast<int>(call.function) << 4));
+        writeSigned(call.range.first.row);
+        writeSigned(call.range.first.column);
+        writeSigned(call.range.last.row);
+        writeSigned(call.range.last.column);
+        break;
+    }
+    default:
+        throw std::invalid_argument("Token of text cannot be saved");
+    }
+}
+
+
+void SnapshotWriter::writeFormula(const CompiledFormula *formula, const TokenRange &tokens, const Coordinate2D &anchor) {
+    if (formula) {
+        auto inserted = formula_indices.emplace(std::make_pair(formula, anchor), formula_count);
+        if (!inserted.second) {
+            writeUnsigned(formula_count - inserted.first->second + 1);
+            return;
+        }
+    }
+    ++formula_count;
+    writeUnsigned(NEW_SNAPSHOT_ITEM);
+    writeUnsigned(static_cast<uint64_t>(tokens.end - tokens.begin));
+    writeSigned(anchor.row);
+    writeSigned(anchor.column);
+    for (const Token *token = tokens.begin; token != tokens.end; ++token) {
+        writeToken(*token);
+    }
+}
+
+
+void SnapshotWriter::writeExpression(const Expression &expression, const Coordinate2D &cell) {
+    SnapshotForm form = SnapshotForm::EMPTY;
+    if (expression.isNumber()) {
+        form = SnapshotForm::NUMBER;
+    } else if (expression.begin() != expression.end()) {
+        form = SnapshotForm::FORMULA;
+    }
+    output.append(static_cast<char>(static_cast<int>(expression.getType()) | static_cast<int>(form) << 4));
+    if (expression.getType() == ExpressionType::ERROR) {
+        output.append(static_cast<char>(expression.getError().code));
+    }
+    writeText(expression.getText());
+
+    if (form == SnapshotForm::NUMBER) {
+        writeSigned(expression.getNumber());
+    } else if (form == SnapshotForm::FORMULA && expression.getFormula()) {
+        const auto &anchor = expression.getAnchor();
+        writeFormula(
+            expression.getFormula(), {expression.getFormula()->begin(), expression.getFormula()->end()},
+            Coordinate2D(anchor.row - cell.row, anchor.column - cell.column)
+        );
+    } else if (form == SnapshotForm::FORMULA) {
+        // The only token is absolute, so it is anchored at the beginning of table
+        Token token = *expression.begin();
+        writeFormula(nullptr, {&token, &token + 1}, Coordinate2D(-cell.row, -cell.column));
+    }
+}
+
+
+void SnapshotWriter::writeCell(const Coordinate2D &cell, const Expression &formula, const Expression &value) {
+    writeUnsigned(static_cast<uint64_t>(cell.row - previous_cell.row));
+    writeUnsigned(static_cast<uint64_t>(cell.row == previous_cell.row ? cell.column - previous_cell.column - 1 : cell.column));
+    writeExpression(formula, cell);
+    writeExpression(value, cell);
+    previous_cell = cell;
+}
+
+
+void saveSnapshot(const ExpressionTable &formulas, const ExpressionTable &values, OutputBuffer &output) {
+    // Cells filled in any of tables, in row-major order
+    std::vector<Coordinate2D> coordinates;
+    for (const auto &cell_pair : formulas.getElements()) {
+        coordinates.push_back(cell_pair.first);
+    }
+    size_t formula_cell_count = coordinates.size();
+    for (const auto &cell_pair : values.getElements()) {
+        if (!formulas.tryGet(cell_pair.first)) {
+            coordinates.push_back(cell_pair.first);
+        }
+    }
+    if (coordinates.size() != formula_cell_count) {
+        std::sort(coordinates.begin(), coordinates.end());
+    }
+
+    SnapshotWriter writer(output, formulas.getHeight(), formulas.getWidth(), coordinates.size());
+    for (const auto &coordinate : coordinates) {
+        writer.writeCell(coordinate, formulas(coordinate), values(coordinate));
+    }
+}
+
+
+
+// Formula read from snapshot: several tokens are interned in FormulaPool, a single token is kept for expressions
+struct LoadedFormula
+{
+    const CompiledFormula *formula;
+    Token token;
+    bool has_token;
+    Coordinate2D anchor;
+};
+
+
+// Reads cells of snapshot in order, every read is checked against end of input
+class SnapshotReader
+{
+    const char *position;
+    const char *end;
+    // Strings refer to characters of input
+    std::vector<StringRef> strings;
+    std::vector<LoadedFormula> formulas;
+    std::vector<Token> tokens;
+    Coordinate2D previous_cell;
+
+    char readCharacter();
+    uint64_t readUnsigned();
+    int64_t readSigned();
+    StringRef readText();
+    Token readToken();
+    const LoadedFormula &readFormula();
+    Expression readExpression(const Coordinate2D &cell);
+public:
+    int height;
+    int width;
+    uint64_t cell_count;
+
+    // Reads header of snapshot
+    SnapshotReader(const char *begin_tmp, const char *end_tmp);
+
+    void readCell(ExpressionTable &formula_table, ExpressionTable &value_table);
+
+    bool isFinished() const {
+        return position == end;
+    }
+};
+
+
+void assertSnapshot(bool condition) {
+    if (!condition) {
+        throw std::runtime_error("Snapshot is damaged");
+    }
+}
+
+
+// Number read from snapshot, which should fit into int
+int toInt(int64_t number) {
+    assertSnapshot(number >= std::numeric_limits<int>::min() && number <= std::numeric_limits<int>::max());
+    return static_cast<int>(number);
+}
+
+
+SnapshotReader::SnapshotReader(const char *begin_tmp, const char *end_tmp)
+    : position(begin_tmp), end(end_tmp), previous_cell(0, -1) {
+    if (
+        static_cast<size_t>(end - position) < sizeof(SNAPSHOT_MAGIC)
+        || std::memcmp(position, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+    ) {
+        throw std::runtime_error("Input is not a snapshot of table");
+    }
+    position += sizeof(SNAPSHOT_MAGIC);
+    if (readUnsigned() != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Snapshot is made by other version of program");
+    }
+    if (readUnsigned() != static_cast<uint64_t>(NUMBER_FRACTION_DIGITS)) {
+        throw std::runtime_error("Snapshot is made by program with other kind of numbers");
+    }
+    uint64_t height_tmp = readUnsigned();
+    uint64_t width_tmp = readUnsigned();
+    assertSnapshot(height_tmp <= std::numeric_limits<int>::max() && width_tmp <= std::numeric_limits<int>::max());
+    height = static_cast<int>(height_tmp);
+    width = static_cast<int>(width_tmp);
+    cell_count = readUnsigned();
+}
+
+
+char SnapshotReader::readCharacter() {
+    if (position == end) {
+        throw std::runtime_error("Snapshot is truncated");
+    }
+    return *position++;
+}
+
+
+uint64_t SnapshotReader::readUnsigned() {
+    uint64_t number = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        auto byte = static_cast<unsigned char>(readCharacter());
+        number |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return number;
+        }
+    }
+    assertSnapshot(false);
+    return 0;
+}
+
+
+int64_t SnapshotReader::readSigned() {
+    uint64_t number = readUnsigned();
+    return static_cast<int64_t>(number >> 1) ^ -static_cast<int64_t>(number & 1);
+}
+
+
+StringRef SnapshotReader::readText() {
+    uint64_t reference = readUnsigned();
+    if (reference == NO_SNAPSHOT_ITEM) {
+        return {};
+    } else if (reference != NEW_SNAPSHOT_ITEM) {
+        assertSnapshot(reference - 1 <= strings.size());
+        return strings[strings.size() - (reference - 1)];
+    }
+    uint64_t size = readUnsigned();
+    assertSnapshot(size <= static_cast<uint64_t>(end - position));
+    strings.emplace_back(position, position + size);
+    position += size;
+    return strings.back();
+}
+
+
+Token SnapshotReader::readToken() {
+    int tag = static_cast<unsigned char>(readCharacter());
+    int argument = tag >> 4;
+    switch (static_cast<LexemType>(tag & 0xf)) {
+    case LexemType::NUMBER:
+        return Token(readSigned());
+    case LexemType::CELL_REFERENCE: {
+        int row = toInt(readSigned());
+        return Token(Coordinate2D(row, toInt(readSigned())));
+    }
+    case LexemType::OPERATION:
+        assertSnapshot(argument <= static_cast<int>(Operation::DIVIDE));
+        return Token(static_cast<Operation>(argument));
+    case LexemType::AGGREGATE: {
+        assertSnapshot(argument <= static_cast<int>(Aggregate::AVERAGE));
+        int corners[4];
+        for (auto &corner : corners) {
+            corner = toInt(readSigned());
+        }
+        return Token(AggregateCall(
+            static_cast<Aggregate>(argument),
+            CellRange(Coordinate2D(corners[0], corners[1]), Coordinate2D(corners[2], corners[3]))
+        ));
+    }
+    default:
+        assertSnapshot(false);
+        return Token();
+    }
+}
+
+
+const LoadedFormula &SnapshotReader::readFormula() {
+    uint64_t reference = readUnsigned();
+    assertSnapshot(reference != NO_SNAPSHOT_ITEM);
+    if (reference != NEW_SNAPSHOT_ITEM) {
+        assertSnapshot(reference - 1 <= formulas.size());
+        return formulas[formulas.size() - (reference - 1)];
+    }
+
+    uint64_t token_count = readUnsigned();
+    // Every token takes at least one character
+    assertSnapshot(token_count <= static_cast<uint64_t>(end - position));
+    int anchor_row = toInt(readSigned());
+    Coordinate2D anchor(anchor_row, toInt(readSigned()));
+    tokens.clear();
+    for (uint64_t token_index = 0; token_index < token_count; ++token_index) {
+        tokens.push_back(readToken());
+    }
+
+    LoadedFormula formula{nullptr, Token(), !tokens.empty(), anchor};
+    if (tokens.size() > 1) {
+        formula.formula = FormulaPool::getCurrent().intern(tokens);
+    } else if (formula.has_token) {
+        formula.token = tokens[0];
+    }
+    formulas.push_back(formula);
+    return formulas.back();
+}
+
+
+Expression SnapshotReader::readExpression(const Coordinate2D &cell) {
+    int tag = static_cast<unsigned char>(readCharacter());
+    assertSnapshot((tag & 0xf) <= static_cast<int>(ExpressionType::ERROR));
+    Expression expression(static_cast<ExpressionType>(tag & 0xf));
+    int error_code = (expression.getType() == ExpressionType::ERROR ? static_cast<unsigned char>(readCharacter()) : 0);
+    assertSnapshot(error_code <= static_cast<int>(ErrorCode::OTHER));
+
+    StringRef text = readText();
+    if (expression.getType() == ExpressionType::ERROR) {
+        expression.setError(Error(static_cast<ErrorCode>(error_code), text));
+    } else if (!text.empty()) {
+        expression.setText(text);
+    }
+
+    switch (static_cast<SnapshotForm>(tag >> 4)) {
+    case SnapshotForm::EMPTY:
+        break;
+    case SnapshotForm::NUMBER:
+        expression.pushToken(Token(readSigned()));
+        break;
+    case SnapshotForm::FORMULA: {
+        const auto &formula = readFormula();
+        Coordinate2D anchor(cell.row + formula.anchor.row, cell.column + formula.anchor.column);
+        if (formula.formula) {
+            expression.setFormula(formula.formula, anchor);
+        } else if (formula.has_token) {
+            Token token = formula.token;
+            if (token.type == LexemType::CELL_REFERENCE) {
+                token.coordinate.row += anchor.row;
+                token.coordinate.column += anchor.column;
+            }
+            expression.pushToken(token);
+        }
+        break;
+    }
+    default:
+        assertSnapshot(false);
+    }
+    return expression;
+}
+
+
+void SnapshotReader::readCell(ExpressionTable &formula_table, ExpressionTable &value_table) {
+    uint64_t row_delta = readUnsigned();
+    uint64_t column_delta = readUnsigned();
+    // Cells are in row-major order, so moving by deltas never goes back
+    uint64_t row = static_cast<uint64_t>(previous_cell.row) + row_delta;
+    uint64_t column = column_delta + (row_delta == 0 ? static_cast<uint64_t>(previous_cell.column) + 1 : 0);
+    assertSnapshot(
+        row_delta < static_cast<uint64_t>(height) && column_delta < static_cast<uint64_t>(width)
+        && row < static_cast<uint64_t>(height) && column < static_cast<uint64_t>(width)
+    );
+    Coordinate2D cell(static_cast<int>(row), static_cast<int>(column));
+
+    formula_table(cell) = readExpression(cell);
+    value_table(cell) = readExpression(cell);
+    previous_cell = cell;
+}
+
+
+TableSnapshot loadSnapshot(const InputBuffer &input) {
+    StatsStageTimer timer(StatsStage::PARSE);
+    SnapshotReader reader(input.begin(), input.end());
+    addStatsCounter(StatsCounter::CELLS, reader.cell_count);
+
+    // Both tables hold new pools, which cells are interned into
+    auto pools = std::make_shared<CellPools>();
+    CellPoolsScope scope(pools);
+    TableSnapshot snapshot{ExpressionTable(reader.height, reader.width), ExpressionTable(reader.height, reader.width)};
+    // Count is read from file, so it only chooses layout of tables
+    int cell_count = static_cast<int>(std::min<uint64_t>(reader.cell_count, std::numeric_limits<int>::max()));
+    snapshot.formulas.reserve(cell_count);
+    snapshot.values.reserve(cell_count);
+    for (uint64_t cell_index = 0; cell_index < reader.cell_count; ++cell_index) {
+        reader.readCell(snapshot.formulas, snapshot.values);
+    }
+    assertSnapshot(reader.isFinished());
+    return snapshot;
+}
@@ -0,0 +1,27 @@
+#ifndef SNAPSHOT_H_INCLUDED
+#define SNAPSHOT_H_INCLUDED
+
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+
+
+// Formulas of evaluated table and their calculated values
+struct TableSnapshot
+{
+    ExpressionTable formulas;
+    ExpressionTable values;
+};
+
+
+// Writes binary snapshot: table of distinct strings, table of distinct compiled formulas and
+// fixed-size records of cells referring to them. Numbers are in native byte order,
+// as snapshot is a cache of evaluation for the same machine rather than exchange format
+void saveSnapshot(const ExpressionTable &formulas, const ExpressionTable &values, OutputBuffer &output);
+
+// Restores tables without parsing and calculation; every distinct string and formula is interned once.
+// Throws std::runtime_error if input is not a snapshot of this version or is damaged
+TableSnapshot loadSnapshot(const InputBuffer &input);
+
+
+#endif // SNAPSHOT_H_INCLUDED
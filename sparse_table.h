@@ -1,25 +1,26 @@
 #ifndef SPARSE_TABLE_H_INCLUDED
 #define SPARSE_TABLE_H_INCLUDED
 
-#include <map>
 #include <iterator>
 #include <iostream>
 #include <string>
 
 #include "utils.h"
 #include "coordinate.h"
+#include "sparse_table_storage.h"
 
 
-template <typename ValueType>
+// Storage is one of policies from sparse_table_storage.h
+template <typename ValueType, typename Storage = MapStorage<ValueType>>
 class SparseTable
 {
     int height;
     int width;
-    std::map<Coordinate2D, ValueType> table_values;
+    Storage table_values;
 
     static const ValueType EMPTY_CELL;
 
-    using CellIterator = typename std::map<Coordinate2D, ValueType>::const_iterator;
+    using CellIterator = typename Storage::CellIterator;
 
     void assertCoordinateInRange(const Coordinate2D &coordinate) const;
 
@@ -29,9 +30,12 @@ class SparseTable
         // column of next_iterator should be >= column
         CellIterator next_iterator;
         CellIterator end_iterator;
+        // coordinate of next_iterator cell, cached to avoid dereferencing on every step
+        Coordinate2D next_coordinate;
         int row;
         int column;
 
+        void updateNextCoordinate();
         bool isIteratorStrictlyHere() const;
     public:
         FlattenCellIterator(
@@ -89,12 +93,14 @@ public:
 
     int getHeight() const;
     int getWidth() const;
+    bool isInRange(const Coordinate2D &coordinate) const;
 
     bool operator==(const SparseTable &other) const;
 
     struct Entry
     {
         using value_type = ValueType;
+        using table_type = SparseTable;
 
         Coordinate2D coordinate;
         ValueType value;
@@ -102,15 +108,31 @@ public:
         Entry(const Coordinate2D &coordinate_tmp, const ValueType &value_tmp);
     };
 
-    // Access to cell with coordinates constructed with given arguments
+    // Access to cell with coordinates constructed with given arguments, empty cell is inserted
     template <typename... CoordinateArgs>
     ValueType &operator()(CoordinateArgs&&... coordinate_args);
 
+    // Read-only access, empty cell is not inserted and EMPTY_CELL is returned instead
     template <typename... CoordinateArgs>
     const ValueType &operator()(CoordinateArgs&&... coordinate_args) const;
 
+    // Pointer to filled cell or nullptr for empty one, never inserts
+    template <typename... CoordinateArgs>
+    const ValueType *tryGet(CoordinateArgs&&... coordinate_args) const;
+
+    // Modifiable filled cell or nullptr; does not change table structure, so it is safe
+    // to call concurrently for different cells
+    template <typename... CoordinateArgs>
+    ValueType *tryGet(CoordinateArgs&&... coordinate_args);
+
+    template <typename... CoordinateArgs>
+    bool contains(CoordinateArgs&&... coordinate_args) const;
+
     int getElementCount() const;
 
+    // Tells storage how many cells empty table will have, e.g. so AdaptiveStorage may choose its layout
+    void reserve(int element_count);
+
     IteratorRange<CellIterator> getElements() const;
 
     // Allows to iterate over all cells including empty ones
@@ -118,15 +140,16 @@ public:
 };
 
 
-template <typename ValueType>
-typename SparseTable<ValueType>::FlattenRowIterator operator+(
+template <typename ValueType, typename Storage>
+typename SparseTable<ValueType, Storage>::FlattenRowIterator operator+(
     int delta,
-    const typename SparseTable<ValueType>::FlattenRowIterator &iterator
+    const typename SparseTable<ValueType, Storage>::FlattenRowIterator &iterator
 );
 
 
+// Table of the same type as entries belong to
 template <typename InputIterator>
-SparseTable<typename std::iterator_traits<InputIterator>::value_type::value_type>
+typename std::iterator_traits<InputIterator>::value_type::table_type
 makeSparseTable(int height, int width, InputIterator first, InputIterator last);
 
 
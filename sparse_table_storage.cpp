@@ -0,0 +1,529 @@
+#include <map>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#include "coordinate.h"
+#include "flat_hash_map.h"
+#include "flat_hash_map.cpp"
+#include "sparse_table_storage.h"
+
+
+// Links and color of node of std::map and header of its allocation
+const int64_t TREE_NODE_OVERHEAD = 48;
+
+
+template <typename ValueType>
+int64_t MapStorage<ValueType>::estimateMemorySize(int element_count) {
+    return static_cast<int64_t>(element_count) * (TREE_NODE_OVERHEAD + static_cast<int64_t>(sizeof(typename std::map<Coordinate2D, ValueType>::value_type)));
+}
+
+
+template <typename ValueType>
+void MapStorage<ValueType>::reserve(int, int, int) {}
+
+template <typename ValueType>
+ValueType &MapStorage<ValueType>::access(const Coordinate2D &coordinate) {
+    return values[coordinate];
+}
+
+template <typename ValueType>
+const ValueType *MapStorage<ValueType>::find(const Coordinate2D &coordinate) const {
+    auto iterator = values.find(coordinate);
+    return (iterator == values.end() ? nullptr : &iterator->second);
+}
+
+template <typename ValueType>
+ValueType *MapStorage<ValueType>::find(const Coordinate2D &coordinate) {
+    return const_cast<ValueType*>(static_cast<const MapStorage*>(this)->find(coordinate));
+}
+
+template <typename ValueType>
+int MapStorage<ValueType>::getElementCount() const {
+    return static_cast<int>(values.size());
+}
+
+template <typename ValueType>
+typename MapStorage<ValueType>::CellIterator MapStorage<ValueType>::begin() const {
+    return values.cbegin();
+}
+
+template <typename ValueType>
+typename MapStorage<ValueType>::CellIterator MapStorage<ValueType>::end() const {
+    return values.cend();
+}
+
+template <typename ValueType>
+typename MapStorage<ValueType>::CellIterator MapStorage<ValueType>::lowerBound(const Coordinate2D &coordinate) const {
+    return values.lower_bound(coordinate);
+}
+
+template <typename ValueType>
+bool MapStorage<ValueType>::operator==(const MapStorage &other) const {
+    return values == other.values;
+}
+
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::Chunk::Chunk() : occupancy(), values() {}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+int64_t ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::estimateMemorySize(int height, int width) {
+    int64_t chunk_count =
+        (static_cast<int64_t>(height) + CHUNK_HEIGHT - 1) / CHUNK_HEIGHT * ((static_cast<int64_t>(width) + CHUNK_WIDTH - 1) / CHUNK_WIDTH);
+    return chunk_count * (
+        static_cast<int64_t>(sizeof(Chunk)) + TREE_NODE_OVERHEAD + static_cast<int64_t>(sizeof(typename ChunkMap::value_type))
+    );
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+Coordinate2D ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::getChunkCoordinate(const Coordinate2D &coordinate) {
+    return {coordinate.row / CHUNK_HEIGHT, coordinate.column / CHUNK_WIDTH};
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+typename ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::ChunkIterator
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::findGroupEnd() const {
+    if (group_begin == chunks->cend()) {
+        return group_begin;
+    }
+    return chunks->lower_bound({group_begin->first.row + 1, 0});
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+void ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::settle() {
+    while (group_begin != chunks->cend()) {
+        for (; row_in_chunk < CHUNK_HEIGHT; ++row_in_chunk, chunk = group_begin, column_in_chunk = 0) {
+            for (; chunk != group_end; ++chunk, column_in_chunk = 0) {
+                if (column_in_chunk >= CHUNK_WIDTH) {
+                    continue;
+                }
+                uint64_t row_occupancy = chunk->second->occupancy[static_cast<size_t>(row_in_chunk)] & (~uint64_t(0) << column_in_chunk);
+                if (row_occupancy != 0) {
+                    column_in_chunk = __builtin_ctzll(row_occupancy);
+                    return;
+                }
+            }
+        }
+        group_begin = group_end;
+        group_end = findGroupEnd();
+        chunk = group_begin;
+        row_in_chunk = 0;
+        column_in_chunk = 0;
+    }
+    chunk = chunks->cend();
+    row_in_chunk = 0;
+    column_in_chunk = 0;
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::CellIterator(
+    const ChunkMap *chunks_tmp, ChunkIterator group_begin_tmp
+) : CellIterator(chunks_tmp, group_begin_tmp, group_begin_tmp, 0, 0) {}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::CellIterator(
+    const ChunkMap *chunks_tmp, ChunkIterator group_begin_tmp, ChunkIterator chunk_tmp,
+    int row_in_chunk_tmp, int column_in_chunk_tmp
+) : chunks(chunks_tmp), group_begin(group_begin_tmp), group_end(), chunk(chunk_tmp),
+    row_in_chunk(row_in_chunk_tmp), column_in_chunk(column_in_chunk_tmp)
+{
+    group_end = findGroupEnd();
+    settle();
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+typename ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::Cell
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::operator*() const {
+    const auto &chunk_coordinate = chunk->first;
+    return {
+        {chunk_coordinate.row * CHUNK_HEIGHT + row_in_chunk, chunk_coordinate.column * CHUNK_WIDTH + column_in_chunk},
+        chunk->second->values[static_cast<size_t>(row_in_chunk * CHUNK_WIDTH + column_in_chunk)]
+    };
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+typename ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator &
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::operator++() {
+    ++column_in_chunk;
+    settle();
+    return *this;
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+typename ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::operator++(int) {
+    auto iterator_copy = *this;
+    ++*this;
+    return iterator_copy;
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+bool ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::operator==(const CellIterator &other) const {
+    return chunk == other.chunk && row_in_chunk == other.row_in_chunk && column_in_chunk == other.column_in_chunk;
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+bool ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator::operator!=(const CellIterator &other) const {
+    return !operator==(other);
+}
+
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::ChunkedStorage() : element_count(0) {}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::ChunkedStorage(const ChunkedStorage &other)
+    : element_count(other.element_count)
+{
+    for (const auto &chunk_pair : other.chunks) {
+        chunks.emplace_hint(chunks.end(), chunk_pair.first, std::make_unique<Chunk>(*chunk_pair.second));
+    }
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH> &
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::operator=(const ChunkedStorage &other) {
+    if (this != &other) {
+        *this = ChunkedStorage(other);
+    }
+    return *this;
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+void ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::reserve(int, int, int) {}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ValueType &ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::access(const Coordinate2D &coordinate) {
+    auto &chunk_pointer = chunks[getChunkCoordinate(coordinate)];
+    if (!chunk_pointer) {
+        chunk_pointer = std::make_unique<Chunk>();
+    }
+
+    int row_in_chunk = coordinate.row % CHUNK_HEIGHT;
+    int column_in_chunk = coordinate.column % CHUNK_WIDTH;
+    uint64_t cell_bit = uint64_t(1) << column_in_chunk;
+    if ((chunk_pointer->occupancy[static_cast<size_t>(row_in_chunk)] & cell_bit) == 0) {
+        chunk_pointer->occupancy[static_cast<size_t>(row_in_chunk)] |= cell_bit;
+        ++element_count;
+    }
+    return chunk_pointer->values[static_cast<size_t>(row_in_chunk * CHUNK_WIDTH + column_in_chunk)];
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+const ValueType *ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::find(const Coordinate2D &coordinate) const {
+    auto chunk_iterator = chunks.find(getChunkCoordinate(coordinate));
+    if (chunk_iterator == chunks.end()) {
+        return nullptr;
+    }
+
+    const auto &chunk = *chunk_iterator->second;
+    int row_in_chunk = coordinate.row % CHUNK_HEIGHT;
+    int column_in_chunk = coordinate.column % CHUNK_WIDTH;
+    if ((chunk.occupancy[static_cast<size_t>(row_in_chunk)] & (uint64_t(1) << column_in_chunk)) == 0) {
+        return nullptr;
+    }
+    return &chunk.values[static_cast<size_t>(row_in_chunk * CHUNK_WIDTH + column_in_chunk)];
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+ValueType *ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::find(const Coordinate2D &coordinate) {
+    return const_cast<ValueType*>(static_cast<const ChunkedStorage*>(this)->find(coordinate));
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+int ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::getElementCount() const {
+    return element_count;
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+typename ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::begin() const {
+    return {&chunks, chunks.cbegin()};
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+typename ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::end() const {
+    return {&chunks, chunks.cend()};
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+typename ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::CellIterator
+ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::lowerBound(const Coordinate2D &coordinate) const {
+    auto chunk_coordinate = getChunkCoordinate(coordinate);
+    auto group_begin = chunks.lower_bound({chunk_coordinate.row, 0});
+    if (group_begin == chunks.cend() || group_begin->first.row != chunk_coordinate.row) {
+        return {&chunks, group_begin};
+    }
+
+    auto chunk = chunks.lower_bound(chunk_coordinate);
+    int column_in_chunk = (chunk != chunks.cend() && chunk->first == chunk_coordinate ? coordinate.column % CHUNK_WIDTH : 0);
+    return {&chunks, group_begin, chunk, coordinate.row % CHUNK_HEIGHT, column_in_chunk};
+}
+
+template <typename ValueType, int CHUNK_HEIGHT, int CHUNK_WIDTH>
+bool ChunkedStorage<ValueType, CHUNK_HEIGHT, CHUNK_WIDTH>::operator==(const ChunkedStorage &other) const {
+    if (element_count != other.element_count) {
+        return false;
+    }
+
+    auto other_iterator = other.begin();
+    for (const auto &cell : *this) {
+        const auto &other_cell = *other_iterator;
+        if (!(cell.first == other_cell.first) || !(cell.second == other_cell.second)) {
+            return false;
+        }
+        ++other_iterator;
+    }
+    return true;
+}
+
+
+template <typename ValueType>
+HashStorage<ValueType>::CellIterator::CellIterator(SortedIterator position_tmp) : position(position_tmp) {}
+
+template <typename ValueType>
+const typename HashStorage<ValueType>::Entry &HashStorage<ValueType>::CellIterator::operator*() const {
+    return **position;
+}
+
+template <typename ValueType>
+const typename HashStorage<ValueType>::Entry *HashStorage<ValueType>::CellIterator::operator->() const {
+    return *position;
+}
+
+template <typename ValueType>
+typename HashStorage<ValueType>::CellIterator &HashStorage<ValueType>::CellIterator::operator++() {
+    ++position;
+    return *this;
+}
+
+template <typename ValueType>
+typename HashStorage<ValueType>::CellIterator HashStorage<ValueType>::CellIterator::operator++(int) {
+    auto iterator_copy = *this;
+    ++*this;
+    return iterator_copy;
+}
+
+template <typename ValueType>
+bool HashStorage<ValueType>::CellIterator::operator==(const CellIterator &other) const {
+    return position == other.position;
+}
+
+template <typename ValueType>
+bool HashStorage<ValueType>::CellIterator::operator!=(const CellIterator &other) const {
+    return !operator==(other);
+}
+
+
+template <typename ValueType>
+HashStorage<ValueType>::HashStorage() : is_sorted(false) {}
+
+template <typename ValueType>
+HashStorage<ValueType>::HashStorage(const HashStorage &other) : values(other.values), is_sorted(false) {}
+
+template <typename ValueType>
+HashStorage<ValueType> &HashStorage<ValueType>::operator=(const HashStorage &other) {
+    if (this != &other) {
+        values = other.values;
+        sorted_entries.clear();
+        is_sorted = false;
+    }
+    return *this;
+}
+
+template <typename ValueType>
+void HashStorage<ValueType>::sortEntries() const {
+    if (is_sorted) {
+        return;
+    }
+    sorted_entries.clear();
+    for (const auto &entry : values) {
+        sorted_entries.push_back(&entry);
+    }
+    std::sort(sorted_entries.begin(), sorted_entries.end(), [](const Entry *first, const Entry *second) {
+        return first->first < second->first;
+    });
+    is_sorted = true;
+}
+
+template <typename ValueType>
+void HashStorage<ValueType>::reserve(int, int, int element_count) {
+    values.reserve(static_cast<size_t>(element_count));
+}
+
+template <typename ValueType>
+ValueType &HashStorage<ValueType>::access(const Coordinate2D &coordinate) {
+    size_t element_count = values.size();
+    auto &value = values[coordinate];
+    // Insertion may move entries, existing cells are accessed without it
+    if (values.size() != element_count) {
+        is_sorted = false;
+    }
+    return value;
+}
+
+template <typename ValueType>
+const ValueType *HashStorage<ValueType>::find(const Coordinate2D &coordinate) const {
+    return values.find(coordinate);
+}
+
+template <typename ValueType>
+ValueType *HashStorage<ValueType>::find(const Coordinate2D &coordinate) {
+    return values.find(coordinate);
+}
+
+template <typename ValueType>
+int HashStorage<ValueType>::getElementCount() const {
+    return static_cast<int>(values.size());
+}
+
+template <typename ValueType>
+typename HashStorage<ValueType>::CellIterator HashStorage<ValueType>::begin() const {
+    sortEntries();
+    return CellIterator(sorted_entries.cbegin());
+}
+
+template <typename ValueType>
+typename HashStorage<ValueType>::CellIterator HashStorage<ValueType>::end() const {
+    sortEntries();
+    return CellIterator(sorted_entries.cend());
+}
+
+template <typename ValueType>
+typename HashStorage<ValueType>::CellIterator HashStorage<ValueType>::lowerBound(const Coordinate2D &coordinate) const {
+    sortEntries();
+    return CellIterator(std::lower_bound(
+        sorted_entries.cbegin(), sorted_entries.cend(), coordinate,
+        [](const Entry *entry, const Coordinate2D &key) {
+            return entry->first < key;
+        }
+    ));
+}
+
+template <typename ValueType>
+bool HashStorage<ValueType>::operator==(const HashStorage &other) const {
+    if (values.size() != other.values.size()) {
+        return false;
+    }
+    for (const auto &entry : values) {
+        const auto *other_value = other.values.find(entry.first);
+        if (!other_value || !(entry.second == *other_value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template <typename ValueType>
+AdaptiveStorage<ValueType>::CellIterator::CellIterator(
+    bool is_chunked_tmp, MapCellIterator map_iterator_tmp, ChunkedCellIterator chunked_iterator_tmp
+) : is_chunked(is_chunked_tmp), map_iterator(map_iterator_tmp), chunked_iterator(chunked_iterator_tmp) {}
+
+template <typename ValueType>
+typename AdaptiveStorage<ValueType>::Cell AdaptiveStorage<ValueType>::CellIterator::operator*() const {
+    if (is_chunked) {
+        return *chunked_iterator;
+    }
+    return {map_iterator->first, map_iterator->second};
+}
+
+template <typename ValueType>
+typename AdaptiveStorage<ValueType>::CellIterator &AdaptiveStorage<ValueType>::CellIterator::operator++() {
+    if (is_chunked) {
+        ++chunked_iterator;
+    } else {
+        ++map_iterator;
+    }
+    return *this;
+}
+
+template <typename ValueType>
+typename AdaptiveStorage<ValueType>::CellIterator AdaptiveStorage<ValueType>::CellIterator::operator++(int) {
+    auto iterator_copy = *this;
+    ++*this;
+    return iterator_copy;
+}
+
+template <typename ValueType>
+bool AdaptiveStorage<ValueType>::CellIterator::operator==(const CellIterator &other) const {
+    return (is_chunked ? chunked_iterator == other.chunked_iterator : map_iterator == other.map_iterator);
+}
+
+template <typename ValueType>
+bool AdaptiveStorage<ValueType>::CellIterator::operator!=(const CellIterator &other) const {
+    return !operator==(other);
+}
+
+
+template <typename ValueType>
+AdaptiveStorage<ValueType>::AdaptiveStorage() : is_chunked(false) {}
+
+template <typename ValueType>
+void AdaptiveStorage<ValueType>::reserve(int height, int width, int element_count) {
+    if (getElementCount() == 0) {
+        is_chunked = (ChunkedStorage<ValueType>::estimateMemorySize(height, width) < MapStorage<ValueType>::estimateMemorySize(element_count));
+    }
+}
+
+template <typename ValueType>
+ValueType &AdaptiveStorage<ValueType>::access(const Coordinate2D &coordinate) {
+    return (is_chunked ? chunked_values.access(coordinate) : map_values.access(coordinate));
+}
+
+template <typename ValueType>
+const ValueType *AdaptiveStorage<ValueType>::find(const Coordinate2D &coordinate) const {
+    return (is_chunked ? chunked_values.find(coordinate) : map_values.find(coordinate));
+}
+
+template <typename ValueType>
+ValueType *AdaptiveStorage<ValueType>::find(const Coordinate2D &coordinate) {
+    return (is_chunked ? chunked_values.find(coordinate) : map_values.find(coordinate));
+}
+
+template <typename ValueType>
+int AdaptiveStorage<ValueType>::getElementCount() const {
+    return (is_chunked ? chunked_values.getElementCount() : map_values.getElementCount());
+}
+
+template <typename ValueType>
+typename AdaptiveStorage<ValueType>::CellIterator AdaptiveStorage<ValueType>::begin() const {
+    return CellIterator(is_chunked, map_values.begin(), chunked_values.begin());
+}
+
+template <typename ValueType>
+typename AdaptiveStorage<ValueType>::CellIterator AdaptiveStorage<ValueType>::end() const {
+    return CellIterator(is_chunked, map_values.end(), chunked_values.end());
+}
+
+template <typename ValueType>
+typename AdaptiveStorage<ValueType>::CellIterator AdaptiveStorage<ValueType>::lowerBound(const Coordinate2D &coordinate) const {
+    if (is_chunked) {
+        return CellIterator(true, map_values.end(), chunked_values.lowerBound(coordinate));
+    }
+    return CellIterator(false, map_values.lowerBound(coordinate), chunked_values.end());
+}
+
+template <typename ValueType>
+bool AdaptiveStorage<ValueType>::operator==(const AdaptiveStorage &other) const {
+    if (is_chunked == other.is_chunked) {
+        return (is_chunked ? chunked_values == other.chunked_values : map_values == other.map_values);
+    }
+    // Both layouts are iterated in row-major order
+    return getElementCount() == other.getElementCount() && std::equal(
+        begin(), end(), other.begin(), [](const Cell &first, const Cell &second) {
+            return first.first == second.first && first.second == second.second;
+        }
+    );
+}
+
+template <typename ValueType>
+bool AdaptiveStorage<ValueType>::isChunked() const {
+    return is_chunked;
+}
@@ -0,0 +1,224 @@
+#ifndef SPARSE_TABLE_STORAGE_H_INCLUDED
+#define SPARSE_TABLE_STORAGE_H_INCLUDED
+
+#include <map>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "coordinate.h"
+#include "flat_hash_map.h"
+
+
+// Storage policies of SparseTable.
+//
+// Every policy keeps only filled cells and provides:
+//   ValueType &access(const Coordinate2D &)          -- cell, inserted if absent
+//   const ValueType *find(const Coordinate2D &) const -- filled cell or nullptr, never allocates
+//   ValueType *find(const Coordinate2D &)             -- the same for modification, never changes structure
+//   int getElementCount() const
+//   CellIterator begin() const, end() const            -- filled cells in row-major order
+//   CellIterator lowerBound(const Coordinate2D &) const -- first filled cell not less than given
+//   bool operator==(const Storage &) const
+//   void reserve(int height, int width, int element_count) -- number of cells of empty storage, may be ignored
+// Dereferenced CellIterator is a pair-like object with coordinate as `first` and value as `second`.
+
+
+// Every cell is a node of std::map
+template <typename ValueType>
+class MapStorage
+{
+    std::map<Coordinate2D, ValueType> values;
+public:
+    using CellIterator = typename std::map<Coordinate2D, ValueType>::const_iterator;
+
+    // Approximate number of bytes taken by given number of cells
+    static int64_t estimateMemorySize(int element_count);
+
+    void reserve(int height, int width, int element_count);
+    ValueType &access(const Coordinate2D &coordinate);
+    const ValueType *find(const Coordinate2D &coordinate) const;
+    ValueType *find(const Coordinate2D &coordinate);
+    int getElementCount() const;
+    CellIterator begin() const;
+    CellIterator end() const;
+    CellIterator lowerBound(const Coordinate2D &coordinate) const;
+    bool operator==(const MapStorage &other) const;
+};
+
+
+// Cells are stored in dense CHUNK_HEIGHT x CHUNK_WIDTH blocks, keyed by block coordinate.
+// Every block row has an occupancy bitmap, so empty cells of a block are skipped on iteration.
+template <typename ValueType, int CHUNK_HEIGHT = 16, int CHUNK_WIDTH = 32>
+class ChunkedStorage
+{
+    static_assert(CHUNK_HEIGHT > 0, "Chunk height should be positive");
+    static_assert(CHUNK_WIDTH > 0 && CHUNK_WIDTH <= 64, "Chunk row should fit into 64-bit occupancy bitmap");
+
+    struct Chunk
+    {
+        std::array<uint64_t, static_cast<size_t>(CHUNK_HEIGHT)> occupancy;
+        std::array<ValueType, static_cast<size_t>(CHUNK_HEIGHT * CHUNK_WIDTH)> values;
+
+        Chunk();
+    };
+
+    using ChunkMap = std::map<Coordinate2D, std::unique_ptr<Chunk>>;
+    using ChunkIterator = typename ChunkMap::const_iterator;
+
+    ChunkMap chunks;
+    int element_count;
+
+    static Coordinate2D getChunkCoordinate(const Coordinate2D &coordinate);
+
+public:
+    using Cell = std::pair<Coordinate2D, const ValueType &>;
+
+    // Walks chunks of one block row row by row, so cells are visited in row-major order
+    class CellIterator : public std::iterator<std::forward_iterator_tag, Cell, int, void, Cell>
+    {
+        const ChunkMap *chunks;
+        ChunkIterator group_begin;
+        ChunkIterator group_end;
+        ChunkIterator chunk;
+        int row_in_chunk;
+        int column_in_chunk;
+
+        ChunkIterator findGroupEnd() const;
+
+        // Moves to the first filled cell not before current position
+        void settle();
+    public:
+        CellIterator(const ChunkMap *chunks_tmp, ChunkIterator group_begin_tmp);
+        CellIterator(
+            const ChunkMap *chunks_tmp, ChunkIterator group_begin_tmp, ChunkIterator chunk_tmp,
+            int row_in_chunk_tmp, int column_in_chunk_tmp
+        );
+        Cell operator*() const;
+        CellIterator &operator++();
+        CellIterator operator++(int);
+        bool operator==(const CellIterator &other) const;
+        bool operator!=(const CellIterator &other) const;
+    };
+
+    ChunkedStorage();
+    ChunkedStorage(const ChunkedStorage &other);
+    ChunkedStorage(ChunkedStorage &&other) = default;
+    ChunkedStorage &operator=(const ChunkedStorage &other);
+    ChunkedStorage &operator=(ChunkedStorage &&other) = default;
+
+    // Approximate number of bytes taken by chunks covering table of given size,
+    // chunks on its borders are whole even if table ends inside of them
+    static int64_t estimateMemorySize(int height, int width);
+
+    void reserve(int height, int width, int element_count);
+    ValueType &access(const Coordinate2D &coordinate);
+    const ValueType *find(const Coordinate2D &coordinate) const;
+    ValueType *find(const Coordinate2D &coordinate);
+    int getElementCount() const;
+    CellIterator begin() const;
+    CellIterator end() const;
+    CellIterator lowerBound(const Coordinate2D &coordinate) const;
+    bool operator==(const ChunkedStorage &other) const;
+};
+
+
+// Cells are entries of FlatHashMap, so access to cell does not depend on number of cells.
+// Row-major order needed for iteration is sorted on the first iteration after insertion and
+// cached, so iteration should not run concurrently with other iteration or insertion
+template <typename ValueType>
+class HashStorage
+{
+    using Entry = typename FlatHashMap<ValueType>::Entry;
+    using SortedIterator = typename std::vector<const Entry*>::const_iterator;
+
+    FlatHashMap<ValueType> values;
+    mutable std::vector<const Entry*> sorted_entries;
+    mutable bool is_sorted;
+
+    void sortEntries() const;
+public:
+    class CellIterator : public std::iterator<std::forward_iterator_tag, Entry, int, const Entry*, const Entry&>
+    {
+        SortedIterator position;
+    public:
+        explicit CellIterator(SortedIterator position_tmp);
+        const Entry &operator*() const;
+        const Entry *operator->() const;
+        CellIterator &operator++();
+        CellIterator operator++(int);
+        bool operator==(const CellIterator &other) const;
+        bool operator!=(const CellIterator &other) const;
+    };
+
+    HashStorage();
+    // Cached order points to entries of copied map, so it is not copied
+    HashStorage(const HashStorage &other);
+    HashStorage(HashStorage &&other) = default;
+    HashStorage &operator=(const HashStorage &other);
+    HashStorage &operator=(HashStorage &&other) = default;
+
+    void reserve(int height, int width, int element_count);
+    ValueType &access(const Coordinate2D &coordinate);
+    const ValueType *find(const Coordinate2D &coordinate) const;
+    ValueType *find(const Coordinate2D &coordinate);
+    int getElementCount() const;
+    CellIterator begin() const;
+    CellIterator end() const;
+    CellIterator lowerBound(const Coordinate2D &coordinate) const;
+    bool operator==(const HashStorage &other) const;
+};
+
+
+// Cells are kept in MapStorage, unless reserve() is told that they fill enough of chunks covering table
+// for ChunkedStorage to take less memory, e.g. narrow tables leave most of their chunks empty.
+// Copies keep layout of copied storage
+template <typename ValueType>
+class AdaptiveStorage
+{
+    using MapCellIterator = typename MapStorage<ValueType>::CellIterator;
+    using ChunkedCellIterator = typename ChunkedStorage<ValueType>::CellIterator;
+
+    bool is_chunked;
+    MapStorage<ValueType> map_values;
+    ChunkedStorage<ValueType> chunked_values;
+public:
+    using Cell = std::pair<Coordinate2D, const ValueType &>;
+
+    // Iterator of storage in use, the other one is never moved
+    class CellIterator : public std::iterator<std::forward_iterator_tag, Cell, int, void, Cell>
+    {
+        bool is_chunked;
+        MapCellIterator map_iterator;
+        ChunkedCellIterator chunked_iterator;
+    public:
+        CellIterator(bool is_chunked_tmp, MapCellIterator map_iterator_tmp, ChunkedCellIterator chunked_iterator_tmp);
+        Cell operator*() const;
+        CellIterator &operator++();
+        CellIterator operator++(int);
+        bool operator==(const CellIterator &other) const;
+        bool operator!=(const CellIterator &other) const;
+    };
+
+    AdaptiveStorage();
+
+    // Chooses ChunkedStorage if it takes less memory than MapStorage for given number of cells
+    void reserve(int height, int width, int element_count);
+
+    ValueType &access(const Coordinate2D &coordinate);
+    const ValueType *find(const Coordinate2D &coordinate) const;
+    ValueType *find(const Coordinate2D &coordinate);
+    int getElementCount() const;
+    CellIterator begin() const;
+    CellIterator end() const;
+    CellIterator lowerBound(const Coordinate2D &coordinate) const;
+    bool operator==(const AdaptiveStorage &other) const;
+
+    bool isChunked() const;
+};
+
+
+#endif // SPARSE_TABLE_STORAGE_H_INCLUDED
@@ -0,0 +1,126 @@
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+#include <ctime>
+#include <cstdlib>
+#include <new>
+
+#include "stats.h"
+
+
+#ifndef NO_STATS
+
+// Zero-initialized as object of static storage duration
+StatsData stats_data;
+
+// The innermost timer of thread, its time is paused while nested timer runs
+thread_local StatsStageTimer *current_timer = nullptr;
+
+
+uint64_t getNanosecondsBetween(const timespec &start, const timespec &finish) {
+    return static_cast<uint64_t>(
+        (finish.tv_sec - start.tv_sec) * 1000000000LL + (finish.tv_nsec - start.tv_nsec)
+    );
+}
+
+
+void shiftTime(timespec &time, uint64_t nanoseconds) {
+    long long shifted_nanoseconds = time.tv_nsec + static_cast<long long>(nanoseconds);
+    time.tv_sec += static_cast<time_t>(shifted_nanoseconds / 1000000000LL);
+    time.tv_nsec = static_cast<long>(shifted_nanoseconds % 1000000000LL);
+}
+
+
+StatsStageTimer::StatsStageTimer(StatsStage stage_tmp) : stage(stage_tmp), outer_timer(nullptr) {
+    if (!stats_data.is_enabled) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    outer_timer = current_timer;
+    current_timer = this;
+}
+
+
+StatsStageTimer::~StatsStageTimer() {
+    if (!stats_data.is_enabled || current_timer != this) {
+        return;
+    }
+    timespec wall_finish, cpu_finish;
+    clock_gettime(CLOCK_MONOTONIC, &wall_finish);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_finish);
+    uint64_t wall_nanoseconds = getNanosecondsBetween(wall_start, wall_finish);
+    uint64_t cpu_nanoseconds = getNanosecondsBetween(cpu_start, cpu_finish);
+
+    int stage_index = static_cast<int>(stage);
+    stats_data.wall_nanoseconds[stage_index].fetch_add(wall_nanoseconds, std::memory_order_relaxed);
+    stats_data.cpu_nanoseconds[stage_index].fetch_add(cpu_nanoseconds, std::memory_order_relaxed);
+
+    // Outer timer starts later by time of this one
+    if (outer_timer) {
+        shiftTime(outer_timer->wall_start, wall_nanoseconds);
+        shiftTime(outer_timer->cpu_start, cpu_nanoseconds);
+    }
+    current_timer = outer_timer;
+}
+
+
+// Allocations are counted by replaced global operators, memory is managed as by default ones
+void *operator new(size_t size) {
+    addStatsCounter(StatsCounter::ALLOCATIONS, 1);
+    void *pointer = std::malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+
+void operator delete(void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+
+bool enableStats() {
+    stats_data.is_enabled = true;
+    return true;
+}
+
+
+void printStats(std::ostream &out_stream) {
+    const char *stage_names[] = {"read", "parse", "evaluate", "format", "print", "save"};
+    const char *counter_names[] = {
+        "cells", "formulas", "references", "errors", "cycle_cells", "dependency_depth", "allocations"
+    };
+
+    out_stream << std::fixed << std::setprecision(3) << "{\"stages\": {";
+    for (int stage_index = 0; stage_index < static_cast<int>(StatsStage::COUNT); ++stage_index) {
+        out_stream << (stage_index ? ", \"" : "\"") << stage_names[stage_index] << "\": {";
+        out_stream << "\"wall_ms\": " << static_cast<double>(stats_data.wall_nanoseconds[stage_index].load()) / 1e6;
+        out_stream << ", \"cpu_ms\": " << static_cast<double>(stats_data.cpu_nanoseconds[stage_index].load()) / 1e6 << "}";
+    }
+    out_stream << "}, \"counters\": {";
+    for (int counter_index = 0; counter_index < static_cast<int>(StatsCounter::COUNT); ++counter_index) {
+        out_stream << (counter_index ? ", \"" : "\"") << counter_names[counter_index] << "\": ";
+        out_stream << stats_data.counters[counter_index].load();
+    }
+    out_stream << "}}" << std::endl;
+}
+
+#else
+
+bool enableStats() {
+    return false;
+}
+
+
+void printStats(std::ostream &out_stream) {
+    out_stream << "{}" << std::endl;
+}
+
+#endif
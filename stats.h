@@ -0,0 +1,131 @@
+#ifndef STATS_H_INCLUDED
+#define STATS_H_INCLUDED
+
+#include <atomic>
+#include <ostream>
+#include <cstdint>
+#include <ctime>
+
+
+// Instrumentation of table processing: wall and CPU time of stages and counters of work done.
+// Nothing is collected until enableStats() is called; building with NO_STATS defined
+// turns all functions below into empty inline ones
+
+enum class StatsStage {
+    READ,
+    PARSE,
+    EVALUATE,
+    FORMAT,
+    PRINT,
+    // Writing of snapshot
+    SAVE,
+    COUNT
+};
+
+enum class StatsCounter {
+    // Filled cells of input
+    CELLS,
+    // Arithmetic cells which need calculation
+    FORMULAS,
+    // References and aggregates resolved while calculating
+    REFERENCES,
+    // Printed cells with errors
+    ERRORS,
+    // Cells found on reference cycles
+    CYCLE_CELLS,
+    // The largest number of levels of dependencies, cells of one level are calculated concurrently
+    DEPENDENCY_DEPTH,
+    // Calls of global operator new, it is replaced together with stats
+    ALLOCATIONS,
+    COUNT
+};
+
+
+#ifndef NO_STATS
+
+struct StatsData
+{
+    bool is_enabled = false;
+    std::atomic<uint64_t> counters[static_cast<int>(StatsCounter::COUNT)];
+    std::atomic<uint64_t> wall_nanoseconds[static_cast<int>(StatsStage::COUNT)];
+    std::atomic<uint64_t> cpu_nanoseconds[static_cast<int>(StatsStage::COUNT)];
+};
+
+extern StatsData stats_data;
+
+#endif
+
+
+// Returns false if instrumentation is compiled out
+bool enableStats();
+
+inline bool isStatsEnabled() {
+#ifndef NO_STATS
+    return stats_data.is_enabled;
+#else
+    return false;
+#endif
+}
+
+inline void addStatsCounter(StatsCounter counter, uint64_t value) {
+#ifndef NO_STATS
+    if (stats_data.is_enabled) {
+        stats_data.counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+#else
+    (void)counter;
+    (void)value;
+#endif
+}
+
+inline uint64_t getStatsCounter(StatsCounter counter) {
+#ifndef NO_STATS
+    return stats_data.counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+#else
+    (void)counter;
+    return 0;
+#endif
+}
+
+// Counter becomes the largest of its value and given one
+inline void raiseStatsCounter(StatsCounter counter, uint64_t value) {
+#ifndef NO_STATS
+    if (stats_data.is_enabled) {
+        auto &stored_value = stats_data.counters[static_cast<int>(counter)];
+        uint64_t current_value = stored_value.load(std::memory_order_relaxed);
+        while (current_value < value && !stored_value.compare_exchange_weak(current_value, value, std::memory_order_relaxed)) {
+        }
+    }
+#else
+    (void)counter;
+    (void)value;
+#endif
+}
+
+
+// Adds time from construction to destruction to given stage. Time of timers nested in it
+// on the same thread is excluded, so every moment is counted for one stage only
+class StatsStageTimer
+{
+#ifndef NO_STATS
+    StatsStage stage;
+    timespec wall_start;
+    timespec cpu_start;
+    StatsStageTimer *outer_timer;
+public:
+    explicit StatsStageTimer(StatsStage stage_tmp);
+    ~StatsStageTimer();
+#else
+public:
+    explicit StatsStageTimer(StatsStage) {}
+#endif
+    StatsStageTimer(const StatsStageTimer&) = delete;
+    StatsStageTimer &operator=(const StatsStageTimer&) = delete;
+};
+
+
+// Times of stages in milliseconds and counters as one line of JSON
+void printStats(std::ostream &out_stream);
+
+
+#endif // STATS_H_INCLUDED
@@ -0,0 +1,123 @@
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "utils.h"
+#include "string_pool.h"
+#include "arena.h"
+
+
+size_t StringRefHash::operator()(const StringRef &string) const {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (char character : string) {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+
+std::atomic<uint64_t> next_string_pool_id(1);
+thread_local StringPool *current_string_pool = nullptr;
+
+
+StringPool::StringPool() : id(next_string_pool_id++) {}
+
+
+StringPool &StringPool::getCurrent() {
+    static StringPool program_pool;
+    return (current_string_pool ? *current_string_pool : program_pool);
+}
+
+
+StringPool *StringPool::setCurrent(StringPool *pool) {
+    StringPool *previous_pool = current_string_pool;
+    current_string_pool = pool;
+    return previous_pool;
+}
+
+
+// Characters of record made by StringPool::intern
+StringRef getRecordString(const char *record) {
+    uint32_t length;
+    std::memcpy(&length, record, sizeof(length));
+    return {record + sizeof(length), record + sizeof(length) + length};
+}
+
+
+const char *StringPool::intern(const StringRef &string) {
+    size_t hash = StringRefHash()(string);
+
+    // Repeated strings are usually found in small per-thread cache without locking; it is cleared
+    // when thread interns into another pool
+    const int recent_record_count = 1024;
+    thread_local uint64_t recent_pool_id = 0;
+    thread_local const char *recent_records[recent_record_count] = {};
+    if (recent_pool_id != id) {
+        std::fill(recent_records, recent_records + recent_record_count, nullptr);
+        recent_pool_id = id;
+    }
+    const char *&recent_record = recent_records[hash % recent_record_count];
+    if (recent_record && getRecordString(recent_record) == string) {
+        return recent_record;
+    }
+
+    auto &shard = shards[hash % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto iterator = shard.strings.find(string);
+    if (iterator != shard.strings.end()) {
+        recent_record = iterator->begin() - sizeof(uint32_t);
+        return recent_record;
+    }
+
+    uint32_t length = static_cast<uint32_t>(string.getSize());
+    size_t record_size = sizeof(length) + length;
+    // Length is copied by memcpy, so records need no alignment
+    char *record = static_cast<char*>(shard.arena.allocate(record_size, 1));
+
+    std::memcpy(record, &length, sizeof(length));
+    std::memcpy(record + sizeof(length), string.begin(), length);
+    shard.strings.emplace(record + sizeof(length), record + record_size);
+    recent_record = record;
+    return record;
+}
+
+
+int StringPool::getStringCount() const {
+    int string_count = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        string_count += static_cast<int>(shard.strings.size());
+    }
+    return string_count;
+}
+
+
+size_t StringPool::getMemorySize() const {
+    size_t memory_size = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        memory_size += shard.arena.getMemorySize();
+    }
+    return memory_size;
+}
+
+
+InternedString::InternedString() : record(nullptr) {}
+
+
+InternedString::InternedString(const StringRef &string)
+    : record(string.empty() ? nullptr : StringPool::getCurrent().intern(string)) {}
+
+
+StringRef InternedString::get() const {
+    return (record ? getRecordString(record) : StringRef());
+}
+
+
+bool InternedString::operator==(const InternedString &other) const {
+    return record == other.record || (record && other.record && get() == other.get());
+}
@@ -0,0 +1,69 @@
+#ifndef STRING_POOL_H_INCLUDED
+#define STRING_POOL_H_INCLUDED
+
+#include <mutex>
+#include <unordered_set>
+#include <cstdint>
+
+#include "utils.h"
+#include "arena.h"
+
+
+struct StringRefHash
+{
+    size_t operator()(const StringRef &string) const;
+};
+
+
+// Set of distinct strings kept in arena blocks as long as pool lives, see CellPools.
+// Pool is split into independently locked shards, so strings may be interned concurrently
+class StringPool
+{
+    static const int SHARD_COUNT = 16;
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        // References to characters of records in arena
+        std::unordered_set<StringRef, StringRefHash> strings;
+        MonotonicArena arena;
+    };
+    Shard shards[SHARD_COUNT];
+    // Distinct for every pool ever made, so per-thread caches of destroyed pools are never used
+    uint64_t id;
+public:
+    StringPool();
+    StringPool(const StringPool&) = delete;
+    StringPool &operator=(const StringPool&) = delete;
+
+    // Pool strings are interned into by this thread: the one set by setCurrent, or pool of the whole run of program
+    static StringPool &getCurrent();
+    // Makes pool current for this thread, nullptr restores pool of the whole run; returns previous one
+    static StringPool *setCurrent(StringPool *pool);
+
+    // Record of given non-empty string: its length followed by its characters
+    const char *intern(const StringRef &string);
+
+    int getStringCount() const;
+    // Size of arena blocks allocated for records
+    size_t getMemorySize() const;
+};
+
+
+// Compact handle of string stored once in StringPool: handles of one pool are equal only for equal strings,
+// strings of different pools are compared by characters
+class InternedString
+{
+    // Record of string in pool, nullptr for empty string
+    const char *record;
+public:
+    InternedString();
+    // String is interned into current pool
+    explicit InternedString(const StringRef &string);
+
+    StringRef get() const;
+    bool operator==(const InternedString &other) const;
+};
+
+
+#endif // STRING_POOL_H_INCLUDED
@@ -0,0 +1,79 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "arena.h"
+
+
+struct ArenaRequest
+{
+    size_t size;
+    size_t alignment;
+};
+
+
+struct ArenaTest
+{
+    std::vector<ArenaRequest> requests;
+    size_t block_count;
+
+    ArenaTest(const std::vector<ArenaRequest> &requests_tmp, size_t block_count_tmp)
+        : requests(requests_tmp), block_count(block_count_tmp) {}
+};
+
+
+// Every request is filled with its own byte; requests should be aligned, not overlap and keep their bytes
+class UTMonotonicArena : public UnitTester<ArenaTest>
+{
+public:
+    UTMonotonicArena(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const ArenaTest &test) const {
+
+        MonotonicArena arena;
+        std::vector<char*> pointers;
+        for (size_t request_index = 0; request_index < test.requests.size(); ++request_index) {
+            const auto &request = test.requests[request_index];
+            auto *pointer = static_cast<char*>(arena.allocate(request.size, request.alignment));
+            if (reinterpret_cast<uintptr_t>(pointer) % request.alignment != 0) {
+                return false;
+            }
+            std::memset(pointer, static_cast<int>(request_index), request.size);
+            pointers.push_back(pointer);
+        }
+
+        for (size_t request_index = 0; request_index < test.requests.size(); ++request_index) {
+            for (size_t byte_index = 0; byte_index < test.requests[request_index].size; ++byte_index) {
+                if (pointers[request_index][byte_index] != static_cast<char>(request_index)) {
+                    return false;
+                }
+            }
+        }
+        return arena.getBlockCount() == test.block_count;
+
+    }
+};
+
+
+int main()
+{
+    UTMonotonicArena tester("MonotonicArena");
+
+    tester.runTest("No requests", {{}, 0});
+    tester.runTest("Small requests share block",
+        {{{1, 1}, {8, 8}, {3, 1}, {16, 16}, {4, 4}}, 1}
+    );
+    tester.runTest("Large request gets its own block",
+        {{{10, 1}, {100000, 16}, {10, 1}}, 2}
+    );
+
+    std::vector<ArenaRequest> requests(3000, ArenaRequest{50, 8});
+    tester.runTest("Blocks are filled one after another",
+        {requests, 3}
+    );
+
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <vector>
 #include <sstream>
 #include <memory>
+#include <limits>
 
 #include "unit_test.h"
 #include "unit_test.cpp"
@@ -9,9 +10,10 @@
 #include "sparse_table.h"
 #include "sparse_table.cpp"
 #include "expression_table.h"
+#include "thread_pool.h"
 
 
-using ExpressionTableEntry = SparseTable<Expression>::Entry;
+using ExpressionTableEntry = ExpressionTable::Entry;
 
 
 struct CalculateParsedTableTest
@@ -36,7 +38,7 @@ public:
 
     bool checkTest(const CalculateParsedTableTest &test) const {
 
-        auto input_table = makeSparseTable(test.height, test.width, test.input_entries.begin(), test.input_entries.end());
+        ExpressionTable input_table = makeSparseTable(test.height, test.width, test.input_entries.begin(), test.input_entries.end());
         auto expected = makeSparseTable(test.height, test.width, test.calculated_entries.begin(), test.calculated_entries.end());
         calculateParsedTable(input_table);
 
@@ -46,10 +48,29 @@ public:
 };
 
 
-int main()
+// Calculates table on thread pool of given size
+class UTCalculateParsedTableConcurrently : public UnitTester<CalculateParsedTableTest>
 {
-    UTCalculateParsedTable tester("calculateParsedTable");
+    int thread_count;
+public:
+    UTCalculateParsedTableConcurrently(const std::string &plan_name, int thread_count_tmp)
+        : UnitTester(plan_name), thread_count(thread_count_tmp) {}
+
+    bool checkTest(const CalculateParsedTableTest &test) const {
+
+        ExpressionTable input_table = makeSparseTable(test.height, test.width, test.input_entries.begin(), test.input_entries.end());
+        auto expected = makeSparseTable(test.height, test.width, test.calculated_entries.begin(), test.calculated_entries.end());
+        ThreadPool thread_pool(thread_count);
+        calculateParsedTable(input_table, thread_pool);
+
+        return input_table == expected;
+
+    }
+};
 
+
+template <typename Tester>
+void runCalculationTests(Tester &tester) {
     using LexemVector = std::vector<std::shared_ptr<LexemBase>>;
 
     tester.runTest("Simple 1x1 arithmetic",
@@ -82,6 +103,172 @@ int main()
         }
     );
 
+    tester.runTest("References beyond A1..Z9 region",
+        {
+            20000, 100,
+            {
+                {{19999, 99}, parseExpression("=AB12345*2")},
+                {{12344, 27}, parseExpression("=$A$1+3")},
+                {{0, 0}, parseExpression("7")},
+                {{0, 1}, parseExpression("=A20001")},
+            }, {
+                {{19999, 99}, parseExpression("20")},
+                {{12344, 27}, parseExpression("10")},
+                {{0, 0}, parseExpression("7")},
+                {{0, 1}, makeErrorExpression("Coordinates (20000, 0) are out of range (20000, 100)")},
+            }
+        }
+    );
+
+    tester.runTest("Aggregates over column of numbers, text and empty cells",
+        {
+            5, 2,
+            {
+                {{0, 0}, parseExpression("4")},
+                {{1, 0}, parseExpression("'Text")},
+                {{2, 0}, parseExpression("-2")},
+                {{3, 0}, parseExpression("=A1*3")},
+                {{0, 1}, parseExpression("=SUM(A1:A5)")},
+                {{1, 1}, parseExpression("=MIN(A1:A5)+MAX(A5:A1)*100")},
+                {{2, 1}, parseExpression("=COUNT(A1:A5)")},
+                {{3, 1}, parseExpression("=AVG(A1:A5)")},
+                {{4, 1}, parseExpression("=SUM(A1:A1)+SUM(A2)")},
+            }, {
+                {{0, 0}, parseExpression("4")},
+                {{1, 0}, parseExpression("'Text")},
+                {{2, 0}, makeErrorExpression("'-2' is not a non-negative integer number")},
+                {{3, 0}, parseExpression("12")},
+                {{0, 1}, makeErrorExpression("Error in referred cell")},
+                {{1, 1}, makeErrorExpression("Error in referred cell")},
+                {{2, 1}, makeErrorExpression("Error in referred cell")},
+                {{3, 1}, makeErrorExpression("Error in referred cell")},
+                {{4, 1}, parseExpression("4")},
+            }
+        }
+    );
+
+    tester.runTest("Aggregates over ranges of several columns",
+        {
+            3, 4,
+            {
+                {{0, 0}, parseExpression("1")},
+                {{0, 1}, parseExpression("2")},
+                {{1, 0}, parseExpression("=A1+B1")},
+                {{1, 1}, parseExpression("8")},
+                {{0, 2}, parseExpression("=SUM(A1:B2)")},
+                {{1, 2}, parseExpression("=MIN(A1:B2)*100+MAX(B2:A1)")},
+                {{2, 2}, parseExpression("=COUNT(A1:B3)*100+AVG(A1:B3)")},
+                {{0, 3}, parseExpression("=MIN(A3:B3)+MAX(A3:B3)+COUNT(A3:B3)+SUM(A3:B3)")},
+                {{1, 3}, parseExpression("=AVG(A3:B3)")},
+            }, {
+                {{0, 0}, parseExpression("1")},
+                {{0, 1}, parseExpression("2")},
+                {{1, 0}, parseExpression("3")},
+                {{1, 1}, parseExpression("8")},
+                {{0, 2}, parseExpression("14")},
+                {{1, 2}, parseExpression("108")},
+                {{2, 2}, parseExpression("403")},
+                {{0, 3}, parseExpression("0")},
+                {{1, 3}, makeErrorExpression("Division by 0")},
+            }
+        }
+    );
+
+    tester.runTest("Running totals",
+        {
+            4, 2,
+            {
+                {{0, 0}, parseExpression("1")},
+                {{1, 0}, parseExpression("2")},
+                {{2, 0}, parseExpression("3")},
+                {{3, 0}, parseExpression("4")},
+                {{0, 1}, parseExpression("=SUM(A$1:A1)")},
+                {{1, 1}, parseExpression("=SUM(A$1:A2)")},
+                {{2, 1}, parseExpression("=SUM(A$1:A3)")},
+                {{3, 1}, parseExpression("=SUM(A$1:A4)")},
+            }, {
+                {{0, 0}, parseExpression("1")},
+                {{1, 0}, parseExpression("2")},
+                {{2, 0}, parseExpression("3")},
+                {{3, 0}, parseExpression("4")},
+                {{0, 1}, parseExpression("1")},
+                {{1, 1}, parseExpression("3")},
+                {{2, 1}, parseExpression("6")},
+                {{3, 1}, parseExpression("10")},
+            }
+        }
+    );
+
+    tester.runTest("64-bit numbers and overflow",
+        {
+            3, 4,
+            {
+                {{0, 0}, parseExpression("9223372036854775807")},
+                {{1, 0}, parseExpression("9223372036854775807")},
+                {{2, 0}, parseExpression("=A1-A2-A2-1")},
+                {{0, 1}, parseExpression("=A1+1")},
+                {{1, 1}, parseExpression("=A3/(0-1)")},
+                {{2, 1}, parseExpression("=A1*2")},
+                {{0, 2}, parseExpression("=SUM(A1:A2)")},
+                {{1, 2}, parseExpression("=AVG(A1:A2)")},
+                {{2, 2}, parseExpression("=SUM(A1:A3)")},
+                {{0, 3}, parseExpression("=B1+1")},
+            }, {
+                {{0, 0}, parseExpression("9223372036854775807")},
+                {{1, 0}, parseExpression("9223372036854775807")},
+                {{2, 0}, {ExpressionType::ARITHMETIC, LexemVector{std::make_shared<LexemNumber>(std::numeric_limits<Number>::min())}}},
+                {{0, 1}, makeErrorExpression("Arithmetic overflow")},
+                {{1, 1}, makeErrorExpression("Arithmetic overflow")},
+                {{2, 1}, makeErrorExpression("Arithmetic overflow")},
+                {{0, 2}, makeErrorExpression("Arithmetic overflow")},
+                {{1, 2}, parseExpression("9223372036854775807")},
+                {{2, 2}, parseExpression("9223372036854775806")},
+                {{0, 3}, makeErrorExpression("Error in referred cell")},
+            }
+        }
+    );
+
+    tester.runTest("Aggregate containing its own cell",
+        {
+            3, 1,
+            {
+                {{0, 0}, parseExpression("1")},
+                {{1, 0}, parseExpression("=SUM(A1:A3)")},
+                {{2, 0}, parseExpression("=A2+1")},
+            }, {
+                {{0, 0}, parseExpression("1")},
+                {{1, 0}, makeErrorExpression("Infinite cycle in references")},
+                {{2, 0}, makeErrorExpression("Infinite cycle in references")},
+            }
+        }
+    );
+
+    tester.runTest("Aggregate over range out of table",
+        {
+            2, 2,
+            {
+                {{0, 0}, parseExpression("1")},
+                {{0, 1}, parseExpression("=SUM(A1:A3)")},
+            }, {
+                {{0, 0}, parseExpression("1")},
+                {{0, 1}, makeErrorExpression("Coordinates (2, 0) are out of range (2, 2)")},
+            }
+        }
+    );
+
+    tester.runTest("Aggregate over huge range out of table",
+        {
+            1, 2,
+            {
+                {{0, 0}, parseExpression("=A1")},
+                {{0, 1}, parseExpression("=SUM(A1:FXSHRXW2147483647)")},
+            }, {
+                {{0, 0}, makeErrorExpression("Infinite cycle in references")},
+                {{0, 1}, makeErrorExpression("Coordinates (2147483646, 2147483646) are out of range (1, 2)")},
+            }
+        }
+    );
+
     tester.runTest("1x1 with negative result",
         {
             1, 1,
@@ -114,8 +301,8 @@ int main()
                 {{0, 1}, {ExpressionType::ARITHMETIC, LexemVector{std::make_shared<LexemNumber>(-4)}}},
                 {{0, 2}, parseExpression("3")},
                 {{0, 3}, parseExpression("'Sample")},
-                {{1, 0}, parseExpression("4")},
-                {{1, 1}, {ExpressionType::ARITHMETIC, LexemVector{std::make_shared<LexemNumber>(-16)}}},
+                {{1, 0}, parseExpression("10")},
+                {{1, 1}, {ExpressionType::ARITHMETIC, LexemVector{std::make_shared<LexemNumber>(-40)}}},
                 {{1, 2}, {ExpressionType::ARITHMETIC, LexemVector{std::make_shared<LexemNumber>(-4)}}},
                 {{1, 3}, parseExpression("'Spread")},
                 {{2, 0}, parseExpression("'Test")},
@@ -166,5 +353,153 @@ int main()
         }
     );
 
+    tester.runTest("Operation precedence and parentheses",
+        {
+            2, 4,
+            {
+                {{0, 0}, parseExpression("=1+2*3")},
+                {{0, 1}, parseExpression("=(1+2)*3")},
+                {{0, 2}, parseExpression("=100/10/5-8/(2+2)")},
+                {{0, 3}, parseExpression("=((B1))-(A1-(C1*2))")},
+                {{1, 0}, parseExpression("=2*(SUM(A1:C1)+1)")},
+                {{1, 1}, parseExpression("=1+2/(A1-7)")},
+                {{1, 2}, parseExpression("=(1+2")},
+                {{1, 3}, parseExpression("=1+2)*3")},
+            }, {
+                {{0, 0}, parseExpression("7")},
+                {{0, 1}, parseExpression("9")},
+                {{0, 2}, parseExpression("0")},
+                {{0, 3}, parseExpression("2")},
+                {{1, 0}, parseExpression("34")},
+                {{1, 1}, makeErrorExpression("Division by 0")},
+                {{1, 2}, makeErrorExpression("Unbalanced parentheses")},
+                {{1, 3}, makeErrorExpression("Unbalanced parentheses")},
+            }
+        }
+    );
+
+    tester.runTest("References to empty cells are not inserted",
+        {
+            3, 3,
+            {
+                {{0, 0}, parseExpression("=B2")},
+                {{2, 2}, parseExpression("=C2+A1")},
+            }, {
+                {{0, 0}, makeErrorExpression("Not a number in referred cell")},
+                {{2, 2}, makeErrorExpression("Not a number in referred cell")},
+            }
+        }
+    );
+
+    tester.runTest("Self reference",
+        {
+            2, 2,
+            {
+                {{0, 0}, parseExpression("=A1")},
+                {{0, 1}, parseExpression("=A1+1")},
+                {{1, 0}, parseExpression("=7")},
+            }, {
+                {{0, 0}, makeErrorExpression("Infinite cycle in references")},
+                {{0, 1}, makeErrorExpression("Error in referred cell")},
+                {{1, 0}, parseExpression("7")},
+            }
+        }
+    );
+
+    tester.runTest("Cycle of three cells with dependents",
+        {
+            3, 3,
+            {
+                {{0, 0}, parseExpression("=B1")},
+                {{0, 1}, parseExpression("=C1+0")},
+                {{0, 2}, parseExpression("=A1*2")},
+                {{1, 0}, parseExpression("=C1")},
+                {{1, 1}, parseExpression("=A2-1")},
+                {{2, 2}, parseExpression("=5*A3")},
+                {{2, 0}, parseExpression("=3")},
+            }, {
+                {{0, 0}, makeErrorExpression("Infinite cycle in references")},
+                {{0, 1}, makeErrorExpression("Infinite cycle in references")},
+                {{0, 2}, makeErrorExpression("Infinite cycle in references")},
+                {{1, 0}, makeErrorExpression("Error in referred cell")},
+                {{1, 1}, makeErrorExpression("Error in referred cell")},
+                {{2, 2}, parseExpression("15")},
+                {{2, 0}, parseExpression("3")},
+            }
+        }
+    );
+
+    tester.runTest("Cell between two cycles",
+        {
+            1, 3,
+            {
+                {{0, 0}, parseExpression("=A1")},
+                {{0, 1}, parseExpression("=A1")},
+                {{0, 2}, parseExpression("=C1+B1")},
+            }, {
+                {{0, 0}, makeErrorExpression("Infinite cycle in references")},
+                {{0, 1}, makeErrorExpression("Error in referred cell")},
+                {{0, 2}, makeErrorExpression("Infinite cycle in references")},
+            }
+        }
+    );
+
+    // A1 = A2 + 1, A2 = A3 + 1, ..., last cell is 0: too deep for recursive evaluation
+    const int chain_length = 100000;
+    std::vector<ExpressionTableEntry> chain_entries;
+    std::vector<ExpressionTableEntry> calculated_chain_entries;
+    for (int row_index = 0; row_index < chain_length; ++row_index) {
+        if (row_index + 1 < chain_length) {
+            chain_entries.push_back({{row_index, 0}, {ExpressionType::ARITHMETIC, LexemVector{
+                std::make_shared<LexemCellReference>(Coordinate2D(row_index + 1, 0)),
+                std::make_shared<LexemOperation>(Operation::ADD),
+                std::make_shared<LexemNumber>(1),
+            }}});
+        } else {
+            chain_entries.push_back({{row_index, 0}, parseExpression("0")});
+        }
+        calculated_chain_entries.push_back({{row_index, 0}, {ExpressionType::ARITHMETIC, LexemVector{
+            std::make_shared<LexemNumber>(chain_length - 1 - row_index),
+        }}});
+    }
+    tester.runTest("Long chain of references",
+        {chain_length, 1, chain_entries, calculated_chain_entries}
+    );
+
+    // Every cell of row i + 1 sums two cells of row i: wide levels of independent cells
+    const int level_count = 20;
+    const int level_width = 500;
+    std::vector<ExpressionTableEntry> level_entries;
+    std::vector<ExpressionTableEntry> calculated_level_entries;
+    for (int row_index = 0; row_index < level_count; ++row_index) {
+        for (int column_index = 0; column_index < level_width; ++column_index) {
+            if (row_index == 0) {
+                level_entries.push_back({{row_index, column_index}, parseExpression("1")});
+            } else {
+                level_entries.push_back({{row_index, column_index}, {ExpressionType::ARITHMETIC, LexemVector{
+                    std::make_shared<LexemCellReference>(Coordinate2D(row_index - 1, column_index)),
+                    std::make_shared<LexemOperation>(Operation::ADD),
+                    std::make_shared<LexemCellReference>(Coordinate2D(row_index - 1, (column_index + 1) % level_width)),
+                }}});
+            }
+            calculated_level_entries.push_back({{row_index, column_index}, {ExpressionType::ARITHMETIC, LexemVector{
+                std::make_shared<LexemNumber>(1 << row_index),
+            }}});
+        }
+    }
+    tester.runTest("Wide dependency levels",
+        {level_count, level_width, level_entries, calculated_level_entries}
+    );
+}
+
+
+int main()
+{
+    UTCalculateParsedTable tester("calculateParsedTable");
+    runCalculationTests(tester);
+
+    UTCalculateParsedTableConcurrently concurrent_tester("calculateParsedTable on 4 threads", 4);
+    runCalculationTests(concurrent_tester);
+
     return 0;
 }
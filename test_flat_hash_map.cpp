@@ -0,0 +1,187 @@
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <random>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "coordinate.h"
+#include "flat_hash_map.h"
+#include "flat_hash_map.cpp"
+
+
+enum class FlatHashMapOperation {
+    INSERT,
+    ASSIGN,
+    ERASE
+};
+
+
+struct FlatHashMapStep
+{
+    FlatHashMapOperation operation;
+    Coordinate2D key;
+    int value;
+};
+
+
+struct FlatHashMapTest
+{
+    std::vector<FlatHashMapStep> steps;
+
+    FlatHashMapTest(const std::vector<FlatHashMapStep> &steps_tmp) : steps(steps_tmp) {}
+};
+
+
+// Every step is applied to FlatHashMap and std::map, then their contents are compared by lookups and iteration
+class UTFlatHashMap : public UnitTester<FlatHashMapTest>
+{
+public:
+    UTFlatHashMap(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const FlatHashMapTest &test) const {
+
+        FlatHashMap<int> map;
+        std::map<Coordinate2D, int> expected_map;
+        std::set<Coordinate2D> keys;
+
+        for (const auto &step : test.steps) {
+            keys.insert(step.key);
+            bool is_present = expected_map.count(step.key) > 0;
+            if (step.operation == FlatHashMapOperation::INSERT) {
+                if (map.insert(step.key, step.value) == is_present) {
+                    return false;
+                }
+                expected_map.insert({step.key, step.value});
+            } else if (step.operation == FlatHashMapOperation::ASSIGN) {
+                map[step.key] = step.value;
+                expected_map[step.key] = step.value;
+            } else {
+                if (map.erase(step.key) != is_present) {
+                    return false;
+                }
+                expected_map.erase(step.key);
+            }
+        }
+
+        if (map.size() != expected_map.size() || map.empty() != expected_map.empty()) {
+            return false;
+        }
+        for (const auto &key : keys) {
+            auto iterator = expected_map.find(key);
+            const int *value = static_cast<const FlatHashMap<int>&>(map).find(key);
+            if ((iterator == expected_map.end()) != (value == nullptr) || map.contains(key) != (value != nullptr)) {
+                return false;
+            }
+            if (value && *value != iterator->second) {
+                return false;
+            }
+        }
+
+        std::map<Coordinate2D, int> iterated_map;
+        for (const auto &entry : map) {
+            if (!iterated_map.insert(entry).second) {
+                return false;
+            }
+        }
+        return iterated_map == expected_map;
+
+    }
+};
+
+
+// Keys of one row or one column should not collide
+class UTCoordinate2DHash : public UnitTester<std::vector<Coordinate2D>>
+{
+public:
+    UTCoordinate2DHash(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const std::vector<Coordinate2D> &keys) const {
+        std::set<size_t> hashes;
+        for (const auto &key : keys) {
+            hashes.insert(Coordinate2DHash()(key));
+        }
+        return hashes.size() == keys.size();
+    }
+};
+
+
+std::vector<FlatHashMapStep> makeRandomSteps(int step_count, int key_range, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> operation_distribution(0, 2);
+    std::uniform_int_distribution<int> key_distribution(0, key_range - 1);
+    std::vector<FlatHashMapStep> steps;
+    for (int step_index = 0; step_index < step_count; ++step_index) {
+        steps.push_back({
+            static_cast<FlatHashMapOperation>(operation_distribution(generator)),
+            {key_distribution(generator), key_distribution(generator)},
+            step_index
+        });
+    }
+    return steps;
+}
+
+
+int main()
+{
+    UTFlatHashMap tester("FlatHashMap");
+
+    tester.runTest("Empty map", {{}});
+    tester.runTest("Erase from empty map",
+        {{{FlatHashMapOperation::ERASE, {1, 1}, 0}}}
+    );
+    tester.runTest("Insert does not replace value",
+        {{
+            {FlatHashMapOperation::INSERT, {0, 0}, 1},
+            {FlatHashMapOperation::INSERT, {0, 0}, 2},
+            {FlatHashMapOperation::INSERT, {0, 1}, 3},
+        }}
+    );
+    tester.runTest("Assign replaces value",
+        {{
+            {FlatHashMapOperation::ASSIGN, {0, 0}, 1},
+            {FlatHashMapOperation::ASSIGN, {0, 0}, 2},
+        }}
+    );
+    tester.runTest("Negative and large coordinates",
+        {{
+            {FlatHashMapOperation::INSERT, {-1, -1}, 1},
+            {FlatHashMapOperation::INSERT, {2147483647, -2147483647 - 1}, 2},
+            {FlatHashMapOperation::INSERT, {0, 0}, 3},
+            {FlatHashMapOperation::ERASE, {-1, -1}, 0},
+        }}
+    );
+
+    std::vector<FlatHashMapStep> row_steps;
+    for (int column = 0; column < 5000; ++column) {
+        row_steps.push_back({FlatHashMapOperation::INSERT, {7, column}, column});
+    }
+    for (int column = 0; column < 5000; column += 3) {
+        row_steps.push_back({FlatHashMapOperation::ERASE, {7, column}, 0});
+    }
+    tester.runTest("Cells of one row, every third erased", {row_steps});
+
+    tester.runTest("Random operations on dense keys", {makeRandomSteps(20000, 30, 1)});
+    tester.runTest("Random operations on sparse keys", {makeRandomSteps(20000, 1000, 2)});
+
+    UTCoordinate2DHash hash_tester("Coordinate2DHash");
+
+    std::vector<Coordinate2D> row_keys;
+    std::vector<Coordinate2D> column_keys;
+    std::vector<Coordinate2D> square_keys;
+    for (int index = 0; index < 1000; ++index) {
+        row_keys.emplace_back(3, index);
+        column_keys.emplace_back(index, 3);
+    }
+    for (int row = 0; row < 100; ++row) {
+        for (int column = 0; column < 100; ++column) {
+            square_keys.emplace_back(row, column);
+        }
+    }
+    hash_tester.runTest("Cells of one row", row_keys);
+    hash_tester.runTest("Cells of one column", column_keys);
+    hash_tester.runTest("Square of cells", square_keys);
+
+    return 0;
+}
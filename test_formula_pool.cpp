@@ -0,0 +1,179 @@
+#include <vector>
+#include <string>
+#include <thread>
+#include <memory>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "coordinate.h"
+#include "expression.h"
+#include "formula_pool.h"
+
+
+struct FormulaPoolCell
+{
+    std::string raw_formula;
+    Coordinate2D coordinate;
+    // Cells of the same group should share compiled formula, -1 for cells without shared formula
+    int group;
+};
+
+
+struct FormulaPoolTest
+{
+    std::vector<FormulaPoolCell> cells;
+    int thread_count;
+
+    FormulaPoolTest(const std::vector<FormulaPoolCell> &cells_tmp, int thread_count_tmp = 1)
+        : cells(cells_tmp), thread_count(thread_count_tmp) {}
+};
+
+
+// Every thread parses all cells; formulas should be shared exactly by cells of the same group
+// and tokens should not depend on anchor
+class UTFormulaPool : public UnitTester<FormulaPoolTest>
+{
+public:
+    UTFormulaPool(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const FormulaPoolTest &test) const {
+
+        std::vector<std::vector<Expression>> expressions(static_cast<size_t>(test.thread_count));
+        std::vector<std::thread> threads;
+        for (int thread_index = 0; thread_index < test.thread_count; ++thread_index) {
+            threads.emplace_back([&test, &expressions, thread_index]() {
+                for (const auto &cell : test.cells) {
+                    expressions[static_cast<size_t>(thread_index)].push_back(parseExpression(cell.raw_formula, cell.coordinate));
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        for (const auto &thread_expressions : expressions) {
+            for (size_t first_index = 0; first_index < test.cells.size(); ++first_index) {
+                const auto &first_cell = test.cells[first_index];
+                if (!(thread_expressions[first_index] == parseExpression(first_cell.raw_formula))) {
+                    return false;
+                }
+                if ((thread_expressions[first_index].getFormula() != nullptr) != (first_cell.group != -1)) {
+                    return false;
+                }
+                for (size_t second_index = 0; second_index < test.cells.size(); ++second_index) {
+                    bool are_grouped = (first_cell.group != -1 && first_cell.group == test.cells[second_index].group);
+                    bool are_shared = (
+                        thread_expressions[first_index].getFormula() != nullptr
+                        && thread_expressions[first_index].getFormula() == expressions[0][second_index].getFormula()
+                    );
+                    if (are_grouped != are_shared) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+
+    }
+};
+
+
+// Cells parsed in scope of pools should be interned into them, equal to cells of pools of the whole run,
+// and pools should be freed with the last holder
+class UTCellPools : public UnitTester<std::vector<std::string>>
+{
+public:
+    UTCellPools(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const std::vector<std::string> &raw_cells) const {
+
+        std::vector<Expression> program_expressions;
+        for (const auto &raw_cell : raw_cells) {
+            program_expressions.push_back(parseExpression(raw_cell));
+        }
+
+        std::weak_ptr<CellPools> weak_pools;
+        {
+            auto pools = std::make_shared<CellPools>();
+            weak_pools = pools;
+            std::vector<Expression> pool_expressions;
+            {
+                CellPoolsScope scope(pools);
+                if (CellPoolsScope::getCurrentPools() != pools) {
+                    return false;
+                }
+                for (const auto &raw_cell : raw_cells) {
+                    pool_expressions.push_back(parseExpression(raw_cell));
+                }
+            }
+            if (CellPoolsScope::getCurrentPools() != nullptr) {
+                return false;
+            }
+
+            int formula_count = 0;
+            int text_count = 0;
+            for (size_t cell_index = 0; cell_index < raw_cells.size(); ++cell_index) {
+                const auto &pool_expression = pool_expressions[cell_index];
+                const auto &program_expression = program_expressions[cell_index];
+                bool is_formula = (pool_expression.getFormula() != nullptr);
+                formula_count += is_formula;
+                text_count += !pool_expression.getText().empty();
+                if (
+                    !(pool_expression == program_expression)
+                    || (is_formula && pool_expression.getFormula() == program_expression.getFormula())
+                    || parseExpression(raw_cells[cell_index]).getFormula() != program_expression.getFormula()
+                ) {
+                    return false;
+                }
+            }
+            if ((pools->formulas.getFormulaCount() > 0) != (formula_count > 0)
+                    || (pools->strings.getStringCount() > 0) != (text_count > 0)) {
+                return false;
+            }
+        }
+        return weak_pools.expired();
+
+    }
+};
+
+
+int main()
+{
+    UTFormulaPool tester("FormulaPool");
+
+    tester.runTest("Formula copied along column",
+        {{{"=A1+B1", {0, 2}, 0}, {"=A2+B2", {1, 2}, 0}, {"=A3+B3", {2, 2}, 0}}}
+    );
+    tester.runTest("Formula copied along row",
+        {{{"=(A1-A2)*10", {2, 0}, 0}, {"=(B1-B2)*10", {2, 1}, 0}, {"=(AA1-AA2)*10", {2, 26}, 0}}}
+    );
+    tester.runTest("Different formulas",
+        {{{"=A1+B1", {0, 2}, 0}, {"=A1+B2", {1, 2}, 1}, {"=A1*B1", {0, 3}, 2}, {"=A2+B2", {0, 2}, 3}}}
+    );
+    tester.runTest("The same formula in different cells",
+        {{{"=A1+1", {5, 5}, 0}, {"=A1+1", {6, 6}, 1}}}
+    );
+    tester.runTest("Constants and single references are not shared",
+        {{{"=1+2*3", {0, 0}, -1}, {"=(7)", {1, 0}, -1}, {"=B7", {0, 1}, -1}, {"12", {0, 2}, -1}}}
+    );
+    tester.runTest("Ranges of aggregates are absolute",
+        {{{"=SUM(A1:A3)*2", {0, 1}, 0}, {"=SUM(A1:A3)*2", {1, 1}, 0}, {"=SUM(A2:A4)*2", {1, 1}, 1}}}
+    );
+
+    std::vector<FormulaPoolCell> column_cells;
+    for (int row_index = 0; row_index < 2000; ++row_index) {
+        std::string row_name = std::to_string(row_index + 1);
+        column_cells.push_back({"=A" + row_name + "*2+B" + row_name, {row_index, 2}, 0});
+    }
+    tester.runTest("Concurrently parsed column",
+        {column_cells, 4}
+    );
+
+    UTCellPools pools_tester("CellPools");
+
+    pools_tester.runTest("Formulas and texts", {"=A1+B1", "'Label", "=SUM(A1:B2)*2", "12", "=A1+B1"});
+    pools_tester.runTest("Errors", {"#Pseudo-error", "=1+", "=B7"});
+    pools_tester.runTest("No cells", {});
+
+    return 0;
+}
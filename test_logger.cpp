@@ -0,0 +1,186 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <iostream>
+#include <chrono>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "logger.h"
+
+
+struct LoggerTest
+{
+    std::function<void()> logMessages;
+    std::vector<std::string> lines;
+    LogLevel level;
+    bool is_colored;
+    size_t repeat_limit;
+    // Long enough by default for messages of test to fall into one window
+    std::chrono::milliseconds repeat_window;
+
+    LoggerTest(
+        const std::function<void()> &logMessages_tmp, const std::vector<std::string> &lines_tmp,
+        LogLevel level_tmp = LogLevel::INFO, bool is_colored_tmp = false, size_t repeat_limit_tmp = 0,
+        std::chrono::milliseconds repeat_window_tmp = std::chrono::hours(1)
+    ) : logMessages(logMessages_tmp), lines(lines_tmp), level(level_tmp), is_colored(is_colored_tmp), repeat_limit(repeat_limit_tmp),
+        repeat_window(repeat_window_tmp) {}
+};
+
+
+// Written lines are compared regardless of order, messages of different threads are not ordered
+class UTLogger : public UnitTester<LoggerTest>
+{
+public:
+    UTLogger(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const LoggerTest &test) const {
+
+        std::ostringstream log_stream;
+        setLogStream(log_stream);
+        setLogLevel(test.level);
+        setLogColored(test.is_colored);
+        setLogRepeatLimit(test.repeat_limit, test.repeat_window);
+
+        test.logMessages();
+        flushLog();
+
+        setLogStream(std::cerr);
+        setLogLevel(LogLevel::INFO);
+        setLogColored(true);
+        setLogRepeatLimit(100);
+
+        std::vector<std::string> lines;
+        std::istringstream line_stream(log_stream.str());
+        for (std::string line; std::getline(line_stream, line);) {
+            lines.push_back(line);
+        }
+        auto expected_lines = test.lines;
+        std::sort(lines.begin(), lines.end());
+        std::sort(expected_lines.begin(), expected_lines.end());
+        return lines == expected_lines;
+
+    }
+};
+
+
+// Remembers whether it was formatted
+struct FormattingProbe
+{
+    bool *is_formatted;
+};
+
+std::ostream &operator<<(std::ostream &stream, const FormattingProbe &probe) {
+    *probe.is_formatted = true;
+    return stream << "probe";
+}
+
+
+int main()
+{
+    UTLogger tester("Logger");
+
+    tester.runTest("Plain message of several arguments",
+        {[]() { log_warn("Row ", 3, " has ", 2, " cells instead of ", 4); }, {"[WARN] Row 3 has 2 cells instead of 4"}}
+    );
+    tester.runTest("Colored messages of every level",
+        {
+            []() {
+                log_info("Info");
+                log_error("Error");
+                log_fatal("Fatal");
+            },
+            {
+                "\033[39;1m[INFO]\033[0m\033[39m Info\033[0m",
+                "\033[31;1m[ERROR]\033[0m\033[31m Error\033[0m",
+                "\033[35;1m[FATAL]\033[0m\033[35m Fatal\033[0m"
+            },
+            LogLevel::INFO, true
+        }
+    );
+
+    bool is_info_formatted = false;
+    bool is_warning_formatted = false;
+    tester.runTest("Messages below level are skipped before formatting",
+        {
+            [&is_info_formatted, &is_warning_formatted]() {
+                log_info("Skipped ", FormattingProbe{&is_info_formatted});
+                log_warn("Written ", FormattingProbe{&is_warning_formatted});
+                if (is_info_formatted || !is_warning_formatted) {
+                    log_error("Wrong formatting");
+                }
+            },
+            {"[WARN] Written probe"},
+            LogLevel::WARN
+        }
+    );
+    tester.runTest("Nothing is written at level none",
+        {[]() { log_fatal("Fatal"); }, {}, LogLevel::NONE}
+    );
+    tester.runTest("Repeated messages are limited and counted",
+        {
+            []() {
+                for (int row_index = 0; row_index < 5; ++row_index) {
+                    log_warn("Repeated row ", row_index);
+                }
+                log_warn(std::string("Messages not starting with literal are not limited"));
+                log_warn(std::string("Messages not starting with literal are not limited"));
+            },
+            {
+                "[WARN] Repeated row 0", "[WARN] Repeated row 1", "[WARN] Repeated row 2",
+                "[WARN] Messages not starting with literal are not limited",
+                "[WARN] Messages not starting with literal are not limited",
+                "[WARN] 2 repeated messages were suppressed"
+            },
+            LogLevel::INFO, false, 3
+        }
+    );
+    tester.runTest("Repeated messages are limited per window",
+        {
+            []() {
+                for (int burst_index = 0; burst_index < 2; ++burst_index) {
+                    for (int message_index = 0; message_index < 3; ++message_index) {
+                        log_warn("Burst ", burst_index, " message ", message_index);
+                    }
+                    // Summary of the first burst is written by the end of its window
+                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                }
+            },
+            {
+                "[WARN] Burst 0 message 0", "[WARN] Burst 0 message 1", "[WARN] 1 repeated messages were suppressed",
+                "[WARN] Burst 1 message 0", "[WARN] Burst 1 message 1", "[WARN] 1 repeated messages were suppressed"
+            },
+            LogLevel::INFO, false, 2, std::chrono::milliseconds(100)
+        }
+    );
+
+    std::vector<std::string> thread_lines;
+    for (int thread_index = 0; thread_index < 4; ++thread_index) {
+        for (int message_index = 0; message_index < 300; ++message_index) {
+            thread_lines.push_back("[INFO] Thread " + std::to_string(thread_index) + " message " + std::to_string(message_index));
+        }
+    }
+    tester.runTest("Messages of several threads",
+        {
+            []() {
+                std::vector<std::thread> threads;
+                for (int thread_index = 0; thread_index < 4; ++thread_index) {
+                    threads.emplace_back([thread_index]() {
+                        for (int message_index = 0; message_index < 300; ++message_index) {
+                            log_info("Thread ", thread_index, " message ", message_index);
+                        }
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+            },
+            thread_lines
+        }
+    );
+
+    return 0;
+}
@@ -113,7 +113,49 @@ int main()
         "F0", LexemType::CELL_REFERENCE
     });
     tester.runTest("Cell reference AD9", {
-        "AD9", LexemType::CELL_REFERENCE
+        "AD9", std::make_shared<LexemCellReference>(Coordinate2D(8, 29))
+    });
+    tester.runTest("Cell reference AB12345", {
+        "AB12345", std::make_shared<LexemCellReference>(Coordinate2D(12344, 27))
+    });
+    tester.runTest("Cell reference ZZ10", {
+        "ZZ10", std::make_shared<LexemCellReference>(Coordinate2D(9, 701))
+    });
+    tester.runTest("Cell reference XFD1048576", {
+        "XFD1048576", std::make_shared<LexemCellReference>(Coordinate2D(1048575, 16383))
+    });
+    tester.runTest("Cell reference in lower case", {
+        "ab7", std::make_shared<LexemCellReference>(Coordinate2D(6, 27))
+    });
+    tester.runTest("Absolute cell reference $A$1", {
+        "$A$1", std::make_shared<LexemCellReference>(Coordinate2D(0, 0))
+    });
+    tester.runTest("Cell reference with absolute column", {
+        "$C20", std::make_shared<LexemCellReference>(Coordinate2D(19, 2))
+    });
+    tester.runTest("Cell reference with absolute row", {
+        "BA$3", std::make_shared<LexemCellReference>(Coordinate2D(2, 52))
+    });
+    tester.runTest("Cell reference A01", {
+        "A01", LexemType::CELL_REFERENCE
+    });
+    tester.runTest("Cell reference with double $", {
+        "$$A1", LexemType::CELL_REFERENCE
+    });
+    tester.runTest("Cell reference with $ in the end", {
+        "A1$", LexemType::CELL_REFERENCE
+    });
+    tester.runTest("Cell reference with digits before letters", {
+        "1A", LexemType::CELL_REFERENCE
+    });
+    tester.runTest("Cell reference with letters after digits", {
+        "A1B", LexemType::CELL_REFERENCE
+    });
+    tester.runTest("Cell reference with too large row", {
+        "A2147483648", LexemType::CELL_REFERENCE
+    });
+    tester.runTest("Cell reference with too large column", {
+        "ZZZZZZZ1", LexemType::CELL_REFERENCE
     });
     tester.runTest("Cell reference A-3", {
         "A-3", LexemType::CELL_REFERENCE
@@ -131,6 +173,37 @@ int main()
         "", LexemType::CELL_REFERENCE
     });
 
+    tester.runTest("Aggregate over range", {
+        "SUM(A1:B3)", std::make_shared<LexemAggregate>(AggregateCall(Aggregate::SUM, CellRange({0, 0}, {2, 1})))
+    });
+    tester.runTest("Aggregate over range given by other corners", {
+        "max(B1:A3)", std::make_shared<LexemAggregate>(AggregateCall(Aggregate::MAX, CellRange({0, 0}, {2, 1})))
+    });
+    tester.runTest("Aggregate over single cell", {
+        "Avg($C$10)", std::make_shared<LexemAggregate>(AggregateCall(Aggregate::AVERAGE, CellRange({9, 2}, {9, 2})))
+    });
+    tester.runTest("Aggregate over long column", {
+        "COUNT(AA1:AA100000)", std::make_shared<LexemAggregate>(AggregateCall(Aggregate::COUNT, CellRange({0, 26}, {99999, 26})))
+    });
+    tester.runTest("Unknown function", {
+        "MEDIAN(A1:A3)", LexemType::AGGREGATE
+    });
+    tester.runTest("Aggregate without argument", {
+        "SUM()", LexemType::AGGREGATE
+    });
+    tester.runTest("Aggregate with ill-formed range", {
+        "SUM(A1:)", LexemType::AGGREGATE
+    });
+    tester.runTest("Aggregate with two separators", {
+        "SUM(A1:A2:A3)", LexemType::AGGREGATE
+    });
+    tester.runTest("Aggregate without closing parenthesis", {
+        "SUM(A1:A3", LexemType::AGGREGATE
+    });
+    tester.runTest("Aggregate without name", {
+        "(A1:A3)", LexemType::AGGREGATE
+    });
+
     tester.runTest("Operation +", {
         "+", std::make_shared<LexemOperation>(Operation::ADD)
     });
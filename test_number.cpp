@@ -0,0 +1,120 @@
+#include <string>
+#include <limits>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "number.h"
+
+
+struct ParseNumberTest
+{
+    std::string raw_number;
+    Result<Number> number;
+    // Printed number, it is raw_number if empty
+    std::string printed_number;
+
+    ParseNumberTest(const std::string &raw_number_tmp, const Result<Number> &number_tmp, const std::string &printed_number_tmp = "")
+        : raw_number(raw_number_tmp), number(number_tmp), printed_number(printed_number_tmp) {}
+};
+
+
+// Numbers which are parsed are printed back
+class UTParseNumber : public UnitTester<ParseNumberTest>
+{
+public:
+    UTParseNumber(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const ParseNumberTest &test) const {
+        Result<Number> number = tryParseNumber(test.raw_number);
+        if (!test.number.isOk()) {
+            return !number.isOk() && number.getError().code == test.number.getError().code;
+        }
+        return
+            number.isOk() && number.getValue() == test.number.getValue()
+            && formatNumber(number.getValue()) == (test.printed_number.empty() ? test.raw_number : test.printed_number);
+    }
+};
+
+
+struct ApplyOperationTest
+{
+    Result<Number> (*operation)(Number, Number);
+    Number left_operand;
+    Number right_operand;
+    Result<Number> result;
+
+    ApplyOperationTest(
+        Result<Number> (*operation_tmp)(Number, Number), Number left_operand_tmp, Number right_operand_tmp,
+        const Result<Number> &result_tmp
+    ) : operation(operation_tmp), left_operand(left_operand_tmp), right_operand(right_operand_tmp), result(result_tmp) {}
+};
+
+
+class UTApplyOperation : public UnitTester<ApplyOperationTest>
+{
+public:
+    UTApplyOperation(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const ApplyOperationTest &test) const {
+        Result<Number> result = test.operation(test.left_operand, test.right_operand);
+        if (!test.result.isOk()) {
+            return !result.isOk() && result.getError().code == test.result.getError().code;
+        }
+        return result.isOk() && result.getValue() == test.result.getValue();
+    }
+};
+
+
+int main()
+{
+    const Number max_number = std::numeric_limits<Number>::max();
+    const Number min_number = std::numeric_limits<Number>::min();
+    const Error overflow(ErrorCode::ARITHMETIC_OVERFLOW);
+
+    UTParseNumber parse_tester("tryParseNumber");
+
+    parse_tester.runTest("Zero", {"0", makeNumber(0)});
+    parse_tester.runTest("Leading zeros", {"00054", makeNumber(54), "54"});
+    parse_tester.runTest("Empty string", {"", Error(ErrorCode::NOT_A_NUMBER)});
+    parse_tester.runTest("Sign", {"-5", Error(ErrorCode::NOT_A_NUMBER)});
+    parse_tester.runTest("Letter", {"12a", Error(ErrorCode::NOT_A_NUMBER)});
+    parse_tester.runTest("Many leading zeros", {"000000000000000000000000001", makeNumber(1), "1"});
+#ifdef DECIMAL_NUMBERS
+    parse_tester.runTest("Fraction", {"12.5", 125000});
+    parse_tester.runTest("Fraction of all digits", {"0.0001", 1});
+    parse_tester.runTest("Trailing zeros of fraction", {"3.1400", 31400, "3.14"});
+    parse_tester.runTest("Too many fraction digits", {"0.00001", Error(ErrorCode::NOT_A_NUMBER)});
+    parse_tester.runTest("Point without fraction", {"1.", Error(ErrorCode::NOT_A_NUMBER)});
+    parse_tester.runTest("Largest number", {"922337203685477.5807", max_number});
+    parse_tester.runTest("Too large fraction", {"922337203685477.5808", Error(ErrorCode::NUMBER_TOO_LARGE)});
+    parse_tester.runTest("Too large number", {"922337203685478", Error(ErrorCode::NUMBER_TOO_LARGE)});
+#else
+    parse_tester.runTest("Fraction", {"3.14", Error(ErrorCode::NOT_A_NUMBER)});
+    parse_tester.runTest("Largest number", {"9223372036854775807", max_number});
+    parse_tester.runTest("Too large number", {"9223372036854775808", Error(ErrorCode::NUMBER_TOO_LARGE)});
+    parse_tester.runTest("Much too large number", {"100000000000000000000000", Error(ErrorCode::NUMBER_TOO_LARGE)});
+#endif
+
+    UTApplyOperation operation_tester("Operations on numbers");
+
+    operation_tester.runTest("Sum", {tryAddNumbers, makeNumber(2), makeNumber(3), makeNumber(5)});
+    operation_tester.runTest("Largest sum", {tryAddNumbers, max_number - 1, 1, max_number});
+    operation_tester.runTest("Overflow of sum", {tryAddNumbers, max_number, 1, overflow});
+    operation_tester.runTest("Overflow of negative sum", {tryAddNumbers, min_number, -1, overflow});
+    operation_tester.runTest("Difference", {trySubtractNumbers, makeNumber(2), makeNumber(3), makeNumber(-1)});
+    operation_tester.runTest("Overflow of difference", {trySubtractNumbers, makeNumber(0), min_number, overflow});
+    operation_tester.runTest("Product", {tryMultiplyNumbers, makeNumber(-6), makeNumber(7), makeNumber(-42)});
+    operation_tester.runTest("Overflow of product", {tryMultiplyNumbers, max_number / 2 + 1, makeNumber(2), overflow});
+    operation_tester.runTest("Quotient", {tryDivideNumbers, makeNumber(42), makeNumber(-6), makeNumber(-7)});
+    operation_tester.runTest("Division by zero", {tryDivideNumbers, makeNumber(1), 0, Error(ErrorCode::DIVISION_BY_ZERO)});
+    operation_tester.runTest("Overflow of quotient", {tryDivideNumbers, min_number, makeNumber(-1), overflow});
+#ifdef DECIMAL_NUMBERS
+    operation_tester.runTest("Fractional product", {tryMultiplyNumbers, 15000, 15000, 22500});
+    operation_tester.runTest("Truncated product", {tryMultiplyNumbers, 1, 1, 0});
+    operation_tester.runTest("Fractional quotient", {tryDivideNumbers, makeNumber(1), makeNumber(3), 3333});
+#else
+    operation_tester.runTest("Quotient is truncated", {tryDivideNumbers, 7, -2, -3});
+#endif
+
+    return 0;
+}
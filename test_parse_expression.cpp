@@ -1,4 +1,5 @@
 #include <memory>
+#include <vector>
 
 #include "unit_test.h"
 #include "unit_test.cpp"
@@ -22,6 +23,16 @@ struct ParseExpressionTest
 };
 
 
+// Arithmetic expression with tokens in given, i.e. postfix, order
+Expression makePostfixExpression(const std::vector<Token> &tokens) {
+    Expression expression(ExpressionType::ARITHMETIC);
+    for (const auto &token : tokens) {
+        expression.pushToken(token);
+    }
+    return expression;
+}
+
+
 class UTParseExpression : public UnitTester<ParseExpressionTest>
 {
 public:
@@ -134,68 +145,154 @@ int main()
         }
     });
 
-    tester.runTest("Simple expression with error, but valid before calculation", {
-        "=-9-13", {
+    tester.runTest("Expression with long and absolute references", {
+        "=AA100*$B$2+xfd1048576", {
             ExpressionType::ARITHMETIC,
             LexemVector{
-                std::make_shared<LexemOperation>(Operation::SUBTRACT),
-                std::make_shared<LexemNumber>(9),
-                std::make_shared<LexemOperation>(Operation::SUBTRACT),
-                std::make_shared<LexemNumber>(13),
+                std::make_shared<LexemCellReference>(Coordinate2D(99, 26)),
+                std::make_shared<LexemOperation>(Operation::MULTIPLY),
+                std::make_shared<LexemCellReference>(Coordinate2D(1, 1)),
+                std::make_shared<LexemOperation>(Operation::ADD),
+                std::make_shared<LexemCellReference>(Coordinate2D(1048575, 16383)),
             }
         }
     });
-    tester.runTest("Simple expression with error, but valid before calculation", {
-        "=+9-13", {
+
+    tester.runTest("Expression with aggregates", {
+        "=SUM(A1:A3)*2+max(B1:C2)", {
             ExpressionType::ARITHMETIC,
             LexemVector{
+                std::make_shared<LexemAggregate>(AggregateCall(Aggregate::SUM, CellRange({0, 0}, {2, 0}))),
+                std::make_shared<LexemOperation>(Operation::MULTIPLY),
+                std::make_shared<LexemNumber>(2),
                 std::make_shared<LexemOperation>(Operation::ADD),
-                std::make_shared<LexemNumber>(9),
-                std::make_shared<LexemOperation>(Operation::SUBTRACT),
-                std::make_shared<LexemNumber>(13),
+                std::make_shared<LexemAggregate>(AggregateCall(Aggregate::MAX, CellRange({0, 1}, {1, 2}))),
             }
         }
     });
+    tester.runTest("Aggregate without closing parenthesis", {
+        "=1+SUM(A1:A3"
+    });
+    tester.runTest("Unknown function", {
+        "=FOO(A1:A3)"
+    });
+    tester.runTest("Range outside of aggregate", {
+        "=A1:A3"
+    });
+
+    tester.runTest("Expression starting with operation", {
+        "=-9-13"
+    });
+    tester.runTest("Expression starting with operation", {
+        "=+9-13"
+    });
     tester.runTest("Simple expression with excess space", {
         "= 9-13"
     });
-    tester.runTest("Simple expression with error, but valid before calculation", {
-        "=9--13", {
-            ExpressionType::ARITHMETIC,
-            LexemVector{
-                std::make_shared<LexemNumber>(9),
-                std::make_shared<LexemOperation>(Operation::SUBTRACT),
-                std::make_shared<LexemOperation>(Operation::SUBTRACT),
-                std::make_shared<LexemNumber>(13),
-            }
-        }
+    tester.runTest("Two operations in a row", {
+        "=9--13"
+    });
+    tester.runTest("Two operations in a row", {
+        "=9-+13"
+    });
+    tester.runTest("Operations only", {
+        "=++/-*+"
+    });
+    tester.runTest("Operation in the end", {
+        "=9-13*"
     });
-    tester.runTest("Simple expression with error, but valid before calculation", {
-        "=9-+13", {
+    tester.runTest("Empty formula", {
+        "="
+    });
+    tester.runTest("Simple expression with error", {
+        "=A1A1"
+    });
+    tester.runTest("Simple expression with misplaced $", {
+        "=A1+1$"
+    });
+
+    tester.runTest("Multiplication before addition", {
+        "=A1+B1*C1", makePostfixExpression({
+            Token(Coordinate2D(0, 0)), Token(Coordinate2D(0, 1)), Token(Coordinate2D(0, 2)),
+            Token(Operation::MULTIPLY), Token(Operation::ADD)
+        })
+    });
+    tester.runTest("Left to right for the same precedence", {
+        "=A1-A2+A3/A4*A5", makePostfixExpression({
+            Token(Coordinate2D(0, 0)), Token(Coordinate2D(1, 0)), Token(Operation::SUBTRACT),
+            Token(Coordinate2D(2, 0)), Token(Coordinate2D(3, 0)), Token(Operation::DIVIDE),
+            Token(Coordinate2D(4, 0)), Token(Operation::MULTIPLY),
+            Token(Operation::ADD)
+        })
+    });
+    tester.runTest("Constant formula is folded", {
+        "=1+2*3/4-5+100", {
             ExpressionType::ARITHMETIC,
-            LexemVector{
-                std::make_shared<LexemNumber>(9),
-                std::make_shared<LexemOperation>(Operation::SUBTRACT),
-                std::make_shared<LexemOperation>(Operation::ADD),
-                std::make_shared<LexemNumber>(13),
-            }
+            LexemVector{std::make_shared<LexemNumber>(97)}
         }
     });
-    tester.runTest("Simple expression with error, but valid before calculation", {
-        "=++/-*+", {
+    tester.runTest("Constant parts of formula are folded", {
+        "=A1*(2+3)-6/3", makePostfixExpression({
+            Token(Coordinate2D(0, 0)), Token(5), Token(Operation::MULTIPLY), Token(2), Token(Operation::SUBTRACT)
+        })
+    });
+    tester.runTest("Operations with references are not folded", {
+        "=A1+2+3", makePostfixExpression({
+            Token(Coordinate2D(0, 0)), Token(2), Token(Operation::ADD), Token(3), Token(Operation::ADD)
+        })
+    });
+    tester.runTest("Division by zero is not folded", {
+        "=1+4/0", makePostfixExpression({
+            Token(1), Token(4), Token(0), Token(Operation::DIVIDE), Token(Operation::ADD)
+        })
+    });
+    tester.runTest("Overflow is not folded", {
+        "=9223372036854775807+1", makePostfixExpression({
+            Token(9223372036854775807), Token(1), Token(Operation::ADD)
+        })
+    });
+    tester.runTest("64-bit numbers", {
+        "=3000000000*3000000000", makePostfixExpression({Token(9000000000000000000)})
+    });
+    tester.runTest("Too large number", {
+        "=9223372036854775808+1"
+    });
+    tester.runTest("Parentheses", {
+        "=(A1+2)*(3-SUM(B1:B2))", makePostfixExpression({
+            Token(Coordinate2D(0, 0)), Token(2), Token(Operation::ADD),
+            Token(3), Token(AggregateCall(Aggregate::SUM, CellRange({0, 1}, {1, 1}))), Token(Operation::SUBTRACT),
+            Token(Operation::MULTIPLY)
+        })
+    });
+    tester.runTest("Nested parentheses", {
+        "=((7))", makePostfixExpression({Token(7)})
+    });
+    tester.runTest("Infix lexems are compiled", {
+        "=2+3*4", {
             ExpressionType::ARITHMETIC,
             LexemVector{
+                std::make_shared<LexemNumber>(2),
                 std::make_shared<LexemOperation>(Operation::ADD),
-                std::make_shared<LexemOperation>(Operation::ADD),
-                std::make_shared<LexemOperation>(Operation::DIVIDE),
-                std::make_shared<LexemOperation>(Operation::SUBTRACT),
+                std::make_shared<LexemNumber>(3),
                 std::make_shared<LexemOperation>(Operation::MULTIPLY),
-                std::make_shared<LexemOperation>(Operation::ADD),
+                std::make_shared<LexemNumber>(4),
             }
         }
     });
-    tester.runTest("Simple expression with error", {
-        "=A1A1"
+    tester.runTest("Unclosed parenthesis", {
+        "=(1+2"
+    });
+    tester.runTest("Unopened parenthesis", {
+        "=1+2)"
+    });
+    tester.runTest("Empty parentheses", {
+        "=()"
+    });
+    tester.runTest("Operation before closing parenthesis", {
+        "=(1+)"
+    });
+    tester.runTest("Operand before opening parenthesis", {
+        "=2(3)"
     });
 
     return 0;
@@ -0,0 +1,112 @@
+#include <vector>
+#include <sstream>
+#include <string>
+#include <limits>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "coordinate.h"
+#include "expression.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "output_buffer.h"
+
+
+using ExpressionTableEntry = ExpressionTable::Entry;
+
+
+struct PrintTableTest
+{
+    int height;
+    int width;
+    std::vector<ExpressionTableEntry> entries;
+    std::string printed_table;
+
+    PrintTableTest(
+        int height_tmp, int width_tmp,
+        const std::vector<ExpressionTableEntry> &entries_tmp,
+        const std::string &printed_table_tmp
+    ) : height(height_tmp), width(width_tmp), entries(entries_tmp), printed_table(printed_table_tmp) {}
+};
+
+
+// Streamed output should be the same as printed table made by makePrintedTable
+class UTPrintExpressionTable : public UnitTester<PrintTableTest>
+{
+public:
+    UTPrintExpressionTable(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const PrintTableTest &test) const {
+
+        auto table = makeSparseTable(test.height, test.width, test.entries.begin(), test.entries.end());
+
+        std::ostringstream streamed_output;
+        {
+            // Small buffer, so it is flushed in the middle of output
+            OutputBuffer output(streamed_output, 4);
+            printExpressionTable(table, output);
+        }
+
+        std::ostringstream printed_output;
+        printTextTable(makePrintedTable(table), printed_output);
+
+        return streamed_output.str() == test.printed_table && printed_output.str() == test.printed_table;
+
+    }
+};
+
+
+int main()
+{
+    UTPrintExpressionTable tester("printExpressionTable");
+
+    tester.runTest("Empty table",
+        {0, 0, {}, ""}
+    );
+
+    tester.runTest("3x3 without cells",
+        {3, 3, {}, "\t\t\n\t\t\n\t\t\n"}
+    );
+
+    tester.runTest("2x3 with values of all types",
+        {
+            2, 3,
+            {
+                {{0, 0}, parseExpression("'Text")},
+                {{0, 2}, parseExpression("-5")},
+                {{1, 1}, parseExpression("1234567")},
+                {{1, 2}, parseExpression("=A1+2")},
+            },
+            "Text\t\t#'-5' is not a non-negative integer number\n\t1234567\t#Illegal expression\n"
+        }
+    );
+
+    Expression negative_number(ExpressionType::ARITHMETIC);
+    negative_number.pushToken(-1203);
+    Expression min_number(ExpressionType::ARITHMETIC);
+    min_number.pushToken(std::numeric_limits<int>::min());
+    tester.runTest("Negative numbers and empty rows",
+        {
+            4, 2,
+            {
+                {{1, 0}, negative_number},
+                {{1, 1}, min_number},
+                {{3, 1}, parseExpression("0")},
+            },
+            "\t\n-1203\t-2147483648\n\t\n\t0\n"
+        }
+    );
+
+    tester.runTest("Cell longer than buffer",
+        {
+            1, 2,
+            {
+                {{0, 1}, parseExpression("'Long text")},
+            },
+            "\tLong text\n"
+        }
+    );
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <vector>
 #include <sstream>
+#include <memory>
 
 #include "unit_test.h"
 #include "unit_test.cpp"
@@ -7,6 +8,9 @@
 #include "sparse_table.h"
 #include "sparse_table.cpp"
 #include "expression_table.h"
+#include "input_buffer.h"
+#include "thread_pool.h"
+#include "sheet_generator.h"
 
 
 using TextTableEntry = SparseTable<std::string>::Entry;
@@ -50,6 +54,49 @@ public:
 };
 
 
+struct ReadParsedTableTest
+{
+    std::string raw_input;
+    int thread_count;
+
+    ReadParsedTableTest(const std::string &raw_input_tmp, int thread_count_tmp)
+        : raw_input(raw_input_tmp), thread_count(thread_count_tmp) {}
+};
+
+
+// Concurrently parsed table should be the same as parsed by one thread cell by cell;
+// it should have its own pools, freed with the last copy of table
+class UTReadParsedTable : public UnitTester<ReadParsedTableTest>
+{
+public:
+    UTReadParsedTable(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const ReadParsedTableTest &test) const {
+
+        std::stringstream raw_stream(test.raw_input);
+        auto expected = parseRawTable(readTextTable(raw_stream));
+
+        std::weak_ptr<CellPools> weak_pools;
+        {
+            std::stringstream in_stream(test.raw_input);
+            InputBuffer input(in_stream);
+            ThreadPool thread_pool(test.thread_count);
+            auto got = readParsedTable(input, thread_pool);
+            ExpressionTable copied = got;
+            weak_pools = got.getPools();
+            if (
+                !(got == expected) || got.getElementCount() != expected.getElementCount()
+                || !got.getPools() || got.getPools() == expected.getPools() || copied.getPools() != got.getPools()
+            ) {
+                return false;
+            }
+        }
+        return weak_pools.expired();
+
+    }
+};
+
+
 int main()
 {
     UTReadTextTable tester("readTextTable");
@@ -109,6 +156,29 @@ int main()
         }}
     );
 
+    tester.runTest("2x2, with CR line endings",
+        {"2\t2\r1\t2\r\r\n3\r", 2, 2, {
+            {{0, 0}, "1"},
+            {{0, 1}, "2"},
+        }}
+    );
+    tester.runTest("2x2, cells longer than delimiter search block",
+        {"2\t2\n=A1+B1+A2+A2+A2+A2+A2+A2\t'Long text cell of the table\nshort\tCell ending at the end of input", 2, 2, {
+            {{0, 0}, "=A1+B1+A2+A2+A2+A2+A2+A2"},
+            {{0, 1}, "'Long text cell of the table"},
+            {{1, 0}, "short"},
+            {{1, 1}, "Cell ending at the end of input"},
+        }}
+    );
+    tester.runTest("2x3, excess cells and header",
+        {" +2 3 excess\n1\t2\t3\t4\t5\n\t\t6\t7\n", 2, 3, {
+            {{0, 0}, "1"},
+            {{0, 1}, "2"},
+            {{0, 2}, "3"},
+            {{1, 2}, "6"},
+        }}
+    );
+
     tester.runTest("Negative height",
         {"-5\t8\n"}
     );
@@ -130,6 +200,27 @@ int main()
     tester.runTest("Trash",
         {"d9fsdu9f"}
     );
+    tester.runTest("Too large height",
+        {"99999999999\t1\n"}
+    );
+
+    UTReadParsedTable parsed_tester("readParsedTable");
+
+    parsed_tester.runTest("Generated 50x40 on 1 thread",
+        {generateRawSheet(50, 40), 1}
+    );
+    parsed_tester.runTest("Generated 50x40 on 4 threads",
+        {generateRawSheet(50, 40), 4}
+    );
+    parsed_tester.runTest("Generated 3x2 on 4 threads",
+        {generateRawSheet(3, 2, 7), 4}
+    );
+    parsed_tester.runTest("Truncated rows on 4 threads",
+        {"4\t3\n1\t=A1+1\t'Text\n\t\t=A1+B1\n=x", 4}
+    );
+    parsed_tester.runTest("0x0 on 4 threads",
+        {"0\t0\n", 4}
+    );
 
     return 0;
 }
@@ -0,0 +1,417 @@
+#include <vector>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+#include <memory>
+
+#include <unistd.h>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "coordinate.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "thread_pool.h"
+#include "sheet_engine.h"
+#include "sheet_server.h"
+#include "string_pool.h"
+#include "formula_pool.h"
+
+
+using TextTableEntry = SparseTable<std::string>::Entry;
+
+
+// Printed values of sheet calculated at once, or message of its error
+std::string makeExpectedOutput(const std::string &raw_input, bool &is_ok) {
+    std::ostringstream out_stream;
+    try {
+        std::stringstream in_stream(raw_input);
+        InputBuffer input(in_stream);
+        ThreadPool thread_pool(1);
+        auto table = readParsedTable(input, thread_pool);
+        calculateParsedTable(table, thread_pool);
+        OutputBuffer output(out_stream);
+        printExpressionTable(table, output);
+    } catch (const std::exception &exception) {
+        is_ok = false;
+        return exception.what();
+    }
+    is_ok = true;
+    return out_stream.str();
+}
+
+
+struct SheetEngineTest
+{
+    std::string raw_input;
+    std::vector<TextTableEntry> edits;
+    std::string printed_table;
+
+    SheetEngineTest(
+        const std::string &raw_input_tmp, const std::vector<TextTableEntry> &edits_tmp, const std::string &printed_table_tmp
+    ) : raw_input(raw_input_tmp), edits(edits_tmp), printed_table(printed_table_tmp) {}
+};
+
+
+// Engine loaded from text should print its values after edits the same as process_table prints edited sheet
+class UTSheetEngine : public UnitTester<SheetEngineTest>
+{
+public:
+    UTSheetEngine(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const SheetEngineTest &test) const {
+
+        SheetEngine engine(2);
+        InputBuffer input(StringRef(test.raw_input));
+        engine.load(input);
+        engine.evaluate();
+        for (const auto &edit : test.edits) {
+            engine.setCell(edit.coordinate, edit.value);
+        }
+
+        std::ostringstream out_stream;
+        {
+            OutputBuffer output(out_stream);
+            engine.print(output);
+        }
+        return out_stream.str() == test.printed_table;
+
+    }
+};
+
+
+struct SheetEngineErrorTest
+{
+    std::string raw_input;
+    bool is_evaluated;
+    Coordinate2D coordinate;
+    // Expected exception: "out_of_range" or "logic_error"
+    std::string error_name;
+
+    SheetEngineErrorTest(
+        const std::string &raw_input_tmp, bool is_evaluated_tmp, const Coordinate2D &coordinate_tmp,
+        const std::string &error_name_tmp
+    ) : raw_input(raw_input_tmp), is_evaluated(is_evaluated_tmp), coordinate(coordinate_tmp), error_name(error_name_tmp) {}
+};
+
+
+// Query of cell should throw exception of expected type
+class UTSheetEngineErrors : public UnitTester<SheetEngineErrorTest>
+{
+public:
+    UTSheetEngineErrors(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const SheetEngineErrorTest &test) const {
+
+        SheetEngine engine;
+        InputBuffer input(StringRef(test.raw_input));
+        engine.load(input);
+        if (test.is_evaluated) {
+            engine.evaluate();
+        }
+
+        try {
+            engine.getValue(test.coordinate);
+        } catch (const std::out_of_range &) {
+            return test.error_name == "out_of_range";
+        } catch (const std::logic_error &) {
+            return test.error_name == "logic_error";
+        }
+        return test.error_name.empty();
+
+    }
+};
+
+
+struct SheetEnginePoolsTest
+{
+    std::string raw_input;
+    std::vector<TextTableEntry> edits;
+};
+
+
+// Cells and messages of errors of loaded sheet should be interned into its own pools rather than into pools
+// of the whole run of program, and pools should be freed when the next sheet is loaded
+class UTSheetEnginePools : public UnitTester<SheetEnginePoolsTest>
+{
+public:
+    UTSheetEnginePools(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const SheetEnginePoolsTest &test) const {
+
+        int program_string_count = StringPool::getCurrent().getStringCount();
+        int program_formula_count = FormulaPool::getCurrent().getFormulaCount();
+
+        SheetEngine engine(4);
+        InputBuffer input(StringRef(test.raw_input));
+        engine.load(input);
+        engine.evaluate();
+        for (const auto &edit : test.edits) {
+            engine.setCell(edit.coordinate, edit.value);
+        }
+        std::weak_ptr<CellPools> weak_pools = engine.getPools();
+        if (!engine.getPools() || engine.getPools()->strings.getStringCount() == 0) {
+            return false;
+        }
+
+        InputBuffer next_input(StringRef("1 1\n1\n"));
+        engine.load(next_input);
+        return
+            weak_pools.expired() && StringPool::getCurrent().getStringCount() == program_string_count
+            && FormulaPool::getCurrent().getFormulaCount() == program_formula_count;
+
+    }
+};
+
+
+struct ServeRequestsTest
+{
+    std::vector<std::string> raw_inputs;
+    int thread_count;
+
+    ServeRequestsTest(const std::vector<std::string> &raw_inputs_tmp, int thread_count_tmp = 1)
+        : raw_inputs(raw_inputs_tmp), thread_count(thread_count_tmp) {}
+};
+
+
+// Every framed response should have printed values of its sheet, or its error, and the same length as in header
+class UTServeRequests : public UnitTester<ServeRequestsTest>
+{
+    // Reads response from the beginning of response text, returns false if it does not match
+    static bool readResponse(const std::string &raw_input, const std::string &responses, size_t &position) {
+        bool is_ok = true;
+        std::string expected_body = makeExpectedOutput(raw_input, is_ok);
+        std::string expected_prefix = std::string(is_ok ? "OK " : "ERROR ") + std::to_string(expected_body.size()) + " ";
+        if (responses.compare(position, expected_prefix.size(), expected_prefix) != 0) {
+            return false;
+        }
+        position += expected_prefix.size();
+
+        size_t line_end = responses.find('\n', position);
+        if (line_end == std::string::npos || line_end == position
+                || responses.find_first_not_of("0123456789", position) != line_end) {
+            return false;
+        }
+        position = line_end + 1;
+        if (responses.compare(position, expected_body.size(), expected_body) != 0) {
+            return false;
+        }
+        position += expected_body.size();
+        return true;
+    }
+public:
+    UTServeRequests(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const ServeRequestsTest &test) const {
+
+        // Files rather than pipes, so neither side waits for the other one
+        FILE *request_file = std::tmpfile();
+        FILE *response_file = std::tmpfile();
+        for (const auto &raw_input : test.raw_inputs) {
+            std::fprintf(request_file, "%zu\n", raw_input.size());
+            std::fwrite(raw_input.data(), 1, raw_input.size(), request_file);
+        }
+        std::fflush(request_file);
+        std::rewind(request_file);
+
+        SheetEngine engine(test.thread_count);
+        int request_count = serveRequests(engine, fileno(request_file), fileno(response_file));
+
+        std::string responses;
+        std::rewind(response_file);
+        char chunk[4096];
+        size_t chunk_size;
+        while ((chunk_size = std::fread(chunk, 1, sizeof(chunk), response_file)) > 0) {
+            responses.append(chunk, chunk_size);
+        }
+        std::fclose(request_file);
+        std::fclose(response_file);
+
+        size_t position = 0;
+        for (const auto &raw_input : test.raw_inputs) {
+            if (!readResponse(raw_input, responses, position)) {
+                return false;
+            }
+        }
+        return request_count == static_cast<int>(test.raw_inputs.size()) && position == responses.size();
+
+    }
+};
+
+
+struct ServeFramesTest
+{
+    // Requests with their headers
+    std::string raw_requests;
+    size_t max_request_size;
+    // Expected responses: "OK" or "ERROR" followed by the beginning of body
+    std::vector<std::string> responses;
+};
+
+
+// Malformed and too long requests should be answered with errors rather than stop serving by exception
+class UTServeFrames : public UnitTester<ServeFramesTest>
+{
+public:
+    UTServeFrames(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const ServeFramesTest &test) const {
+
+        FILE *request_file = std::tmpfile();
+        FILE *response_file = std::tmpfile();
+        std::fwrite(test.raw_requests.data(), 1, test.raw_requests.size(), request_file);
+        std::fflush(request_file);
+        std::rewind(request_file);
+
+        SheetEngine engine;
+        int request_count = 0;
+        try {
+            request_count = serveRequests(engine, fileno(request_file), fileno(response_file), test.max_request_size);
+        } catch (const std::exception &) {
+            request_count = -1;
+        }
+
+        std::string responses;
+        std::rewind(response_file);
+        char chunk[4096];
+        size_t chunk_size;
+        while ((chunk_size = std::fread(chunk, 1, sizeof(chunk), response_file)) > 0) {
+            responses.append(chunk, chunk_size);
+        }
+        std::fclose(request_file);
+        std::fclose(response_file);
+
+        std::istringstream response_stream(responses);
+        for (const auto &expected : test.responses) {
+            std::string status;
+            size_t body_size;
+            long long latency;
+            if (!(response_stream >> status >> body_size >> latency) || response_stream.get() != '\n') {
+                return false;
+            }
+            std::string body(body_size, '\0');
+            response_stream.read(&body[0], static_cast<std::streamsize>(body_size));
+            if (expected.compare(0, status.size() + 1, status + " ") != 0 || body.compare(0, expected.size() - status.size() - 1, expected, status.size() + 1) != 0) {
+                return false;
+            }
+        }
+        return request_count == static_cast<int>(test.responses.size()) && response_stream.peek() == EOF;
+
+    }
+};
+
+
+int main()
+{
+    UTSheetEngine tester("SheetEngine");
+
+    tester.runTest("Evaluated sheet",
+        {
+            "2 2\n"
+            "1\t=A1*2\n"
+            "'Text\t=B1+A1\n",
+            {},
+            "1\t2\n"
+            "Text\t3\n"
+        }
+    );
+
+    tester.runTest("Edit recalculates dependent cells",
+        {
+            "2 2\n"
+            "1\t=A1*2\n"
+            "'Text\t=B1+A1\n",
+            {
+                {{0, 0}, "5"},
+                {{1, 0}, "=B2"},
+            },
+            "5\t10\n"
+            "15\t15\n"
+        }
+    );
+
+    tester.runTest("Edit makes cycle",
+        {
+            "2 2\n"
+            "1\t=A1*2\n"
+            "'Text\t=B1+A1\n",
+            {
+                {{1, 0}, "=B2"},
+                {{1, 1}, "=A2"},
+            },
+            "1\t2\n"
+            "#Infinite cycle in references\t#Infinite cycle in references\n"
+        }
+    );
+
+    UTSheetEngineErrors error_tester("SheetEngine errors");
+
+    error_tester.runTest("Cell of evaluated sheet", {"1 2\n1\t=A1\n", true, {0, 1}, ""});
+    error_tester.runTest("Row out of sheet", {"1 2\n1\t=A1\n", true, {1, 0}, "out_of_range"});
+    error_tester.runTest("Column out of sheet", {"1 2\n1\t=A1\n", true, {0, 2}, "out_of_range"});
+    error_tester.runTest("Sheet is not evaluated", {"1 2\n1\t=A1\n", false, {0, 0}, "logic_error"});
+
+    UTServeRequests serve_tester("serveRequests");
+
+    serve_tester.runTest("No requests", {{}});
+    serve_tester.runTest("One sheet", {{"2 1\n3\n=A1+4\n"}});
+    serve_tester.runTest("Sheets one after another",
+        {
+            {
+                "2 2\n1\t=A1*2\n'Text\t=B1+A1\n",
+                "1 3\n=B1\t=A1\t7\n",
+                "3 1\n=A2\n=A3\n=SUM(A1:A2)\n",
+            },
+            2
+        }
+    );
+    serve_tester.runTest("Malformed sheet between correct ones",
+        {
+            {
+                "1 1\n5\n",
+                "height width\n",
+                "1 1\n=6*7\n",
+            }
+        }
+    );
+    serve_tester.runTest("Empty request", {{"", "1 1\n1\n"}});
+
+    // Buffer grows beyond initial 64 KiB for the first request and shrinks back for the next ones
+    std::string long_column_sheet = "40000 1\n=1+2\n";
+    for (int row = 1; row < 40000; ++row) {
+        long_column_sheet += "=A" + std::to_string(row) + "\n";
+    }
+    serve_tester.runTest("Request longer than buffer", {{long_column_sheet, "1 1\n=6*7\n", "2 1\n1\n=A1+1\n"}});
+
+    UTSheetEnginePools pools_tester("SheetEngine pools");
+
+    pools_tester.runTest("Texts, formulas and errors",
+        {"3 2\n'Text\t=A3+B3\n=B7*2\t=A1+1\n2\t=SUM(A1:B9)\n", {}}
+    );
+    pools_tester.runTest("Edited sheet",
+        {"2 2\n1\t=A1*2\n'Text\t=B1+A1\n", {{{0, 0}, "'Edited"}, {{1, 0}, "=C1"}}}
+    );
+
+    UTServeFrames frames_tester("serveRequests framing");
+
+    frames_tester.runTest("Too long request is skipped",
+        {"9\n1 1\n=1+2\n31\n2 2\n1\t2\n3\t4\n5\t6\n7\t8\n9\t10\n11\t12\n9\n1 1\n=3*4\n", 20,
+         {"OK 3\n", "ERROR Request should not be longer than 20 bytes", "OK 12\n"}}
+    );
+    frames_tester.runTest("Malformed header stops serving",
+        {"9\n1 1\n=1+2\nabc\n9\n1 1\n=3*4\n", MAX_REQUEST_SIZE,
+         {"OK 3\n", "ERROR Request header should be length of request"}}
+    );
+    frames_tester.runTest("Too large length",
+        {"99999999999\n1 1\n1\n", MAX_REQUEST_SIZE, {"ERROR Request header should be length of request"}}
+    );
+    frames_tester.runTest("Too long header",
+        {std::string(100, '1'), MAX_REQUEST_SIZE, {"ERROR Request header should not be longer than"}}
+    );
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "coordinate.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "workbook.h"
+#include "snapshot.h"
+
+
+using TextTableEntry = SparseTable<std::string>::Entry;
+
+
+struct SnapshotTest
+{
+    int height;
+    int width;
+    std::vector<TextTableEntry> entries;
+    // Edits of workbook restored from snapshot
+    std::vector<TextTableEntry> edits;
+    // Number of bytes cut from the end of snapshot, damaged snapshot should not be loaded
+    int truncated_size;
+
+    SnapshotTest(
+        int height_tmp, int width_tmp,
+        const std::vector<TextTableEntry> &entries_tmp,
+        const std::vector<TextTableEntry> &edits_tmp = {},
+        int truncated_size_tmp = 0
+    ) : height(height_tmp), width(width_tmp), entries(entries_tmp), edits(edits_tmp), truncated_size(truncated_size_tmp) {}
+};
+
+
+// Tables restored from snapshot should be equal to saved ones,
+// and workbook made of them should be edited as workbook calculated from scratch
+class UTSnapshot : public UnitTester<SnapshotTest>
+{
+public:
+    UTSnapshot(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const SnapshotTest &test) const {
+
+        auto raw_table = makeSparseTable(test.height, test.width, test.entries.begin(), test.entries.end());
+        auto formulas = parseRawTable(raw_table);
+        auto values = formulas;
+        calculateParsedTable(values);
+
+        std::ostringstream out_stream;
+        {
+            OutputBuffer output(out_stream);
+            saveSnapshot(formulas, values, output);
+        }
+        std::string saved_snapshot = out_stream.str();
+        saved_snapshot.resize(saved_snapshot.size() - static_cast<size_t>(test.truncated_size));
+        std::istringstream in_stream(saved_snapshot);
+        InputBuffer input(in_stream);
+
+        if (test.truncated_size > 0) {
+            try {
+                loadSnapshot(input);
+            } catch (const std::runtime_error&) {
+                return true;
+            }
+            return false;
+        }
+
+        auto snapshot = loadSnapshot(input);
+        if (!(snapshot.formulas == formulas) || !(snapshot.values == values)) {
+            return false;
+        }
+
+        Workbook restored_workbook(snapshot.formulas, snapshot.values);
+        Workbook calculated_workbook(formulas);
+        for (const auto &edit : test.edits) {
+            restored_workbook.setCell(edit.coordinate, edit.value);
+            calculated_workbook.setCell(edit.coordinate, edit.value);
+        }
+        return makePrintedTable(restored_workbook.getValues()) == makePrintedTable(calculated_workbook.getValues());
+
+    }
+};
+
+
+int main()
+{
+    UTSnapshot tester("Snapshot");
+
+    tester.runTest("Empty table",
+        {0, 0, {}}
+    );
+    tester.runTest("Cells of all kinds",
+        {
+            3, 3,
+            {
+                {{0, 0}, "1"},
+                {{0, 1}, "'label"},
+                {{0, 2}, "=A1+2*(B3-1)"},
+                {{1, 0}, "=A1/0"},
+                {{1, 1}, "=XX1"},
+                {{1, 2}, "=SUM(A1:A3)+MAX(C1:C1)"},
+                {{2, 0}, "=B1"},
+                {{2, 1}, "=1+2*3"},
+                {{2, 2}, "=C3+1"},
+            }
+        }
+    );
+    tester.runTest("Formulas copied along column and repeated labels",
+        {
+            4, 3,
+            {
+                {{0, 0}, "1"}, {{0, 1}, "=A1*2+1"}, {{0, 2}, "'same"},
+                {{1, 0}, "2"}, {{1, 1}, "=A2*2+1"}, {{1, 2}, "'same"},
+                {{2, 0}, "3"}, {{2, 1}, "=A3*2+1"}, {{2, 2}, "'same"},
+                {{3, 0}, "=SUM(B1:B3)"}, {{3, 1}, "=A4*2+1"},
+            }
+        }
+    );
+    tester.runTest("Edits of restored workbook",
+        {
+            3, 2,
+            {
+                {{0, 0}, "1"},
+                {{1, 0}, "=A1+1"},
+                {{2, 0}, "=A2*2"},
+                {{0, 1}, "=SUM(A1:A3)"},
+            }, {
+                {{0, 0}, "5"},
+                {{2, 1}, "=B1-A3"},
+                {{1, 0}, "=B1"},
+            }
+        }
+    );
+    tester.runTest("Truncated snapshot",
+        {2, 2, {{{0, 0}, "1"}, {{1, 1}, "=A1+1"}}, {}, 4}
+    );
+
+    return 0;
+}
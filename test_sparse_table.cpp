@@ -1,5 +1,9 @@
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <string>
+#include <cstdlib>
+#include <new>
 
 #include "unit_test.h"
 #include "unit_test.cpp"
@@ -8,6 +12,26 @@
 #include "sparse_table.cpp"
 
 
+// Global operator new is replaced to count allocations, so tests can check that reads never allocate
+static long long allocation_count = 0;
+
+void *operator new(std::size_t size) {
+    ++allocation_count;
+    if (void *pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+
 using SparseTableFlattenTestEntry = SparseTable<std::string>::Entry;
 
 
@@ -22,6 +46,7 @@ struct SparseTableFlattenTest
 };
 
 
+template <typename Table>
 class UTSparseTableFlatten : public UnitTester<SparseTableFlattenTest>
 {
 public:
@@ -31,7 +56,8 @@ public:
 
         std::unordered_map<Coordinate2D, std::string, Coordinate2DHash> value_map;
 
-        SparseTable<std::string> table(test.height, test.width);
+        Table table(test.height, test.width);
+        table.reserve(static_cast<int>(test.entries.size()));
         for (const auto &entry : test.entries) {
             table(entry.coordinate) = entry.value;
             value_map[entry.coordinate] = entry.value;
@@ -57,10 +83,140 @@ public:
 };
 
 
-int main()
+template <typename Table>
+class UTSparseTableElements : public UnitTester<SparseTableFlattenTest>
+{
+public:
+    UTSparseTableElements(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const SparseTableFlattenTest &test) const {
+
+        std::map<Coordinate2D, std::string> value_map;
+
+        Table table(test.height, test.width);
+        table.reserve(static_cast<int>(test.entries.size()));
+        for (const auto &entry : test.entries) {
+            table(entry.coordinate) = entry.value;
+            value_map[entry.coordinate] = entry.value;
+        }
+
+        if (table.getElementCount() != static_cast<int>(value_map.size())) {
+            return false;
+        }
+
+        auto expected_iterator = value_map.begin();
+        for (const auto &cell_pair : table.getElements()) {
+            if (expected_iterator == value_map.end()) {
+                return false;
+            }
+            if (!(cell_pair.first == expected_iterator->first) || cell_pair.second != expected_iterator->second) {
+                return false;
+            }
+            ++expected_iterator;
+        }
+
+        return expected_iterator == value_map.end();
+
+    }
+};
+
+
+// Reads every cell of the table through all read-only accessors
+template <typename Table>
+class UTSparseTableConstLookup : public UnitTester<SparseTableFlattenTest>
+{
+public:
+    UTSparseTableConstLookup(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const SparseTableFlattenTest &test) const {
+
+        std::map<Coordinate2D, std::string> value_map;
+
+        Table table(test.height, test.width);
+        table.reserve(static_cast<int>(test.entries.size()));
+        for (const auto &entry : test.entries) {
+            table(entry.coordinate) = entry.value;
+            value_map[entry.coordinate] = entry.value;
+        }
+        const Table &const_table = table;
+
+        int element_count = const_table.getElementCount();
+        long long allocation_count_before = allocation_count;
+        bool are_values_correct = true;
+
+        for (int row_index = 0; row_index < test.height; ++row_index) {
+            auto row = *(const_table.flatten().begin() + row_index);
+            for (int column_index = 0; column_index < test.width; ++column_index) {
+                const std::string *value_pointer = const_table.tryGet(row_index, column_index);
+                bool is_filled = value_map.count({row_index, column_index}) > 0;
+                are_values_correct = are_values_correct
+                    && const_table.contains(row_index, column_index) == is_filled
+                    && (value_pointer != nullptr) == is_filled
+                    && const_table(row_index, column_index) == (is_filled ? *value_pointer : std::string())
+                    && row[column_index] == const_table(row_index, column_index);
+            }
+        }
+
+        return
+            are_values_correct
+            && allocation_count == allocation_count_before
+            && const_table.getElementCount() == element_count;
+
+    }
+};
+
+
+// Table whose layout was chosen by number of cells should equal table filled without it
+class UTAdaptiveStorageEquality : public UnitTester<SparseTableFlattenTest>
 {
-    UTSparseTableFlatten tester("SparseTable::flatten");
+public:
+    UTAdaptiveStorageEquality(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const SparseTableFlattenTest &test) const {
+
+        using Table = SparseTable<std::string, AdaptiveStorage<std::string>>;
+        Table reserved_table(test.height, test.width);
+        reserved_table.reserve(static_cast<int>(test.entries.size()));
+        Table map_table(test.height, test.width);
+        for (const auto &entry : test.entries) {
+            reserved_table(entry.coordinate) = entry.value;
+            map_table(entry.coordinate) = entry.value;
+        }
+        Table copied_table(reserved_table);
+
+        return reserved_table == map_table && map_table == reserved_table && copied_table == reserved_table;
+
+    }
+};
+
+
+struct AdaptiveStorageLayoutTest
+{
+    int height;
+    int width;
+    int element_count;
+    bool is_chunked;
+};
+
+
+// Chunks should be chosen only if they take less memory than map of the same cells
+class UTAdaptiveStorageLayout : public UnitTester<AdaptiveStorageLayoutTest>
+{
+public:
+    UTAdaptiveStorageLayout(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const AdaptiveStorageLayoutTest &test) const {
+
+        AdaptiveStorage<std::string> storage;
+        storage.reserve(test.height, test.width, test.element_count);
+        return storage.isChunked() == test.is_chunked;
+
+    }
+};
 
+
+template <typename Tester>
+void runStorageTests(Tester &tester) {
     tester.runTest("One cell", {
         1, 1, {
             {{0, 0}, "A"},
@@ -87,5 +243,72 @@ int main()
         5, 2, {}
     });
 
+    tester.runTest("Cells on chunk borders", {
+        40, 70, {
+            {{15, 31}, "A"},
+            {{16, 32}, "B"},
+            {{15, 32}, "C"},
+            {{16, 31}, "D"},
+            {{0, 69}, "E"},
+            {{39, 0}, "F"},
+            {{0, 0}, "G"},
+        }
+    });
+    tester.runTest("Sparse cells far from each other", {
+        1000, 300, {
+            {{999, 299}, "Last"},
+            {{500, 3}, "Middle"},
+            {{2, 250}, "Top right"},
+            {{2, 1}, "Top left"},
+        }
+    });
+}
+
+
+int main()
+{
+    UTSparseTableFlatten<SparseTable<std::string, ChunkedStorage<std::string>>> chunked_flatten_tester("SparseTable::flatten with ChunkedStorage");
+    runStorageTests(chunked_flatten_tester);
+
+    UTSparseTableFlatten<SparseTable<std::string, MapStorage<std::string>>> map_flatten_tester("SparseTable::flatten with MapStorage");
+    runStorageTests(map_flatten_tester);
+
+    UTSparseTableElements<SparseTable<std::string, ChunkedStorage<std::string>>> chunked_elements_tester("SparseTable::getElements with ChunkedStorage");
+    runStorageTests(chunked_elements_tester);
+
+    UTSparseTableElements<SparseTable<std::string, MapStorage<std::string>>> map_elements_tester("SparseTable::getElements with MapStorage");
+    runStorageTests(map_elements_tester);
+
+    UTSparseTableConstLookup<SparseTable<std::string, ChunkedStorage<std::string>>> chunked_lookup_tester("SparseTable const lookup with ChunkedStorage");
+    runStorageTests(chunked_lookup_tester);
+
+    UTSparseTableConstLookup<SparseTable<std::string, MapStorage<std::string>>> map_lookup_tester("SparseTable const lookup with MapStorage");
+    runStorageTests(map_lookup_tester);
+
+    UTSparseTableFlatten<SparseTable<std::string, HashStorage<std::string>>> hash_flatten_tester("SparseTable::flatten with HashStorage");
+    runStorageTests(hash_flatten_tester);
+
+    UTSparseTableElements<SparseTable<std::string, HashStorage<std::string>>> hash_elements_tester("SparseTable::getElements with HashStorage");
+    runStorageTests(hash_elements_tester);
+
+    UTSparseTableFlatten<SparseTable<std::string, AdaptiveStorage<std::string>>> adaptive_flatten_tester("SparseTable::flatten with AdaptiveStorage");
+    runStorageTests(adaptive_flatten_tester);
+
+    UTSparseTableElements<SparseTable<std::string, AdaptiveStorage<std::string>>> adaptive_elements_tester("SparseTable::getElements with AdaptiveStorage");
+    runStorageTests(adaptive_elements_tester);
+
+    UTSparseTableConstLookup<SparseTable<std::string, AdaptiveStorage<std::string>>> adaptive_lookup_tester("SparseTable const lookup with AdaptiveStorage");
+    runStorageTests(adaptive_lookup_tester);
+
+    UTAdaptiveStorageEquality adaptive_equality_tester("AdaptiveStorage of different layouts");
+    runStorageTests(adaptive_equality_tester);
+
+    UTAdaptiveStorageLayout layout_tester("AdaptiveStorage layout");
+    layout_tester.runTest("Full table of whole chunks", {1024, 64, 1024 * 64, true});
+    layout_tester.runTest("Full narrow table", {400000, 5, 400000 * 5, false});
+    layout_tester.runTest("Table of whole chunks filled by 1/8", {1024, 64, 1024 * 8, false});
+    layout_tester.runTest("Table of whole chunks filled by 3/4", {1024, 64, 1024 * 48, true});
+    layout_tester.runTest("Empty table", {0, 0, 0, false});
+
     return 0;
 }
@@ -0,0 +1,317 @@
+#include <vector>
+#include <sstream>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <limits>
+#include <cstdio>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "thread_pool.h"
+#include "sheet_generator.h"
+
+
+struct StreamTableTest
+{
+    std::string raw_input;
+    int window_height;
+    int thread_count;
+    // Output is compared only with output of the whole table if it is empty
+    std::string printed_table;
+
+    StreamTableTest(
+        const std::string &raw_input_tmp, int window_height_tmp, int thread_count_tmp = 1,
+        const std::string &printed_table_tmp = ""
+    ) : raw_input(raw_input_tmp), window_height(window_height_tmp), thread_count(thread_count_tmp),
+        printed_table(printed_table_tmp) {}
+};
+
+
+// Writes text into pipe, returns false on error
+bool writeText(int file_descriptor, const std::string &text) {
+    size_t written_size = 0;
+    while (written_size < text.size()) {
+        ssize_t result = write(file_descriptor, text.data() + written_size, text.size() - written_size);
+        if (result <= 0) {
+            return false;
+        }
+        written_size += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+
+std::string makeWholeOutput(const std::string &raw_input) {
+    InputBuffer input(raw_input);
+    ThreadPool thread_pool(1);
+    std::ostringstream whole_output;
+    OutputBuffer output(whole_output);
+    auto table = readParsedTable(input, thread_pool);
+    calculateParsedTable(table, thread_pool);
+    printExpressionTable(table, output);
+    output.flush();
+    return whole_output.str();
+}
+
+
+// Streamed table should be printed the same as the whole table read and calculated at once,
+// both when input is a pipe and when it is a regular file
+class UTStreamParsedTable : public UnitTester<StreamTableTest>
+{
+public:
+    UTStreamParsedTable(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const StreamTableTest &test) const {
+
+        ThreadPool thread_pool(test.thread_count);
+        std::string whole_output = makeWholeOutput(test.raw_input);
+
+        int pipe_descriptors[2];
+        if (pipe(pipe_descriptors) != 0) {
+            return false;
+        }
+        std::thread writer([&test, &pipe_descriptors]() {
+            writeText(pipe_descriptors[1], test.raw_input);
+            close(pipe_descriptors[1]);
+        });
+        std::ostringstream piped_output;
+        {
+            OutputBuffer output(piped_output);
+            streamParsedTable(pipe_descriptors[0], test.window_height, output, thread_pool);
+        }
+        // Rows after the last one of table may be left unread
+        std::vector<char> rest(1 << 16);
+        while (read(pipe_descriptors[0], rest.data(), rest.size()) > 0) {}
+        writer.join();
+        close(pipe_descriptors[0]);
+
+        FILE *input_file = std::tmpfile();
+        std::fwrite(test.raw_input.data(), 1, test.raw_input.size(), input_file);
+        std::fflush(input_file);
+        std::rewind(input_file);
+        std::ostringstream file_output;
+        {
+            OutputBuffer output(file_output);
+            streamParsedTable(fileno(input_file), test.window_height, output, thread_pool);
+        }
+        std::fclose(input_file);
+
+        return
+            piped_output.str() == whole_output && file_output.str() == whole_output
+            && (test.printed_table.empty() || whole_output == test.printed_table);
+
+    }
+};
+
+
+struct StreamBeforeEndTest
+{
+    std::string raw_input;
+    // Input is written up to this position, then its printed rows are awaited
+    size_t first_part_size;
+    int window_height;
+    // Number of rows printed before the rest of input is written
+    int printed_row_count;
+};
+
+
+// Blocks should be printed as soon as rows after them are read, before the end of input
+class UTStreamBeforeEnd : public UnitTester<StreamBeforeEndTest>
+{
+    // Reads output until it has given number of lines, returns false if it does not come in time
+    static bool readLines(int file_descriptor, int line_count, std::string &output) {
+        std::vector<char> chunk(1 << 16);
+        while (std::count(output.begin(), output.end(), '\n') < line_count) {
+            pollfd poll_descriptor{file_descriptor, POLLIN, 0};
+            if (poll(&poll_descriptor, 1, 10000) <= 0) {
+                return false;
+            }
+            ssize_t read_size = read(file_descriptor, chunk.data(), chunk.size());
+            if (read_size <= 0) {
+                return false;
+            }
+            output.append(chunk.data(), static_cast<size_t>(read_size));
+        }
+        return true;
+    }
+public:
+    UTStreamBeforeEnd(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const StreamBeforeEndTest &test) const {
+
+        std::string whole_output = makeWholeOutput(test.raw_input);
+
+        int input_descriptors[2];
+        int output_descriptors[2];
+        if (pipe(input_descriptors) != 0) {
+            return false;
+        }
+        if (pipe(output_descriptors) != 0) {
+            close(input_descriptors[0]);
+            close(input_descriptors[1]);
+            return false;
+        }
+        std::thread streamer([&test, &input_descriptors, &output_descriptors]() {
+            ThreadPool thread_pool(1);
+            {
+                OutputBuffer output(output_descriptors[1]);
+                streamParsedTable(input_descriptors[0], test.window_height, output, thread_pool);
+            }
+            close(output_descriptors[1]);
+        });
+
+        std::string output;
+        bool is_written = writeText(input_descriptors[1], test.raw_input.substr(0, test.first_part_size));
+        bool is_printed_before_end = is_written && readLines(output_descriptors[0], test.printed_row_count, output);
+        is_written = is_written && writeText(input_descriptors[1], test.raw_input.substr(test.first_part_size));
+        close(input_descriptors[1]);
+        readLines(output_descriptors[0], std::numeric_limits<int>::max(), output);
+        streamer.join();
+        close(input_descriptors[0]);
+        close(output_descriptors[0]);
+
+        return is_written && is_printed_before_end && output == whole_output;
+
+    }
+};
+
+
+// Log-like sheet: formulas refer to cells of their own row and at most reference_distance rows above,
+// some of them make cycles inside of rows; every gap_period-th block of rows is empty
+std::string makeLocalSheet(int height, int width, int reference_distance, int gap_period, unsigned seed) {
+    std::mt19937 generator(seed);
+    auto random = [&generator](int count) {
+        return static_cast<int>(generator() % static_cast<unsigned>(count));
+    };
+
+    std::ostringstream sheet_stream;
+    sheet_stream << height << '\t' << width << '\n';
+    for (int row = 0; row < height; ++row) {
+        bool is_gap = (row / 100) % gap_period == gap_period - 1;
+        for (int column = 0; column < width; ++column) {
+            if (column > 0) {
+                sheet_stream << '\t';
+            }
+            int kind = random(10);
+            if (is_gap || kind == 0) {
+                continue;
+            } else if (kind <= 3) {
+                sheet_stream << random(1000);
+            } else if (kind == 4) {
+                sheet_stream << "'Text";
+            } else if (kind <= 7) {
+                int first_row = std::max(row - random(reference_distance + 1), 0);
+                sheet_stream << "=" << makeCellName(first_row, random(width)) << "+" << makeCellName(row, random(width));
+            } else if (kind == 8) {
+                int first_row = std::max(row - reference_distance, 0);
+                sheet_stream << "=SUM(" << makeCellName(first_row, 0) << ":" << makeCellName(row, random(width)) << ")";
+            } else {
+                // References out of table are errors rather than references
+                sheet_stream << "=" << makeCellName(height + random(10), column) << "*2";
+            }
+        }
+        sheet_stream << '\n';
+    }
+    return sheet_stream.str();
+}
+
+
+int main()
+{
+    UTStreamParsedTable tester("streamParsedTable");
+
+    tester.runTest("Empty table",
+        {"0 0\n", 0, 1, ""}
+    );
+
+    tester.runTest("Formulas refer to the row above",
+        {
+            "3 2\n"
+            "1\t=A1*2\n"
+            "=A1+B1\t=A2+B1\n"
+            "'Text\t=B2+A2\n",
+            1, 1,
+            "1\t2\n"
+            "3\t5\n"
+            "Text\t8\n"
+        }
+    );
+
+    tester.runTest("Cycle inside of row",
+        {
+            "2 3\n"
+            "=B1\t=A1\t=A1+1\n"
+            "=C1\t5\t=B2\n",
+            1, 1,
+            "#Infinite cycle in references\t#Infinite cycle in references\t#Error in referred cell\n"
+            "#Error in referred cell\t5\t5\n"
+        }
+    );
+
+    tester.runTest("Reference to the row below",
+        {
+            "3 1\n"
+            "1\n"
+            "=A3+A1\n"
+            "7\n",
+            2, 1,
+            "1\n"
+            "8\n"
+            "7\n"
+        }
+    );
+
+    tester.runTest("Reference beyond window",
+        {
+            "4 1\n"
+            "1\n"
+            "2\n"
+            "3\n"
+            "=SUM(A1:A3)\n",
+            1, 1,
+            "1\n"
+            "2\n"
+            "3\n"
+            "6\n"
+        }
+    );
+
+    tester.runTest("Truncated input",
+        {"4 2\n=5\t'Text\n", 0, 1, "5\tText\n\t\n\t\n\t\n"}
+    );
+
+    const std::string local_sheet = makeLocalSheet(5000, 6, 8, 7, 42);
+    tester.runTest("Several blocks of local formulas", {local_sheet, 8, 1});
+    tester.runTest("Several blocks of local formulas on 4 threads", {local_sheet, 8, 4});
+    // The last row refers to the whole first column, so rows before its block are streamed already
+    std::string exceeding_sheet = makeLocalSheet(5000, 6, 3, 3, 7);
+    exceeding_sheet.replace(0, exceeding_sheet.find('\t'), "5001");
+    exceeding_sheet += "=SUM(A1:A5000)\n";
+    tester.runTest("Window exceeded after several blocks", {exceeding_sheet, 3, 1});
+    tester.runTest("Window larger than block", {makeLocalSheet(3000, 4, 1500, 5, 11), 1500, 2});
+    tester.runTest("Formulas refer to random cells", {generateRawSheet(2000, 20), 10, 1});
+    tester.runTest("Header without rows", {"3 2", 0, 1, "\t\n\t\n\t\n"});
+    tester.runTest("Rows with CR line endings", {"3 2\r1\t=A1*2\r\r\n=B1\t'Text\r", 1, 1});
+
+    UTStreamBeforeEnd before_end_tester("streamParsedTable before the end of input");
+
+    // The first block is followed by a part of the next one
+    const std::string before_end_sheet = makeLocalSheet(3000, 2, 4, 5, 3);
+    size_t first_part_size = 0;
+    for (int line_index = 0; line_index <= 1500; ++line_index) {
+        first_part_size = before_end_sheet.find('\n', first_part_size) + 1;
+    }
+    before_end_tester.runTest("Blocks of local formulas", {before_end_sheet, first_part_size, 4, 1024});
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <vector>
+#include <string>
+#include <thread>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "utils.h"
+#include "string_pool.h"
+
+
+struct StringPoolTest
+{
+    std::vector<std::string> strings;
+    int thread_count;
+
+    StringPoolTest(const std::vector<std::string> &strings_tmp, int thread_count_tmp = 1)
+        : strings(strings_tmp), thread_count(thread_count_tmp) {}
+};
+
+
+// Every thread interns all strings; handles should be equal exactly for equal strings
+class UTStringPool : public UnitTester<StringPoolTest>
+{
+public:
+    UTStringPool(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const StringPoolTest &test) const {
+
+        std::vector<std::vector<InternedString>> handles(static_cast<size_t>(test.thread_count));
+        std::vector<std::thread> threads;
+        for (int thread_index = 0; thread_index < test.thread_count; ++thread_index) {
+            threads.emplace_back([&test, &handles, thread_index]() {
+                for (const auto &string : test.strings) {
+                    handles[static_cast<size_t>(thread_index)].emplace_back(string);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        for (const auto &thread_handles : handles) {
+            for (size_t first_index = 0; first_index < test.strings.size(); ++first_index) {
+                if (!(thread_handles[first_index].get() == test.strings[first_index])) {
+                    return false;
+                }
+                for (size_t second_index = 0; second_index < test.strings.size(); ++second_index) {
+                    bool are_strings_equal = (test.strings[first_index] == test.strings[second_index]);
+                    bool are_handles_equal = (thread_handles[first_index] == handles[0][second_index]);
+                    if (are_strings_equal != are_handles_equal) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+
+    }
+};
+
+
+int main()
+{
+    UTStringPool tester("StringPool");
+
+    tester.runTest("Distinct strings",
+        {{"One", "Two", "Three", "#Error in referred cell"}}
+    );
+    tester.runTest("Repeated strings",
+        {{"Label", "Label", "Other label", "Label", "Other label"}}
+    );
+    tester.runTest("Empty strings",
+        {{"", "Text", "", " "}}
+    );
+    tester.runTest("Strings with zero characters",
+        {{std::string("a\0b", 3), std::string("a\0c", 3), "a"}}
+    );
+    tester.runTest("Strings longer than pool block",
+        {{std::string(100000, 'x'), std::string(100000, 'x'), std::string(20000, 'y'), "x"}}
+    );
+
+    std::vector<std::string> labels;
+    for (int label_index = 0; label_index < 2000; ++label_index) {
+        labels.push_back("Label of row " + std::to_string(label_index % 300));
+    }
+    tester.runTest("Concurrently interned labels",
+        {labels, 4}
+    );
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include <vector>
+#include <string>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "coordinate.h"
+#include "expression.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "value_cache.h"
+
+
+using ExpressionTableEntry = ExpressionTable::Entry;
+
+
+struct ValueCacheTest
+{
+    int height;
+    int width;
+    std::vector<ExpressionTableEntry> entries;
+    // Cells set after construction, they should be filled in entries
+    std::vector<ExpressionTableEntry> set_entries;
+    // Columns which are cached, empty for all columns
+    std::vector<bool> is_column_cached;
+
+    ValueCacheTest(
+        int height_tmp, int width_tmp,
+        const std::vector<ExpressionTableEntry> &entries_tmp,
+        const std::vector<ExpressionTableEntry> &set_entries_tmp = {},
+        const std::vector<bool> &is_column_cached_tmp = {}
+    ) : height(height_tmp), width(width_tmp), entries(entries_tmp), set_entries(set_entries_tmp),
+        is_column_cached(is_column_cached_tmp) {}
+};
+
+
+// Every cell of cache is compared with expression of table, both by lookup and by copied columns;
+// cells of columns which are not cached should be empty
+class UTValueCache : public UnitTester<ValueCacheTest>
+{
+    static ValueState getExpectedState(const Expression &expression) {
+        switch (expression.getType()) {
+        case ExpressionType::NONE:
+            return ValueState::EMPTY;
+        case ExpressionType::TEXT:
+            return ValueState::TEXT;
+        case ExpressionType::ERROR:
+            return ValueState::ERROR;
+        case ExpressionType::ARITHMETIC:
+            return (expression.isNumber() ? ValueState::NUMBER : ValueState::PENDING);
+        }
+        return ValueState::ERROR;
+    }
+
+    static bool isSameValue(const ValueCache &values, const ExpressionTable &table, const std::vector<bool> &is_column_cached) {
+        for (int column = 0; column < table.getWidth(); ++column) {
+            bool is_cached = is_column_cached[static_cast<size_t>(column)];
+            int first_row = 0;
+            int row_count = 0;
+            const ValueState *dense_states = nullptr;
+            const Number *dense_numbers = nullptr;
+            if (!is_cached && values.tryGetDenseColumn(column, first_row, row_count, dense_states, dense_numbers)) {
+                return false;
+            }
+            // Column is copied both whole and without its first and last rows
+            std::vector<ValueState> states(static_cast<size_t>(table.getHeight()));
+            std::vector<Number> numbers(static_cast<size_t>(table.getHeight()));
+            values.copyColumn(column, 0, table.getHeight(), states.data(), numbers.data());
+            std::vector<ValueState> inner_states(states.size());
+            std::vector<Number> inner_numbers(numbers.size());
+            if (table.getHeight() > 2) {
+                values.copyColumn(column, 1, table.getHeight() - 1, inner_states.data() + 1, inner_numbers.data() + 1);
+            }
+
+            for (int row = 0; row < table.getHeight(); ++row) {
+                const Expression &expression = (is_cached ? table(row, column) : Expression());
+                ValueState state = getExpectedState(expression);
+                Number number = (state == ValueState::NUMBER ? expression.getNumber() : 0);
+                Result<Number> value = values.tryGetNumber({row, column});
+                Result<Number> expected_value = tryGetProcessedArithmeticExpressionValue(expression);
+                if (state == ValueState::EMPTY) {
+                    expected_value = Error(ErrorCode::NOT_A_NUMBER_IN_REFERRED_CELL);
+                }
+                bool is_inner = (0 < row && row + 1 < table.getHeight());
+                if (
+                    values.getState({row, column}) != state || value.isOk() != expected_value.isOk()
+                    || (value.isOk() && value.getValue() != expected_value.getValue())
+                    || (!value.isOk() && value.getError().code != expected_value.getError().code)
+                    || states[static_cast<size_t>(row)] != state || numbers[static_cast<size_t>(row)] != number
+                    || (is_inner && (inner_states[static_cast<size_t>(row)] != state || inner_numbers[static_cast<size_t>(row)] != number))
+                ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    UTValueCache(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const ValueCacheTest &test) const {
+
+        auto table = makeSparseTable(test.height, test.width, test.entries.begin(), test.entries.end());
+        std::vector<bool> is_column_cached = test.is_column_cached;
+        if (is_column_cached.empty()) {
+            is_column_cached.assign(static_cast<size_t>(test.width), true);
+        }
+        ValueCache values(table, is_column_cached);
+        if (values.getHeight() != test.height || values.getWidth() != test.width || !isSameValue(values, table, is_column_cached)) {
+            return false;
+        }
+
+        for (const auto &entry : test.set_entries) {
+            table(entry.coordinate) = entry.value;
+            values.set(entry.coordinate, entry.value);
+        }
+        return isSameValue(values, table, is_column_cached);
+
+    }
+};
+
+
+int main()
+{
+    UTValueCache tester("ValueCache");
+
+    tester.runTest("Empty table", {3, 2, {}});
+
+    tester.runTest("Cells of every kind",
+        {
+            2, 3,
+            {
+                {{0, 0}, parseExpression("5")},
+                {{0, 1}, parseExpression("'Text")},
+                {{0, 2}, parseExpression("=A1+1")},
+                {{1, 0}, makeErrorExpression(ErrorCode::DIVISION_BY_ZERO)},
+                {{1, 2}, parseExpression("12345678901")},
+            }
+        }
+    );
+
+    tester.runTest("Column starting below first row",
+        {
+            6, 1,
+            {
+                {{2, 0}, parseExpression("1")},
+                {{3, 0}, parseExpression("2")},
+                {{4, 0}, parseExpression("=A3+A4")},
+            }
+        }
+    );
+
+    tester.runTest("Sparse column",
+        {
+            1000, 2,
+            {
+                {{0, 0}, parseExpression("1")},
+                {{500, 0}, parseExpression("=A1*2")},
+                {{999, 0}, parseExpression("'Last")},
+                {{7, 1}, parseExpression("3")},
+            }, {
+                {{500, 0}, parseExpression("2")},
+            }
+        }
+    );
+
+    tester.runTest("Calculated cells are set",
+        {
+            4, 2,
+            {
+                {{0, 0}, parseExpression("=1+2")},
+                {{1, 0}, parseExpression("=A1*A1")},
+                {{2, 1}, parseExpression("=A5")},
+                {{3, 1}, parseExpression("=B3")},
+            }, {
+                {{0, 0}, parseExpression("3")},
+                {{1, 0}, parseExpression("9")},
+                {{2, 1}, makeErrorExpression(ErrorCode::INFINITE_CYCLE)},
+                {{3, 1}, makeErrorExpression(ErrorCode::ERROR_IN_REFERRED_CELL)},
+            }
+        }
+    );
+
+    tester.runTest("Columns which are not cached",
+        {
+            3, 3,
+            {
+                {{0, 0}, parseExpression("1")},
+                {{1, 0}, parseExpression("=A1*2")},
+                {{0, 1}, parseExpression("'Text")},
+                {{2, 1}, parseExpression("=A2+1")},
+                {{1, 2}, parseExpression("7")},
+            }, {
+                {{1, 0}, parseExpression("2")},
+                {{2, 1}, parseExpression("3")},
+            }, {
+                true, false, true,
+            }
+        }
+    );
+
+    return 0;
+}
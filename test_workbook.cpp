@@ -0,0 +1,243 @@
+#include <vector>
+#include <string>
+
+#include "unit_test.h"
+#include "unit_test.cpp"
+#include "coordinate.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "expression_table.h"
+#include "workbook.h"
+
+
+using TextTableEntry = SparseTable<std::string>::Entry;
+
+
+struct WorkbookTest
+{
+    int height;
+    int width;
+    std::vector<TextTableEntry> initial_entries;
+    std::vector<TextTableEntry> edits;
+    // Number of cells recalculated by the last edit
+    int recalculated_count;
+
+    WorkbookTest(
+        int height_tmp, int width_tmp,
+        const std::vector<TextTableEntry> &initial_entries_tmp,
+        const std::vector<TextTableEntry> &edits_tmp,
+        int recalculated_count_tmp
+    ) : height(height_tmp), width(width_tmp), initial_entries(initial_entries_tmp), edits(edits_tmp),
+        recalculated_count(recalculated_count_tmp) {}
+};
+
+
+// Values of workbook after edits should be the same as values of edited table calculated from scratch
+class UTWorkbook : public UnitTester<WorkbookTest>
+{
+public:
+    UTWorkbook(const std::string &plan_name) : UnitTester(plan_name) {}
+
+    bool checkTest(const WorkbookTest &test) const {
+
+        auto raw_table = makeSparseTable(test.height, test.width, test.initial_entries.begin(), test.initial_entries.end());
+        Workbook workbook(parseRawTable(raw_table));
+
+        int recalculated_count = 0;
+        for (const auto &edit : test.edits) {
+            recalculated_count = workbook.setCell(edit.coordinate, edit.value);
+            raw_table(edit.coordinate) = edit.value;
+        }
+
+        auto expected_table = parseRawTable(raw_table);
+        calculateParsedTable(expected_table);
+
+        return
+            makePrintedTable(workbook.getValues()) == makePrintedTable(expected_table)
+            && recalculated_count == test.recalculated_count;
+
+    }
+};
+
+
+int main()
+{
+    UTWorkbook tester("Workbook");
+
+    tester.runTest("Edit number referred by chain",
+        {
+            3, 1,
+            {
+                {{0, 0}, "1"},
+                {{1, 0}, "=A1+1"},
+                {{2, 0}, "=A2*2"},
+            }, {
+                {{0, 0}, "5"},
+            },
+            3
+        }
+    );
+
+    tester.runTest("Edit cell without dependents",
+        {
+            2, 2,
+            {
+                {{0, 0}, "1"},
+                {{0, 1}, "=A1+1"},
+                {{1, 0}, "=A1*2"},
+                {{1, 1}, "7"},
+            }, {
+                {{1, 1}, "=B1+A2"},
+            },
+            1
+        }
+    );
+
+    tester.runTest("Change references of formula",
+        {
+            2, 2,
+            {
+                {{0, 0}, "1"},
+                {{0, 1}, "2"},
+                {{1, 0}, "=A1"},
+            }, {
+                {{1, 0}, "=B1"},
+                {{0, 0}, "10"},
+            },
+            1
+        }
+    );
+
+    tester.runTest("Replace formula by text",
+        {
+            2, 2,
+            {
+                {{0, 0}, "=3"},
+                {{0, 1}, "=A1+1"},
+                {{1, 1}, "=B1+1"},
+            }, {
+                {{0, 0}, "'Text"},
+            },
+            3
+        }
+    );
+
+    tester.runTest("Fill and clear cell",
+        {
+            2, 2,
+            {
+                {{0, 1}, "=A1+1"},
+            }, {
+                {{0, 0}, "4"},
+                {{0, 0}, ""},
+            },
+            2
+        }
+    );
+
+    tester.runTest("Make and break cycle",
+        {
+            3, 1,
+            {
+                {{0, 0}, "=A2"},
+                {{1, 0}, "1"},
+                {{2, 0}, "=A1+1"},
+            }, {
+                {{1, 0}, "=A1"},
+                {{1, 0}, "2"},
+            },
+            3
+        }
+    );
+
+    tester.runTest("Cycle through edited cell",
+        {
+            3, 1,
+            {
+                {{0, 0}, "=A2"},
+                {{1, 0}, "1"},
+                {{2, 0}, "=A1+1"},
+            }, {
+                {{1, 0}, "=A3"},
+            },
+            3
+        }
+    );
+
+    tester.runTest("References out of range",
+        {
+            1, 2,
+            {
+                {{0, 0}, "=Z9"},
+            }, {
+                {{0, 1}, "=A1+Z8"},
+            },
+            1
+        }
+    );
+
+    tester.runTest("Repeated references",
+        {
+            2, 1,
+            {
+                {{0, 0}, "3"},
+                {{1, 0}, "=A1*A1"},
+            }, {
+                {{1, 0}, "=A1+A1+A1"},
+                {{1, 0}, "=A1"},
+                {{0, 0}, "4"},
+            },
+            2
+        }
+    );
+
+    tester.runTest("Edit cell in range of aggregate",
+        {
+            4, 2,
+            {
+                {{0, 0}, "1"},
+                {{1, 0}, "2"},
+                {{2, 0}, "=A1+A2"},
+                {{0, 1}, "=SUM(A1:A4)"},
+                {{1, 1}, "=MAX(A1:A3)*B1"},
+            }, {
+                {{3, 0}, "10"},
+                {{1, 0}, "7"},
+            },
+            4
+        }
+    );
+
+    tester.runTest("Replace aggregate by other range",
+        {
+            3, 2,
+            {
+                {{0, 0}, "1"},
+                {{1, 0}, "2"},
+                {{2, 0}, "3"},
+                {{0, 1}, "=COUNT(A1:A2)"},
+            }, {
+                {{0, 1}, "=AVG(A2:A3)"},
+                {{0, 0}, "100"},
+                {{2, 0}, "5"},
+            },
+            2
+        }
+    );
+
+    tester.runTest("Cycle through range",
+        {
+            3, 1,
+            {
+                {{0, 0}, "1"},
+                {{1, 0}, "2"},
+            }, {
+                {{2, 0}, "=SUM(A1:A3)"},
+                {{0, 0}, "=A3"},
+            },
+            2
+        }
+    );
+
+    return 0;
+}
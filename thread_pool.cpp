@@ -0,0 +1,92 @@
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool(int thread_count) : running_task_count(0), is_stopping(false) {
+    for (int worker_index = 1; worker_index < thread_count; ++worker_index) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_stopping = true;
+    }
+    task_condition.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+
+int ThreadPool::getThreadCount() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+
+bool ThreadPool::runQueuedTask(std::unique_lock<std::mutex> &lock) {
+    if (tasks.empty()) {
+        return false;
+    }
+
+    auto task = std::move(tasks.front());
+    tasks.pop_front();
+    ++running_task_count;
+
+    lock.unlock();
+    task();
+    lock.lock();
+
+    if (--running_task_count == 0 && tasks.empty()) {
+        done_condition.notify_all();
+    }
+    return true;
+}
+
+
+void ThreadPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        task_condition.wait(lock, [this]() { return is_stopping || !tasks.empty(); });
+        if (is_stopping) {
+            return;
+        }
+        runQueuedTask(lock);
+    }
+}
+
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)> &action) {
+    // Small ranges are not worth waking workers up
+    const int min_block_size = 64;
+    if (workers.empty() || end - begin <= min_block_size) {
+        if (begin < end) {
+            action(begin, end);
+        }
+        return;
+    }
+
+    int block_count = std::min(getThreadCount() * 4, (end - begin + min_block_size - 1) / min_block_size);
+    int block_size = (end - begin + block_count - 1) / block_count;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int block_begin = begin; block_begin < end; block_begin += block_size) {
+        int block_end = std::min(end, block_begin + block_size);
+        tasks.emplace_back([&action, block_begin, block_end]() {
+            action(block_begin, block_end);
+        });
+    }
+    task_condition.notify_all();
+
+    while (runQueuedTask(lock)) {}
+    done_condition.wait(lock, [this]() { return running_task_count == 0 && tasks.empty(); });
+}
@@ -0,0 +1,40 @@
+#ifndef THREAD_POOL_H_INCLUDED
+#define THREAD_POOL_H_INCLUDED
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+// Fixed set of worker threads; the calling thread also takes part in parallelFor
+class ThreadPool
+{
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable task_condition;
+    std::condition_variable done_condition;
+    std::deque<std::function<void()>> tasks;
+    int running_task_count;
+    bool is_stopping;
+
+    void work();
+    // Runs one queued task, returns false if queue is empty
+    bool runQueuedTask(std::unique_lock<std::mutex> &lock);
+public:
+    explicit ThreadPool(int thread_count = 1);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    int getThreadCount() const;
+
+    // Splits [begin, end) into blocks, calls action(block_begin, block_end) for them concurrently
+    // and waits until all blocks are processed. Should be called from one thread at a time
+    void parallelFor(int begin, int end, const std::function<void(int, int)> &action);
+};
+
+
+#endif // THREAD_POOL_H_INCLUDED
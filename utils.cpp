@@ -1,10 +1,16 @@
 #include <string>
 #include <istream>
+#include <ostream>
 #include <cstdio>
 
 #include "utils.h"
 
 
+std::ostream &operator<<(std::ostream &out_stream, const StringRef &string) {
+    return out_stream.write(string.begin(), static_cast<std::streamsize>(string.getSize()));
+}
+
+
 std::string makeErrorMessage(const std::string &error_message) {
     return "#" + error_message;
 }
@@ -2,6 +2,9 @@
 #define UTILS_H_INCLUDED
 
 #include <string>
+#include <cstring>
+#include <algorithm>
+#include <iosfwd>
 
 
 template <typename Iterator>
@@ -22,6 +25,53 @@ public:
 };
 
 
+// Non-owning view of characters of string or input buffer, like std::string_view of C++17
+class StringRef
+{
+    const char *data;
+    size_t size;
+public:
+    StringRef() : data(nullptr), size(0) {}
+    StringRef(const char *begin_tmp, const char *end_tmp) : data(begin_tmp), size(static_cast<size_t>(end_tmp - begin_tmp)) {}
+    StringRef(const char *c_string) : data(c_string), size(std::strlen(c_string)) {}
+    StringRef(const std::string &string) : data(string.data()), size(string.size()) {}
+
+    const char *begin() const {
+        return data;
+    }
+
+    const char *end() const {
+        return data + size;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+
+    bool empty() const {
+        return size == 0;
+    }
+
+    char operator[](size_t index) const {
+        return data[index];
+    }
+
+    StringRef substr(size_t position) const {
+        return {data + position, data + size};
+    }
+
+    std::string toString() const {
+        return {data, size};
+    }
+
+    bool operator==(const StringRef &other) const {
+        return size == other.size && std::equal(begin(), end(), other.begin());
+    }
+};
+
+std::ostream &operator<<(std::ostream &out_stream, const StringRef &string);
+
+
 std::string makeErrorMessage(const std::string &error_message);
 
 std::istream& getline(std::istream& input_stream, std::string& string);
@@ -0,0 +1,178 @@
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "coordinate.h"
+#include "number.h"
+#include "result.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "value_cache.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+
+
+// Column is kept as arrays if at least this part of rows of its span is filled
+const int DENSE_COLUMN_FILL_RATIO = 4;
+
+
+ValueState getValueState(const Expression &expression) {
+    switch (expression.getType()) {
+    case ExpressionType::NONE:
+        return ValueState::EMPTY;
+    case ExpressionType::TEXT:
+        return ValueState::TEXT;
+    case ExpressionType::ERROR:
+        return ValueState::ERROR;
+    case ExpressionType::ARITHMETIC:
+        return (expression.isNumber() ? ValueState::NUMBER : ValueState::PENDING);
+    }
+    return ValueState::ERROR;
+}
+
+
+ValueCache::Column::Column() : is_cached(true), is_dense(true), first_row(0) {}
+
+
+ValueCache::ValueCache(int height_tmp, int width_tmp)
+    : height(height_tmp), width(width_tmp), columns(static_cast<size_t>(width_tmp)) {}
+
+
+ValueCache::ValueCache(const ExpressionTable &table)
+    : ValueCache(table, std::vector<bool>(static_cast<size_t>(table.getWidth()), true)) {}
+
+
+ValueCache::ValueCache(const ExpressionTable &table, const std::vector<bool> &is_column_cached)
+    : ValueCache(table.getHeight(), table.getWidth()) {
+    for (size_t column_index = 0; column_index < columns.size(); ++column_index) {
+        columns[column_index].is_cached = is_column_cached[column_index];
+    }
+
+    // Spans and counts of cells of columns are found first, so arrays are allocated once
+    std::vector<int> last_rows(static_cast<size_t>(width), -1);
+    std::vector<int> cell_counts(static_cast<size_t>(width), 0);
+    for (const auto &cell_pair : table.getElements()) {
+        const auto &coordinate = cell_pair.first;
+        if (!is_column_cached[static_cast<size_t>(coordinate.column)]) {
+            continue;
+        }
+        if (last_rows[static_cast<size_t>(coordinate.column)] == -1) {
+            columns[static_cast<size_t>(coordinate.column)].first_row = coordinate.row;
+        }
+        last_rows[static_cast<size_t>(coordinate.column)] = coordinate.row;
+        ++cell_counts[static_cast<size_t>(coordinate.column)];
+    }
+
+    size_t sparse_cell_count = 0;
+    for (int column_index = 0; column_index < width; ++column_index) {
+        auto &column = columns[static_cast<size_t>(column_index)];
+        if (last_rows[static_cast<size_t>(column_index)] == -1) {
+            continue;
+        }
+        int span = last_rows[static_cast<size_t>(column_index)] - column.first_row + 1;
+        if (span / DENSE_COLUMN_FILL_RATIO > cell_counts[static_cast<size_t>(column_index)]) {
+            column.is_dense = false;
+            sparse_cell_count += static_cast<size_t>(cell_counts[static_cast<size_t>(column_index)]);
+        } else {
+            column.states.assign(static_cast<size_t>(span), ValueState::EMPTY);
+            column.numbers.assign(static_cast<size_t>(span), 0);
+        }
+    }
+    sparse_values.reserve(sparse_cell_count);
+
+    for (const auto &cell_pair : table.getElements()) {
+        const auto &coordinate = cell_pair.first;
+        const auto &expression = cell_pair.second;
+        auto &column = columns[static_cast<size_t>(coordinate.column)];
+        if (!column.is_cached) {
+            continue;
+        }
+        CachedValue value{getValueState(expression), 0};
+        if (value.state == ValueState::NUMBER) {
+            value.number = expression.getNumber();
+        }
+        if (column.is_dense) {
+            column.states[static_cast<size_t>(coordinate.row - column.first_row)] = value.state;
+            column.numbers[static_cast<size_t>(coordinate.row - column.first_row)] = value.number;
+        } else {
+            sparse_values.insert(coordinate, value);
+        }
+    }
+}
+
+
+int ValueCache::getHeight() const {
+    return height;
+}
+
+int ValueCache::getWidth() const {
+    return width;
+}
+
+bool ValueCache::isInRange(const Coordinate2D &coordinate) const {
+    return 0 <= coordinate.row && coordinate.row < height && 0 <= coordinate.column && coordinate.column < width;
+}
+
+
+void ValueCache::copyColumn(int column_index, int begin_row, int end_row, ValueState *states, Number *numbers) const {
+    const auto &column = columns[static_cast<size_t>(column_index)];
+    if (!column.is_dense) {
+        for (int row = begin_row; row < end_row; ++row) {
+            CachedValue value = get({row, column_index});
+            states[row - begin_row] = value.state;
+            numbers[row - begin_row] = value.number;
+        }
+        return;
+    }
+
+    // Rows outside of span of column are empty
+    int stored_end_row = column.first_row + static_cast<int>(column.states.size());
+    int copy_begin_row = std::min(std::max(begin_row, column.first_row), end_row);
+    int copy_end_row = std::max(std::min(end_row, stored_end_row), copy_begin_row);
+    std::fill(states, states + (copy_begin_row - begin_row), ValueState::EMPTY);
+    std::fill(numbers, numbers + (copy_begin_row - begin_row), 0);
+    std::copy(
+        column.states.begin() + (copy_begin_row - column.first_row), column.states.begin() + (copy_end_row - column.first_row),
+        states + (copy_begin_row - begin_row)
+    );
+    std::copy(
+        column.numbers.begin() + (copy_begin_row - column.first_row), column.numbers.begin() + (copy_end_row - column.first_row),
+        numbers + (copy_begin_row - begin_row)
+    );
+    std::fill(states + (copy_end_row - begin_row), states + (end_row - begin_row), ValueState::EMPTY);
+    std::fill(numbers + (copy_end_row - begin_row), numbers + (end_row - begin_row), 0);
+}
+
+
+bool ValueCache::tryGetDenseColumn(
+    int column_index, int &first_row, int &row_count, const ValueState *&states, const Number *&numbers
+) const {
+    const auto &column = columns[static_cast<size_t>(column_index)];
+    if (!column.is_cached || !column.is_dense) {
+        return false;
+    }
+    first_row = column.first_row;
+    row_count = static_cast<int>(column.states.size());
+    states = column.states.data();
+    numbers = column.numbers.data();
+    return true;
+}
+
+
+void ValueCache::set(const Coordinate2D &coordinate, const Expression &expression) {
+    auto &column = columns[static_cast<size_t>(coordinate.column)];
+    if (!column.is_cached) {
+        return;
+    }
+    CachedValue value{getValueState(expression), 0};
+    if (value.state == ValueState::NUMBER) {
+        value.number = expression.getNumber();
+    }
+    if (column.is_dense) {
+        column.states[static_cast<size_t>(coordinate.row - column.first_row)] = value.state;
+        column.numbers[static_cast<size_t>(coordinate.row - column.first_row)] = value.number;
+    } else {
+        // Lookup without insertion, so cells may be set concurrently
+        *sparse_values.find(coordinate) = value;
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef VALUE_CACHE_H_INCLUDED
+#define VALUE_CACHE_H_INCLUDED
+
+#include <vector>
+#include <cstdint>
+
+#include "coordinate.h"
+#include "flat_hash_map.h"
+#include "number.h"
+#include "result.h"
+#include "expression.h"
+#include "expression_table.h"
+
+
+// Kind of value of cell, the only thing stored for cells other than numbers
+enum class ValueState : uint8_t {
+    EMPTY,
+    NUMBER,
+    TEXT,
+    ERROR,
+    // Formula which is not calculated yet
+    PENDING
+};
+
+
+// Index of values of cells which formulas of table being calculated refer to, stored by columns: column keeps
+// contiguous arrays of states and numbers of rows from its first to its last filled cell, so value of cell is
+// found by indexing and rows of column are scanned as plain arrays. Cells of columns filled too sparsely are
+// kept in hash map instead, and columns no formula refers to are not kept at all.
+// Cache lives only while table is calculated: results are written into table, which printer, Workbook and
+// snapshots read, and text and errors themselves stay in expressions, only their states are cached.
+// So cache speeds up references and aggregates at the cost of 9 bytes per cell of referred columns,
+// rather than saving memory of results.
+// Cells filled at construction may be set concurrently, other cells are never filled
+class ValueCache
+{
+    struct CachedValue
+    {
+        ValueState state;
+        Number number;
+    };
+
+    struct Column
+    {
+        // Cells of column which is not cached are read as EMPTY and are never set
+        bool is_cached;
+        bool is_dense;
+        // Rows [first_row, first_row + states.size()) of dense column are stored
+        int first_row;
+        std::vector<ValueState> states;
+        std::vector<Number> numbers;
+
+        Column();
+    };
+
+    int height;
+    int width;
+    std::vector<Column> columns;
+    FlatHashMap<CachedValue> sparse_values;
+
+    // Value of cell, EMPTY for cell which is not stored
+    CachedValue get(const Coordinate2D &coordinate) const;
+public:
+    ValueCache(int height_tmp = 0, int width_tmp = 0);
+    // Values of cells of table; arithmetic cells which are not numbers are PENDING
+    explicit ValueCache(const ExpressionTable &table);
+    // Values of cells of columns for which is_column_cached is true
+    ValueCache(const ExpressionTable &table, const std::vector<bool> &is_column_cached);
+
+    int getHeight() const;
+    int getWidth() const;
+    bool isInRange(const Coordinate2D &coordinate) const;
+
+    ValueState getState(const Coordinate2D &coordinate) const;
+    // Value of cell referred to by arithmetic expression, errors are the same as of
+    // tryGetProcessedArithmeticExpressionValue for expression of cell
+    Result<Number> tryGetNumber(const Coordinate2D &coordinate) const;
+
+    // Copies states and numbers of rows [begin_row, end_row) of column, numbers of non-number cells are 0
+    void copyColumn(int column, int begin_row, int end_row, ValueState *states, Number *numbers) const;
+    // Arrays of rows [first_row, first_row + row_count) of cached dense column, rows out of them are empty;
+    // returns false for column kept in hash map or not cached
+    bool tryGetDenseColumn(int column, int &first_row, int &row_count, const ValueState *&states, const Number *&numbers) const;
+
+    // Stores value of calculated expression of cell, which should be filled at construction
+    void set(const Coordinate2D &coordinate, const Expression &expression);
+};
+
+
+// Inline, as cells are looked up for every reference of formula
+inline ValueCache::CachedValue ValueCache::get(const Coordinate2D &coordinate) const {
+    const auto &column = columns[static_cast<size_t>(coordinate.column)];
+    if (!column.is_cached) {
+        return {ValueState::EMPTY, 0};
+    }
+    if (column.is_dense) {
+        // Rows before the first one wrap around to indices beyond the last one
+        size_t index = static_cast<unsigned>(coordinate.row - column.first_row);
+        if (index < column.states.size()) {
+            return {column.states[index], column.numbers[index]};
+        }
+        return {ValueState::EMPTY, 0};
+    }
+    const CachedValue *value = sparse_values.find(coordinate);
+    return (value ? *value : CachedValue{ValueState::EMPTY, 0});
+}
+
+inline ValueState ValueCache::getState(const Coordinate2D &coordinate) const {
+    return get(coordinate).state;
+}
+
+inline Result<Number> ValueCache::tryGetNumber(const Coordinate2D &coordinate) const {
+    CachedValue value = get(coordinate);
+    switch (value.state) {
+    case ValueState::NUMBER:
+        return value.number;
+    case ValueState::ERROR:
+        return Error(ErrorCode::ERROR_IN_REFERRED_CELL);
+    case ValueState::PENDING:
+        return Error(ErrorCode::INFINITE_CYCLE);
+    case ValueState::EMPTY:
+    case ValueState::TEXT:
+        break;
+    }
+    return Error(ErrorCode::NOT_A_NUMBER_IN_REFERRED_CELL);
+}
+
+
+#endif // VALUE_CACHE_H_INCLUDED
@@ -0,0 +1,202 @@
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+
+#include "workbook.h"
+#include "dependency_graph.h"
+#include "sparse_table.h"
+#include "sparse_table.cpp"
+#include "flat_hash_map.h"
+#include "expression.h"
+#include "expression_table.h"
+#include "formula_pool.h"
+
+
+Workbook::Workbook(int height, int width)
+    : formulas(height, width, std::make_shared<CellPools>()), values(height, width, formulas.getPools()), dependents(height, width), range_dependents(static_cast<size_t>(width)) {}
+
+
+Workbook::Workbook(const ExpressionTable &formulas_tmp)
+    : formulas(formulas_tmp), values(formulas_tmp), dependents(formulas_tmp.getHeight(), formulas_tmp.getWidth()),
+      range_dependents(static_cast<size_t>(formulas_tmp.getWidth())) {
+    calculateParsedTable(values);
+    for (const auto &cell_pair : formulas.getElements()) {
+        addReferences(cell_pair.first, cell_pair.second);
+    }
+}
+
+
+Workbook::Workbook(const ExpressionTable &formulas_tmp, const ExpressionTable &values_tmp)
+    : formulas(formulas_tmp), values(values_tmp), dependents(formulas_tmp.getHeight(), formulas_tmp.getWidth()),
+      range_dependents(static_cast<size_t>(formulas_tmp.getWidth())) {
+    for (const auto &cell_pair : formulas.getElements()) {
+        addReferences(cell_pair.first, cell_pair.second);
+    }
+}
+
+
+int Workbook::getHeight() const {
+    return formulas.getHeight();
+}
+
+
+int Workbook::getWidth() const {
+    return formulas.getWidth();
+}
+
+
+bool Workbook::isInRange(const Coordinate2D &coordinate) const {
+    return formulas.isInRange(coordinate);
+}
+
+
+void Workbook::addReferences(const Coordinate2D &coordinate, const Expression &formula) {
+    if (formula.getType() != ExpressionType::ARITHMETIC) {
+        return;
+    }
+    for (const auto &token : formula) {
+        // Cells out of range are never changed and ranges out of it are errors, so references to them are not tracked
+        if (token.type == LexemType::CELL_REFERENCE && isInRange(token.coordinate)) {
+            dependents(token.coordinate).push_back(coordinate);
+        } else if (
+            token.type == LexemType::AGGREGATE && isInRange(token.getAggregate().range.first)
+            && isInRange(token.getAggregate().range.last)
+        ) {
+            CellRange range = token.getAggregate().range;
+            int last_column = std::min(range.last.column, getWidth() - 1);
+            for (int column = std::max(range.first.column, 0); column <= last_column; ++column) {
+                range_dependents[static_cast<size_t>(column)].emplace_back(range, coordinate);
+            }
+        }
+    }
+}
+
+
+void Workbook::removeReferences(const Coordinate2D &coordinate, const Expression &formula) {
+    if (formula.getType() != ExpressionType::ARITHMETIC) {
+        return;
+    }
+    for (const auto &token : formula) {
+        if (token.type == LexemType::CELL_REFERENCE && isInRange(token.coordinate)) {
+            auto &cell_dependents = dependents(token.coordinate);
+            cell_dependents.erase(std::find(cell_dependents.begin(), cell_dependents.end(), coordinate));
+        } else if (
+            token.type == LexemType::AGGREGATE && isInRange(token.getAggregate().range.first)
+            && isInRange(token.getAggregate().range.last)
+        ) {
+            CellRange range = token.getAggregate().range;
+            int last_column = std::min(range.last.column, getWidth() - 1);
+            for (int column = std::max(range.first.column, 0); column <= last_column; ++column) {
+                auto &column_dependents = range_dependents[static_cast<size_t>(column)];
+                column_dependents.erase(std::find(
+                    column_dependents.begin(), column_dependents.end(), std::make_pair(range, coordinate)
+                ));
+            }
+        }
+    }
+}
+
+
+std::vector<Coordinate2D> Workbook::collectDirtyCells(const Coordinate2D &coordinate) const {
+    FlatHashMap<bool> is_dirty;
+    is_dirty.insert(coordinate);
+    // Breadth-first search over reverse references, queue receives every dirty cell once
+    std::vector<Coordinate2D> queue{coordinate};
+    for (size_t queue_position = 0; queue_position < queue.size(); ++queue_position) {
+        // Copied, as queue grows while dependents are visited
+        Coordinate2D cell = queue[queue_position];
+        auto visit = [&is_dirty, &queue](const Coordinate2D &dependent) {
+            if (is_dirty.insert(dependent)) {
+                queue.push_back(dependent);
+            }
+        };
+        const auto *cell_dependents = dependents.tryGet(cell);
+        if (cell_dependents) {
+            for (const auto &dependent : *cell_dependents) {
+                visit(dependent);
+            }
+        }
+        for (const auto &range_pair : range_dependents[static_cast<size_t>(cell.column)]) {
+            if (range_pair.first.contains(cell)) {
+                visit(range_pair.second);
+            }
+        }
+    }
+    std::sort(queue.begin(), queue.end());
+    return queue;
+}
+
+
+void Workbook::recalculate(const std::vector<Coordinate2D> &dirty_cells) {
+    // Messages of errors are interned into pools of workbook
+    CellPoolsScope scope(values.getPools());
+    std::vector<Coordinate2D> arithmetic_cells;
+    for (const auto &coordinate : dirty_cells) {
+        const auto &formula = getFormula(coordinate);
+        if (formula.getType() == ExpressionType::ARITHMETIC) {
+            arithmetic_cells.push_back(coordinate);
+        } else {
+            values(coordinate) = formula;
+        }
+    }
+
+    // The same order as in calculateParsedTable, clean cells are considered calculated
+    DependencyGraph graph(arithmetic_cells, formulas);
+    std::vector<bool> is_calculated(static_cast<size_t>(graph.getCellCount()), false);
+
+    auto calculateOrdered = [this, &graph, &is_calculated]() {
+        for (int cell_index : graph.sortTopologically(is_calculated)) {
+            const auto &coordinate = graph.getCoordinate(cell_index);
+            auto value = calculateExpression(getFormula(coordinate), values);
+            values(coordinate) = value;
+            is_calculated[static_cast<size_t>(cell_index)] = true;
+        }
+    };
+
+    calculateOrdered();
+
+    for (int cell_index : graph.findCycleCells(is_calculated)) {
+        values(graph.getCoordinate(cell_index)) = makeErrorExpression(ErrorCode::INFINITE_CYCLE);
+        is_calculated[static_cast<size_t>(cell_index)] = true;
+    }
+    calculateOrdered();
+}
+
+
+int Workbook::setCell(const Coordinate2D &coordinate, const Expression &formula) {
+    auto &current_formula = formulas(coordinate);
+    removeReferences(coordinate, current_formula);
+    current_formula = formula;
+    addReferences(coordinate, current_formula);
+
+    auto dirty_cells = collectDirtyCells(coordinate);
+    recalculate(dirty_cells);
+    return static_cast<int>(dirty_cells.size());
+}
+
+
+int Workbook::setCell(const Coordinate2D &coordinate, const std::string &raw_text) {
+    CellPoolsScope scope(formulas.getPools());
+    return setCell(coordinate, parseExpression(raw_text, coordinate));
+}
+
+
+const Expression &Workbook::getFormula(const Coordinate2D &coordinate) const {
+    return formulas(coordinate);
+}
+
+
+const Expression &Workbook::getValue(const Coordinate2D &coordinate) const {
+    return values(coordinate);
+}
+
+
+const ExpressionTable &Workbook::getFormulas() const {
+    return formulas;
+}
+
+
+const ExpressionTable &Workbook::getValues() const {
+    return values;
+}
@@ -0,0 +1,57 @@
+#ifndef WORKBOOK_H_INCLUDED
+#define WORKBOOK_H_INCLUDED
+
+#include <vector>
+#include <string>
+#include <utility>
+
+#include "coordinate.h"
+#include "sparse_table.h"
+#include "sparse_table_storage.h"
+#include "expression.h"
+#include "expression_table.h"
+
+
+// Table of expressions whose values are kept calculated while cells are edited one by one.
+// Editing cell recalculates only this cell and cells depending on it
+class Workbook
+{
+    ExpressionTable formulas;
+    ExpressionTable values;
+    // Cells referring to given cell, one entry per reference; referred cells are few and scattered,
+    // so they are kept in hash map rather than in dense chunks
+    SparseTable<std::vector<Coordinate2D>, HashStorage<std::vector<Coordinate2D>>> dependents;
+    // Ranges of aggregates covering given column and cells referring to them, one entry per aggregate;
+    // ranges are not spread over dependents, as they may cover many cells
+    std::vector<std::vector<std::pair<CellRange, Coordinate2D>>> range_dependents;
+
+    bool isInRange(const Coordinate2D &coordinate) const;
+    void addReferences(const Coordinate2D &coordinate, const Expression &formula);
+    void removeReferences(const Coordinate2D &coordinate, const Expression &formula);
+
+    // Given cell and all cells depending on it directly or indirectly, in row-major order
+    std::vector<Coordinate2D> collectDirtyCells(const Coordinate2D &coordinate) const;
+    void recalculate(const std::vector<Coordinate2D> &dirty_cells);
+public:
+    Workbook(int height = 0, int width = 0);
+    explicit Workbook(const ExpressionTable &formulas_tmp);
+    // Workbook of already calculated values, e.g. restored from snapshot; nothing is recalculated
+    Workbook(const ExpressionTable &formulas_tmp, const ExpressionTable &values_tmp);
+
+    int getHeight() const;
+    int getWidth() const;
+
+    // Replace formula of cell and recalculate cells depending on it, return number of recalculated cells;
+    // given formula should be interned into pools of formulas of workbook or into pools of the whole run
+    int setCell(const Coordinate2D &coordinate, const Expression &formula);
+    // Text is parsed into pools of formulas of workbook
+    int setCell(const Coordinate2D &coordinate, const std::string &raw_text);
+
+    const Expression &getFormula(const Coordinate2D &coordinate) const;
+    const Expression &getValue(const Coordinate2D &coordinate) const;
+    const ExpressionTable &getFormulas() const;
+    const ExpressionTable &getValues() const;
+};
+
+
+#endif // WORKBOOK_H_INCLUDED